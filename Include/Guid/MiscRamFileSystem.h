@@ -0,0 +1,28 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#ifndef MISC_RAM_FILE_SYSTEM_H_
+#define MISC_RAM_FILE_SYSTEM_H_
+
+// MISC_RAM_FILE_SYSTEM_GUID
+/// The vendor GUID of the device path of RAM file system volumes.
+#define MISC_RAM_FILE_SYSTEM_GUID  \
+  { 0x5C3F0B24, 0x8E41, 0x4D7A, { 0x9B, 0x62, 0x1F, 0xA0, 0x3D, 0x57, 0xC8, 0x19 } }
+
+// gMiscRamFileSystemGuid
+extern EFI_GUID gMiscRamFileSystemGuid;
+
+#endif // MISC_RAM_FILE_SYSTEM_H_
@@ -0,0 +1,88 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  A compact device path stores a device path in fewer bytes for NVRAM:
+
+    UINT8 Revision  MISC_COMPACT_DEVICE_PATH_REVISION.
+    Records, up to and including the end record.
+
+  Each record starts with a code byte:
+
+    MISC_COMPACT_DP_END_ENTIRE    The end of the device path.
+    MISC_COMPACT_DP_END_INSTANCE  An end-of-instance node.
+    MISC_COMPACT_DP_LITERAL       UINT8 Type, UINT8 SubType, Varint
+                                  DataLength and the node's data.
+    MISC_COMPACT_DP_NARROW_PATH   A file path node whose characters are all
+                                  below 0x100.  Followed by Varint Length and
+                                  the characters' low bytes.
+    MISC_COMPACT_DP_DICTIONARY+n  A node described by dictionary entry n,
+                                  which implies the node's type, sub-type and
+                                  the leading bytes of its data.  Followed by
+                                  Varint RestLength, a GUID reference if the
+                                  entry has a GUID, and the rest of the data
+                                  without the GUID.
+
+  Varints are little-endian base-128, 7 bits per byte with the top bit set
+  on all but the last byte, and never exceed 0xFFFF.
+
+  A GUID reference is a Varint index into the GUIDs seen so far in the
+  record stream.  An index equal to the number of GUIDs seen is followed by
+  the GUID itself, which is then added to them.  At most
+  MISC_COMPACT_DP_MAX_GUIDS GUIDs are referenced, further GUID nodes are
+  stored as literals.
+
+  The dictionary entries are, in order:
+
+     0  ACPI PciRoot (PNP0A03)       8  Messaging vendor, GUID
+     1  ACPI PcieRoot (PNP0A08)      9  Media vendor, GUID
+     2  PCI                         10  Hard drive, GUID signature
+     3  USB                         11  File path
+     4  SATA                        12  Firmware volume, GUID
+     5  NVMe namespace              13  Firmware file, GUID
+     6  MAC address                 14  SCSI
+     7  Hardware vendor, GUID       15  Logical unit
+**/
+
+#ifndef MISC_COMPACT_DEVICE_PATH_H_
+#define MISC_COMPACT_DEVICE_PATH_H_
+
+// MISC_COMPACT_DEVICE_PATH_REVISION
+#define MISC_COMPACT_DEVICE_PATH_REVISION  1
+
+// MISC_COMPACT_DP_END_ENTIRE
+#define MISC_COMPACT_DP_END_ENTIRE  0x00
+
+// MISC_COMPACT_DP_END_INSTANCE
+#define MISC_COMPACT_DP_END_INSTANCE  0x01
+
+// MISC_COMPACT_DP_LITERAL
+#define MISC_COMPACT_DP_LITERAL  0x02
+
+// MISC_COMPACT_DP_NARROW_PATH
+#define MISC_COMPACT_DP_NARROW_PATH  0x03
+
+// MISC_COMPACT_DP_DICTIONARY
+#define MISC_COMPACT_DP_DICTIONARY  0x10
+
+// MISC_COMPACT_DP_DICTIONARY_SIZE
+#define MISC_COMPACT_DP_DICTIONARY_SIZE  16
+
+// MISC_COMPACT_DP_MAX_GUIDS
+#define MISC_COMPACT_DP_MAX_GUIDS  16
+
+// MISC_COMPACT_DP_MAX_VARINT_SIZE
+#define MISC_COMPACT_DP_MAX_VARINT_SIZE  3
+
+#endif // MISC_COMPACT_DEVICE_PATH_H_
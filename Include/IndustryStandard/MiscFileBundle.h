@@ -0,0 +1,55 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  A file bundle packs many small files into one:
+
+    MISC_FILE_BUNDLE_HEADER
+    MISC_FILE_BUNDLE_ENTRY[NumberOfEntries]
+    Names and payloads, referenced by offsets from the start of the bundle.
+
+  Names are NUL-terminated CHAR16 paths relative to the bundle, using '\' as
+  separator, and are matched case-insensitively.  Names must be 2-byte and
+  payloads should be 8-byte aligned so they can be accessed in place.
+**/
+
+#ifndef MISC_FILE_BUNDLE_H_
+#define MISC_FILE_BUNDLE_H_
+
+// MISC_FILE_BUNDLE_SIGNATURE
+#define MISC_FILE_BUNDLE_SIGNATURE  SIGNATURE_32 ('M', 'F', 'B', 'N')
+
+// MISC_FILE_BUNDLE_REVISION
+#define MISC_FILE_BUNDLE_REVISION  1
+
+#pragma pack (1)
+
+// MISC_FILE_BUNDLE_HEADER
+typedef struct {
+  UINT32 Signature;        ///< MISC_FILE_BUNDLE_SIGNATURE.
+  UINT32 Revision;         ///< MISC_FILE_BUNDLE_REVISION.
+  UINT32 NumberOfEntries;  ///< The number of index entries.
+  UINT32 Reserved;         ///< Must be 0.
+} MISC_FILE_BUNDLE_HEADER;
+
+// MISC_FILE_BUNDLE_ENTRY
+typedef struct {
+  UINT32 NameOffset;  ///< The offset of the file's name.
+  UINT32 DataOffset;  ///< The offset of the file's payload.
+  UINT32 DataSize;    ///< The size, in bytes, of the file's payload.
+} MISC_FILE_BUNDLE_ENTRY;
+
+#pragma pack ()
+
+#endif // MISC_FILE_BUNDLE_H_
@@ -0,0 +1,72 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  A file trace records the file accesses of a boot in the order they
+  occurred:
+
+    MISC_FILE_TRACE_HEADER
+    MISC_FILE_TRACE_RECORD[NumberOfRecords], each open record directly
+    followed by its path.
+
+  Paths are NUL-terminated CHAR16 strings as passed to the opening function.
+  The first open of a path records it and assigns it the next path ID.  Later
+  opens of it are recorded with a Size of 0 and are not followed by the path.
+  All other records refer to paths by their IDs.  Times are 0 if the recording
+  platform has no TimerLib performance counter.
+**/
+
+#ifndef MISC_FILE_TRACE_H_
+#define MISC_FILE_TRACE_H_
+
+// MISC_FILE_TRACE_SIGNATURE
+#define MISC_FILE_TRACE_SIGNATURE  SIGNATURE_32 ('M', 'F', 'T', 'R')
+
+// MISC_FILE_TRACE_REVISION
+#define MISC_FILE_TRACE_REVISION  1
+
+// MISC_FILE_TRACE_OPEN
+/// A path has been opened.
+#define MISC_FILE_TRACE_OPEN  1
+
+// MISC_FILE_TRACE_READ
+/// A range of an opened path has been read.
+#define MISC_FILE_TRACE_READ  2
+
+// MISC_FILE_TRACE_MAX_PATHS
+#define MISC_FILE_TRACE_MAX_PATHS  MAX_UINT16
+
+#pragma pack (1)
+
+// MISC_FILE_TRACE_HEADER
+typedef struct {
+  UINT32 Signature;        ///< MISC_FILE_TRACE_SIGNATURE.
+  UINT32 Revision;         ///< MISC_FILE_TRACE_REVISION.
+  UINT32 NumberOfRecords;  ///< The number of records following.
+  UINT32 NumberOfPaths;    ///< The number of open records.
+} MISC_FILE_TRACE_HEADER;
+
+// MISC_FILE_TRACE_RECORD
+typedef struct {
+  UINT8  Type;       ///< MISC_FILE_TRACE_OPEN or MISC_FILE_TRACE_READ.
+  UINT8  Reserved;   ///< Must be 0.
+  UINT16 PathId;     ///< The ID of the path accessed.
+  UINT32 Size;       ///< The size of the path or of the range read.
+  UINT64 Offset;     ///< The offset of the range read, 0 for opens.
+  UINT32 Time;       ///< Microseconds since the trace has been started.
+} MISC_FILE_TRACE_RECORD;
+
+#pragma pack ()
+
+#endif // MISC_FILE_TRACE_H_
@@ -15,6 +15,7 @@
 
   @par Specification Reference:
     - Universal Serial Bus HID Usage Tables 1.12
+    - Device Class Definition for Human Interface Devices (HID) 1.11
 **/
 
 #ifndef USB_HID_H_
@@ -77,16 +78,104 @@ typedef UINT16 USB_HID_USAGE_ID;
 // USB_HID_USAGE
 typedef UINT32 USB_HID_USAGE;
 
+// USB HID Report Descriptor Items
+
+// USB_HID_ITEM_LONG
+/// The prefix of long items, followed by their data size and tag.
+#define USB_HID_ITEM_LONG  0xFE
+
+// USB_HID_ITEM_SIZE
+#define USB_HID_ITEM_SIZE(Prefix)  \
+  ((((Prefix) & 0x03) == 0x03) ? 4 : ((Prefix) & 0x03))
+
+// USB_HID_ITEM_TYPE
+#define USB_HID_ITEM_TYPE(Prefix)  (((Prefix) >> 2) & 0x03)
+
+// USB_HID_ITEM_TAG
+#define USB_HID_ITEM_TAG(Prefix)  (((Prefix) >> 4) & 0x0F)
+
+// USB_HID_ITEM_TYPES
+enum {
+  UsbHidItemTypeMain     = 0x00,
+  UsbHidItemTypeGlobal   = 0x01,
+  UsbHidItemTypeLocal    = 0x02,
+  UsbHidItemTypeReserved = 0x03
+};
+
+// USB_HID_MAIN_ITEM_TAGS
+enum {
+  UsbHidMainItemTagInput         = 0x08,
+  UsbHidMainItemTagOutput        = 0x09,
+  UsbHidMainItemTagCollection    = 0x0A,
+  UsbHidMainItemTagFeature       = 0x0B,
+  UsbHidMainItemTagEndCollection = 0x0C
+};
+
+// USB_HID_GLOBAL_ITEM_TAGS
+enum {
+  UsbHidGlobalItemTagUsagePage       = 0x00,
+  UsbHidGlobalItemTagLogicalMinimum  = 0x01,
+  UsbHidGlobalItemTagLogicalMaximum  = 0x02,
+  UsbHidGlobalItemTagPhysicalMinimum = 0x03,
+  UsbHidGlobalItemTagPhysicalMaximum = 0x04,
+  UsbHidGlobalItemTagUnitExponent    = 0x05,
+  UsbHidGlobalItemTagUnit            = 0x06,
+  UsbHidGlobalItemTagReportSize      = 0x07,
+  UsbHidGlobalItemTagReportId        = 0x08,
+  UsbHidGlobalItemTagReportCount     = 0x09,
+  UsbHidGlobalItemTagPush            = 0x0A,
+  UsbHidGlobalItemTagPop             = 0x0B
+};
+
+// USB_HID_LOCAL_ITEM_TAGS
+enum {
+  UsbHidLocalItemTagUsage             = 0x00,
+  UsbHidLocalItemTagUsageMinimum      = 0x01,
+  UsbHidLocalItemTagUsageMaximum      = 0x02,
+  UsbHidLocalItemTagDesignatorIndex   = 0x03,
+  UsbHidLocalItemTagDesignatorMinimum = 0x04,
+  UsbHidLocalItemTagDesignatorMaximum = 0x05,
+  UsbHidLocalItemTagStringIndex       = 0x07,
+  UsbHidLocalItemTagStringMinimum     = 0x08,
+  UsbHidLocalItemTagStringMaximum     = 0x09,
+  UsbHidLocalItemTagDelimiter         = 0x0A
+};
+
+// USB HID Input, Output and Feature Item Data
+
+#define USB_HID_MAIN_ITEM_CONSTANT        BIT0
+#define USB_HID_MAIN_ITEM_VARIABLE        BIT1
+#define USB_HID_MAIN_ITEM_RELATIVE        BIT2
+#define USB_HID_MAIN_ITEM_WRAP            BIT3
+#define USB_HID_MAIN_ITEM_NON_LINEAR      BIT4
+#define USB_HID_MAIN_ITEM_NO_PREFERRED    BIT5
+#define USB_HID_MAIN_ITEM_NULL_STATE      BIT6
+#define USB_HID_MAIN_ITEM_VOLATILE        BIT7
+#define USB_HID_MAIN_ITEM_BUFFERED_BYTES  BIT8
+
+// USB HID Collection Item Data
+
+// USB_HID_COLLECTION_TYPES
+enum {
+  UsbHidCollectionPhysical      = 0x00,
+  UsbHidCollectionApplication   = 0x01,
+  UsbHidCollectionLogical       = 0x02,
+  UsbHidCollectionReport        = 0x03,
+  UsbHidCollectionNamedArray    = 0x04,
+  UsbHidCollectionUsageSwitch   = 0x05,
+  UsbHidCollectionUsageModifier = 0x06
+};
+
 // USB HID Consumer
 
 #define USB_HID_CONSUMER_USAGE(UsageId)  \
-  USB_HID_USAGE (UsbHidConsumerPage, (UsageId))
+  USB_HID_USAGE ((UsageId), UsbHidConsumerPage)
 
 // USB HID Keyboard/Keypad
 
 // USB_HID_KEYBOARD_KEY_PAD
 #define USB_HID_KB_KP_USAGE(UsageId)  \
-  USB_HID_USAGE (UsbHidKeyboardKeypadPage, (UsageId))
+  USB_HID_USAGE ((UsageId), UsbHidKeyboardKeypadPage)
 
 // USB HID Modifier Map
 
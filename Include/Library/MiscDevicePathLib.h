@@ -17,6 +17,8 @@
 #ifndef MISC_DEVICE_PATH_LIB_H_
 #define MISC_DEVICE_PATH_LIB_H_
 
+#include <Protocol/DevicePath.h>
+
 // MiscFileDevicePathToText
 CHAR16 *
 MiscFileDevicePathToText (
@@ -24,4 +26,221 @@ MiscFileDevicePathToText (
   IN OUT UINTN                     *TextSize OPTIONAL
   );
 
+// MiscFileDevicePathToTextBuffer
+EFI_STATUS
+MiscFileDevicePathToTextBuffer (
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN OUT UINTN                           *BufferSize,
+  OUT    CHAR16                          *Buffer OPTIONAL
+  );
+
+// MiscSingleNodeFilePathToText
+EFI_STATUS
+MiscSingleNodeFilePathToText (
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN OUT UINTN                           *BufferSize,
+  OUT    CHAR16                          *Buffer OPTIONAL
+  );
+
+// MiscSingleNodeNonterminatedFilePathToText
+EFI_STATUS
+MiscSingleNodeNonterminatedFilePathToText (
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN OUT UINTN                           *BufferSize,
+  OUT    CHAR16                          *Buffer OPTIONAL
+  );
+
+// MiscMultiNodeFilePathToText
+EFI_STATUS
+MiscMultiNodeFilePathToText (
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN OUT UINTN                           *BufferSize,
+  OUT    CHAR16                          *Buffer OPTIONAL
+  );
+
+// MiscMultiNodeNonterminatedFilePathToText
+EFI_STATUS
+MiscMultiNodeNonterminatedFilePathToText (
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN OUT UINTN                           *BufferSize,
+  OUT    CHAR16                          *Buffer OPTIONAL
+  );
+
+// MISC_FILE_PATH_TEXT_NONE
+/// The offset of device paths without a file path node.
+#define MISC_FILE_PATH_TEXT_NONE  MAX_UINTN
+
+// MISC_FILE_PATH_TEXT_TABLE
+/// Paths converted by MiscFileDevicePathsToText().
+typedef struct {
+  UINTN        NumberOfPaths;
+  CONST UINTN  *Offsets;  ///< The offset, in characters, of each path in
+                          ///< Strings or MISC_FILE_PATH_TEXT_NONE.
+  CONST CHAR16 *Strings;  ///< The NUL-terminated paths, back to back.
+} MISC_FILE_PATH_TEXT_TABLE;
+
+// MiscFileDevicePathsToText
+MISC_FILE_PATH_TEXT_TABLE *
+MiscFileDevicePathsToText (
+  IN UINTN                           NumberOfDevicePaths,
+  IN CONST EFI_DEVICE_PATH_PROTOCOL  **DevicePaths
+  );
+
+// MiscTextToFileDevicePath
+EFI_STATUS
+MiscTextToFileDevicePath (
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *Prefix OPTIONAL,
+  IN     CONST CHAR16                    *Path,
+  IN     BOOLEAN                         MultiNode,
+  IN OUT UINTN                           *BufferSize,
+  OUT    EFI_DEVICE_PATH_PROTOCOL        *DevicePath OPTIONAL
+  );
+
+// MISC_DEVICE_PATH_INTERN_TABLE
+/// A set of unique device paths.
+typedef struct MISC_DEVICE_PATH_INTERN_TABLE MISC_DEVICE_PATH_INTERN_TABLE;
+
+// MISC_INTERNED_DEVICE_PATH
+typedef struct {
+  CONST EFI_DEVICE_PATH_PROTOCOL *DevicePath;
+  UINTN                          Size;   ///< Including the end node.
+  UINT64                         Hash;   ///< As by MiscHashDevicePath().
+} MISC_INTERNED_DEVICE_PATH;
+
+// MiscHashDevicePath
+EFI_STATUS
+MiscHashDevicePath (
+  IN  CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN  UINTN                           MaxSize,
+  OUT UINT64                          *Hash,
+  OUT UINTN                           *Size OPTIONAL
+  );
+
+// MiscCreateDevicePathInternTable
+EFI_STATUS
+MiscCreateDevicePathInternTable (
+  OUT MISC_DEVICE_PATH_INTERN_TABLE  **Table
+  );
+
+// MiscDestroyDevicePathInternTable
+VOID
+MiscDestroyDevicePathInternTable (
+  IN MISC_DEVICE_PATH_INTERN_TABLE  *Table
+  );
+
+// MiscLookupDevicePath
+EFI_STATUS
+MiscLookupDevicePath (
+  IN  CONST MISC_DEVICE_PATH_INTERN_TABLE  *Table,
+  IN  CONST EFI_DEVICE_PATH_PROTOCOL       *DevicePath,
+  IN  UINTN                                MaxSize,
+  OUT CONST MISC_INTERNED_DEVICE_PATH      **Interned
+  );
+
+// MiscInternDevicePath
+EFI_STATUS
+MiscInternDevicePath (
+  IN OUT MISC_DEVICE_PATH_INTERN_TABLE   *Table,
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN     UINTN                           MaxSize,
+  OUT    CONST MISC_INTERNED_DEVICE_PATH **Interned
+  );
+
+// MISC_DEVICE_PATH_TRIE
+/// A prefix trie of the device paths of all handles.
+typedef struct MISC_DEVICE_PATH_TRIE MISC_DEVICE_PATH_TRIE;
+
+// MiscCreateDevicePathTrie
+EFI_STATUS
+MiscCreateDevicePathTrie (
+  OUT MISC_DEVICE_PATH_TRIE  **Trie
+  );
+
+// MiscDestroyDevicePathTrie
+VOID
+MiscDestroyDevicePathTrie (
+  IN MISC_DEVICE_PATH_TRIE  *Trie
+  );
+
+// MiscTrieLocateDevicePath
+EFI_STATUS
+MiscTrieLocateDevicePath (
+  IN OUT MISC_DEVICE_PATH_TRIE     *Trie,
+  IN     EFI_GUID                  *Protocol,
+  IN OUT EFI_DEVICE_PATH_PROTOCOL  **DevicePath,
+  OUT    EFI_HANDLE                *Device
+  );
+
+// MISC_DEVICE_PATH_ANY_TYPE
+/// Matches any node type or sub-type when filtering nodes.
+#define MISC_DEVICE_PATH_ANY_TYPE  0xFF
+
+// MISC_DEVICE_PATH_ITERATOR
+typedef struct {
+  CONST EFI_DEVICE_PATH_PROTOCOL *Current;
+  CONST EFI_DEVICE_PATH_PROTOCOL *End;      ///< The validated end node.
+  UINT8                          Type;
+  UINT8                          SubType;
+} MISC_DEVICE_PATH_ITERATOR;
+
+// MISC_DEVICE_PATH_NODE_KIND
+typedef enum {
+  MiscDevicePathNodeOther,
+  MiscDevicePathNodePci,
+  MiscDevicePathNodeUsb,
+  MiscDevicePathNodeHardDrive,
+  MiscDevicePathNodeFilePath
+} MISC_DEVICE_PATH_NODE_KIND;
+
+// MISC_DEVICE_PATH_NODE
+/// A node yielded by MiscNextDevicePathNode().  The view matching Kind is
+/// guaranteed to lie within the node.
+typedef struct {
+  MISC_DEVICE_PATH_NODE_KIND Kind;
+  UINTN                      Size;
+  UINTN                      PathLength;  ///< For file paths, the length in
+                                          ///< characters without terminator.
+  union {
+    CONST EFI_DEVICE_PATH_PROTOCOL *Generic;
+    CONST PCI_DEVICE_PATH          *Pci;
+    CONST USB_DEVICE_PATH          *Usb;
+    CONST HARDDRIVE_DEVICE_PATH    *HardDrive;
+    CONST FILEPATH_DEVICE_PATH     *FilePath;
+  } View;
+} MISC_DEVICE_PATH_NODE;
+
+// MiscInitDevicePathIterator
+EFI_STATUS
+MiscInitDevicePathIterator (
+  OUT MISC_DEVICE_PATH_ITERATOR       *Iterator,
+  IN  CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN  UINTN                           MaxSize,
+  IN  UINT8                           Type,
+  IN  UINT8                           SubType
+  );
+
+// MiscNextDevicePathNode
+BOOLEAN
+MiscNextDevicePathNode (
+  IN OUT MISC_DEVICE_PATH_ITERATOR  *Iterator,
+  OUT    MISC_DEVICE_PATH_NODE      *Node
+  );
+
+// MiscEncodeCompactDevicePath
+EFI_STATUS
+MiscEncodeCompactDevicePath (
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN OUT UINTN                           *BufferSize,
+  OUT    VOID                            *Buffer OPTIONAL
+  );
+
+// MiscDecodeCompactDevicePath
+EFI_STATUS
+MiscDecodeCompactDevicePath (
+  IN     CONST VOID                *Data,
+  IN     UINTN                     DataSize,
+  IN OUT UINTN                     *BufferSize,
+  OUT    EFI_DEVICE_PATH_PROTOCOL  *DevicePath OPTIONAL
+  );
+
 #endif // MISC_DEVICE_PATH_LIB_H_
@@ -47,6 +47,332 @@ LoadFile (
   OUT VOID             **Buffer
   );
 
+// MISC_FILE_CHUNK_HANDLER
+/** Handles a chunk of data read by MiscReadFileChunked().
+
+  @param[in] Context   The context passed to MiscReadFileChunked().
+  @param[in] Data      The chunk that has been read.
+  @param[in] DataSize  The size, in bytes, of Data.
+
+  @return  Returning an error stops the read.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *MISC_FILE_CHUNK_HANDLER)(
+  IN VOID        *Context,
+  IN CONST VOID  *Data,
+  IN UINTN       DataSize
+  );
+
+// MiscReadFileChunked
+EFI_STATUS
+MiscReadFileChunked (
+  IN     EFI_FILE_HANDLE          FileHandle,
+  IN OUT UINTN                    *BufferSize,
+  OUT    VOID                     *Buffer,
+  IN     UINTN                    ChunkSize,
+  IN     MISC_FILE_CHUNK_HANDLER  Handler OPTIONAL,
+  IN     VOID                     *Context OPTIONAL
+  );
+
+// MISC_FILE_DECODE
+/** Decodes a compressed file while it is being read.
+
+  @param[in]  FileHandle  The file to decode from its current position.
+  @param[out] BufferSize  The size, in bytes, of the decoded data.
+  @param[out] Buffer      The decoded data.  Free with FreePool().
+
+  @return  Returned is the status of the operation.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *MISC_FILE_DECODE)(
+  IN  EFI_FILE_HANDLE  FileHandle,
+  OUT UINTN            *BufferSize,
+  OUT VOID             **Buffer
+  );
+
+// MiscLz4DecodeFile
+EFI_STATUS
+EFIAPI
+MiscLz4DecodeFile (
+  IN  EFI_FILE_HANDLE  FileHandle,
+  OUT UINTN            *BufferSize,
+  OUT VOID             **Buffer
+  );
+
+// LoadCompressedFile
+EFI_STATUS
+LoadCompressedFile (
+  IN  EFI_FILE_HANDLE   Root,
+  IN  CHAR16            *FileName,
+  IN  MISC_FILE_DECODE  Decode,
+  OUT UINTN             *BufferSize,
+  OUT VOID              **Buffer
+  );
+
+// MISC_FILE_DIGEST_UPDATE
+typedef
+VOID
+(EFIAPI *MISC_FILE_DIGEST_UPDATE)(
+  IN OUT VOID        *Context,
+  IN     CONST VOID  *Data,
+  IN     UINTN       DataSize
+  );
+
+// MISC_FILE_DIGEST_FINAL
+typedef
+VOID
+(EFIAPI *MISC_FILE_DIGEST_FINAL)(
+  IN  VOID   *Context,
+  OUT UINT8  *Digest
+  );
+
+// MISC_FILE_DIGEST
+/// A digest computed while a file is being loaded, e.g. wrapping the
+/// Sha256Update() and Sha256Final() functions of BaseCryptLib.
+typedef struct {
+  MISC_FILE_DIGEST_UPDATE Update;          ///< Called for every chunk.
+  MISC_FILE_DIGEST_FINAL  Final;           ///< Called once all data is read.
+  VOID                    *Context;        ///< Initialized by the caller.
+  UINTN                   DigestSize;      ///< The size of the digest.
+  UINT8                   *Digest;         ///< Receives the digest.
+  CONST UINT8             *ExpectedDigest; ///< Optional, verified if set.
+} MISC_FILE_DIGEST;
+
+// MISC_CRC32_DIGEST_SIZE
+#define MISC_CRC32_DIGEST_SIZE  sizeof (UINT32)
+
+// MiscCrc32DigestUpdate
+VOID
+EFIAPI
+MiscCrc32DigestUpdate (
+  IN OUT VOID        *Context,
+  IN     CONST VOID  *Data,
+  IN     UINTN       DataSize
+  );
+
+// MiscCrc32DigestFinal
+VOID
+EFIAPI
+MiscCrc32DigestFinal (
+  IN  VOID   *Context,
+  OUT UINT8  *Digest
+  );
+
+// LoadFileWithDigests
+EFI_STATUS
+LoadFileWithDigests (
+  IN     EFI_FILE_HANDLE   Root,
+  IN     CHAR16            *FileName,
+  IN     UINTN             NumberOfDigests,
+  IN OUT MISC_FILE_DIGEST  *Digests OPTIONAL,
+  OUT    UINTN             *BufferSize,
+  OUT    VOID              **Buffer
+  );
+
+// MISC_FILE_RANGE
+typedef struct {
+  UINT64 Offset;    ///< The offset of the range in the file.
+  UINTN  Size;      ///< The size of the range.
+  VOID   *Buffer;   ///< Receives the range's data.
+  UINTN  ReadSize;  ///< Receives the number of bytes read.
+} MISC_FILE_RANGE;
+
+// MiscReadFileRange
+EFI_STATUS
+MiscReadFileRange (
+  IN     EFI_FILE_HANDLE  FileHandle,
+  IN     UINT64           Offset,
+  IN OUT UINTN            *Size,
+  OUT    VOID             *Buffer
+  );
+
+// MiscReadFileRanges
+EFI_STATUS
+MiscReadFileRanges (
+  IN     EFI_FILE_HANDLE  FileHandle,
+  IN     UINTN            NumberOfRanges,
+  IN OUT MISC_FILE_RANGE  *Ranges
+  );
+
+// MISC_FILE_BUNDLE
+/// A loaded and indexed file bundle.
+typedef struct MISC_FILE_BUNDLE MISC_FILE_BUNDLE;
+
+// MiscOpenFileBundle
+EFI_STATUS
+MiscOpenFileBundle (
+  IN  EFI_FILE_HANDLE   Root,
+  IN  CHAR16            *FileName,
+  OUT MISC_FILE_BUNDLE  **Bundle
+  );
+
+// MiscCloseFileBundle
+VOID
+MiscCloseFileBundle (
+  IN MISC_FILE_BUNDLE  *Bundle
+  );
+
+// MiscFindBundledFile
+EFI_STATUS
+MiscFindBundledFile (
+  IN  CONST MISC_FILE_BUNDLE  *Bundle,
+  IN  CONST CHAR16            *FileName,
+  OUT UINTN                   *BufferSize,
+  OUT CONST VOID              **Buffer
+  );
+
+// MiscGetBundledFileCount
+UINTN
+MiscGetBundledFileCount (
+  IN CONST MISC_FILE_BUNDLE  *Bundle
+  );
+
+// MiscGetBundledFile
+VOID
+MiscGetBundledFile (
+  IN  CONST MISC_FILE_BUNDLE  *Bundle,
+  IN  UINTN                   Index,
+  OUT CONST CHAR16            **FileName,
+  OUT UINTN                   *BufferSize,
+  OUT CONST VOID              **Buffer
+  );
+
+// MISC_FILE_WRITER_MODE
+typedef enum {
+  MiscFileWriterTruncate,       ///< Existing data is discarded.
+  MiscFileWriterAppend,         ///< Data is appended to existing data.
+  MiscFileWriterAtomicReplace   ///< The file is replaced once closed.
+} MISC_FILE_WRITER_MODE;
+
+// MISC_FILE_WRITER
+/// A buffered, coalescing file writer.
+typedef struct MISC_FILE_WRITER MISC_FILE_WRITER;
+
+// MiscOpenFileWriter
+EFI_STATUS
+MiscOpenFileWriter (
+  IN  EFI_FILE_HANDLE        Root,
+  IN  CONST CHAR16           *FileName,
+  IN  MISC_FILE_WRITER_MODE  Mode,
+  IN  UINTN                  BufferSize,
+  OUT MISC_FILE_WRITER       **Writer
+  );
+
+// MiscFileWriterWrite
+EFI_STATUS
+MiscFileWriterWrite (
+  IN OUT MISC_FILE_WRITER  *Writer,
+  IN     CONST VOID        *Data,
+  IN     UINTN             DataSize
+  );
+
+// MiscFileWriterFlush
+EFI_STATUS
+MiscFileWriterFlush (
+  IN OUT MISC_FILE_WRITER  *Writer
+  );
+
+// MiscCloseFileWriter
+EFI_STATUS
+MiscCloseFileWriter (
+  IN MISC_FILE_WRITER  *Writer
+  );
+
+// MiscDiscardFileWriter
+VOID
+MiscDiscardFileWriter (
+  IN MISC_FILE_WRITER  *Writer
+  );
+
+// MiscStartFileTrace
+EFI_STATUS
+MiscStartFileTrace (
+  VOID
+  );
+
+// MiscStopFileTrace
+EFI_STATUS
+MiscStopFileTrace (
+  IN EFI_FILE_HANDLE  Root OPTIONAL,
+  IN CONST CHAR16     *FileName
+  );
+
+// MiscTraceFileHandle
+VOID
+MiscTraceFileHandle (
+  IN EFI_FILE_HANDLE  FileHandle,
+  IN CONST CHAR16     *FileName OPTIONAL
+  );
+
+// MiscPrefetchFiles
+EFI_STATUS
+MiscPrefetchFiles (
+  IN EFI_FILE_HANDLE  Root,
+  IN CHAR16           *TraceFileName
+  );
+
+// MiscReleasePrefetchedFiles
+VOID
+MiscReleasePrefetchedFiles (
+  VOID
+  );
+
+// MiscLoadFileCached
+EFI_STATUS
+MiscLoadFileCached (
+  IN  EFI_HANDLE       VolumeHandle,
+  IN  EFI_FILE_HANDLE  Root,
+  IN  CHAR16           *FileName,
+  OUT UINTN            *BufferSize,
+  OUT VOID             **Buffer
+  );
+
+// MISC_FILE_EXTENT
+/// A contiguous run of a file's data on its volume.
+typedef struct {
+  UINT64 Offset;    ///< The byte offset relative to the volume's start.
+  UINT64 Length;    ///< The length, in bytes.
+} MISC_FILE_EXTENT;
+
+// MiscGetFileExtents
+EFI_STATUS
+MiscGetFileExtents (
+  IN  EFI_HANDLE        VolumeHandle,
+  IN  CONST CHAR16      *FileName,
+  OUT UINT64            *FileSize,
+  OUT UINTN             *NumberOfExtents,
+  OUT MISC_FILE_EXTENT  **Extents
+  );
+
+// MiscLoadFileByExtents
+EFI_STATUS
+MiscLoadFileByExtents (
+  IN  EFI_HANDLE       VolumeHandle,
+  IN  EFI_FILE_HANDLE  Root,
+  IN  CHAR16           *FileName,
+  OUT UINTN            *BufferSize,
+  OUT VOID             **Buffer
+  );
+
+// MISC_FILE_PROBE_MODE
+typedef enum {
+  MiscFileProbeAll,         ///< Wait for all probes to complete.
+  MiscFileProbeFirstMatch   ///< Return as soon as any path has been found.
+} MISC_FILE_PROBE_MODE;
+
+// MiscProbeVolumes
+EFI_STATUS
+MiscProbeVolumes (
+  IN  UINTN                 NumberOfPaths,
+  IN  CONST CHAR16          **Paths,
+  IN  MISC_FILE_PROBE_MODE  Mode,
+  OUT UINTN                 *NumberOfVolumes,
+  OUT EFI_HANDLE            **Volumes,
+  OUT UINT64                **Hits
+  );
+
 // GetFileExtension
 CHAR16 *
 GetFileExtension (
@@ -59,6 +385,40 @@ GetFilePrimaryExtension (
   IN CHAR16  *FileName
   );
 
+// MISC_FILE_PATH_COMPONENTS
+typedef struct {
+  CONST CHAR16 *Name;                 ///< The last path component.
+  UINTN        NameLength;
+  UINTN        BaseNameLength;        ///< The length up to the first '.'.
+  CONST CHAR16 *Extensions;           ///< All extensions, NULL if none.
+  UINTN        ExtensionsLength;
+  CONST CHAR16 *LastExtension;        ///< The last extension, NULL if none.
+  UINTN        LastExtensionLength;
+} MISC_FILE_PATH_COMPONENTS;
+
+// MiscSplitFilePath
+VOID
+MiscSplitFilePath (
+  IN  CONST CHAR16               *Path,
+  IN  UINTN                      PathLength,
+  OUT MISC_FILE_PATH_COMPONENTS  *Components
+  );
+
+// MiscFileStrniCmp
+INTN
+MiscFileStrniCmp (
+  IN CONST CHAR16  *FirstString,
+  IN CONST CHAR16  *SecondString,
+  IN UINTN         Length
+  );
+
+// MiscFileStriCmp
+INTN
+MiscFileStriCmp (
+  IN CONST CHAR16  *FirstString,
+  IN CONST CHAR16  *SecondString
+  );
+
 // FindFirstFileByExtension
 EFI_STATUS
 FindFirstFileByExtension (
@@ -116,4 +476,179 @@ MiscGetFileInformation (
   IN EFI_GUID  *InformationType
 );
 
+// MiscGetFileInformationEx
+EFI_STATUS
+MiscGetFileInformationEx (
+  IN     EFI_FILE_HANDLE  FileHandle,
+  IN     EFI_GUID         *InformationType,
+  IN     UINTN            SizeHint,
+  IN OUT VOID             **Buffer,
+  IN OUT UINTN            *BufferSize
+  );
+
+// MISC_FILE_INFORMATION_REQUEST
+typedef struct {
+  EFI_GUID   *InformationType;  ///< The type of information to retrieve.
+  VOID       *Buffer;           ///< A reusable pool buffer or NULL.
+  UINTN      BufferSize;        ///< The size, in bytes, of Buffer.
+  EFI_STATUS Status;            ///< The request's result.
+} MISC_FILE_INFORMATION_REQUEST;
+
+// MiscGetFileInformationBatch
+EFI_STATUS
+MiscGetFileInformationBatch (
+  IN     EFI_FILE_HANDLE                FileHandle,
+  IN     UINTN                          NumberOfRequests,
+  IN OUT MISC_FILE_INFORMATION_REQUEST  *Requests
+  );
+
+// MISC_FILE_EXTENSION_NOT_FOUND
+#define MISC_FILE_EXTENSION_NOT_FOUND  MAX_UINTN
+
+// MISC_FILE_EXTENSION_SET
+/// A precompiled, case-insensitive set of file extensions.
+typedef struct MISC_FILE_EXTENSION_SET MISC_FILE_EXTENSION_SET;
+
+// MISC_FILE_SCAN_ENTRY
+typedef struct {
+  UINTN         Type;      ///< The index of the matching extension.
+  EFI_FILE_INFO *FileInfo; ///< The information of the matching entry.
+} MISC_FILE_SCAN_ENTRY;
+
+// MiscCreateFileExtensionSet
+MISC_FILE_EXTENSION_SET *
+MiscCreateFileExtensionSet (
+  IN CONST CHAR16  **Extensions,
+  IN UINTN         NumberOfExtensions,
+  IN BOOLEAN       PrimaryExtension
+  );
+
+// MiscFreeFileExtensionSet
+VOID
+MiscFreeFileExtensionSet (
+  IN MISC_FILE_EXTENSION_SET  *Set
+  );
+
+// MiscLookupFileExtension
+UINTN
+MiscLookupFileExtension (
+  IN CONST MISC_FILE_EXTENSION_SET  *Set,
+  IN CHAR16                         *FileName
+  );
+
+// MiscScanDirectoryByExtensionSet
+EFI_STATUS
+MiscScanDirectoryByExtensionSet (
+  IN  EFI_FILE_HANDLE                DirHandle,
+  IN  CONST MISC_FILE_EXTENSION_SET  *Set,
+  OUT UINTN                          *NumberOfEntries,
+  OUT MISC_FILE_SCAN_ENTRY           **Entries
+  );
+
+// MiscFreeFileScanEntries
+VOID
+MiscFreeFileScanEntries (
+  IN UINTN                 NumberOfEntries,
+  IN MISC_FILE_SCAN_ENTRY  *Entries
+  );
+
+// MISC_FILE_WALK_ORDER
+typedef enum {
+  MiscFileWalkDirectoryOrder,    ///< Entries are handled as they are read.
+  MiscFileWalkDirectoriesFirst,  ///< Subdirectories are handled before files.
+  MiscFileWalkFilesFirst         ///< Files are handled before subdirectories.
+} MISC_FILE_WALK_ORDER;
+
+// MISC_FILE_WALK_UNLIMITED_DEPTH
+#define MISC_FILE_WALK_UNLIMITED_DEPTH  MAX_UINTN
+
+// MISC_FILE_WALK_FILTER
+/** Decides on a directory entry met by MiscWalkDirectory().
+
+  @param[in] Context   The context passed with the walk's options.
+  @param[in] Path      The entry's path relative to the walk's root.
+  @param[in] FileInfo  The entry's information.
+  @param[in] Depth     The entry's depth, 0 for entries of the root.
+
+  @return  Returned is whether the entry shall be visited (Filter) or not
+           descended into (Prune).
+**/
+typedef
+BOOLEAN
+(EFIAPI *MISC_FILE_WALK_FILTER)(
+  IN VOID                 *Context,
+  IN CONST CHAR16         *Path,
+  IN CONST EFI_FILE_INFO  *FileInfo,
+  IN UINTN                Depth
+  );
+
+// MISC_FILE_WALK_VISIT
+/** Visits a directory entry met by MiscWalkDirectory().
+
+  @param[in] Context   The context passed with the walk's options.
+  @param[in] Path      The entry's path relative to the walk's root.
+  @param[in] FileInfo  The entry's information.
+  @param[in] Depth     The entry's depth, 0 for entries of the root.
+
+  @return  Returning an error stops the walk.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *MISC_FILE_WALK_VISIT)(
+  IN VOID                 *Context,
+  IN CONST CHAR16         *Path,
+  IN CONST EFI_FILE_INFO  *FileInfo,
+  IN UINTN                Depth
+  );
+
+// MISC_FILE_WALK_OPTIONS
+typedef struct {
+  MISC_FILE_WALK_ORDER  Order;     ///< The order entries are handled in.
+  UINTN                 MaxDepth;  ///< The deepest level to descend to.
+  MISC_FILE_WALK_FILTER Filter;    ///< Optional, selects entries to visit.
+  MISC_FILE_WALK_FILTER Prune;     ///< Optional, selects subtrees to skip.
+  MISC_FILE_WALK_VISIT  Visit;     ///< Called for every selected entry.
+  VOID                  *Context;  ///< Passed to all callbacks.
+} MISC_FILE_WALK_OPTIONS;
+
+// MiscWalkDirectory
+EFI_STATUS
+MiscWalkDirectory (
+  IN EFI_FILE_HANDLE               DirHandle,
+  IN CONST MISC_FILE_WALK_OPTIONS  *Options
+  );
+
+// MISC_FILE_GLOB
+/// A compiled path pattern.
+typedef struct MISC_FILE_GLOB MISC_FILE_GLOB;
+
+// MiscCompileFileGlob
+EFI_STATUS
+MiscCompileFileGlob (
+  IN  CONST CHAR16    *Pattern,
+  OUT MISC_FILE_GLOB  **Glob
+  );
+
+// MiscFreeFileGlob
+VOID
+MiscFreeFileGlob (
+  IN MISC_FILE_GLOB  *Glob
+  );
+
+// MiscMatchFileGlob
+BOOLEAN
+MiscMatchFileGlob (
+  IN CONST MISC_FILE_GLOB  *Glob,
+  IN CONST CHAR16          *Path
+  );
+
+// MiscFindFilesByGlob
+EFI_STATUS
+MiscFindFilesByGlob (
+  IN EFI_FILE_HANDLE       Root,
+  IN CONST MISC_FILE_GLOB  *Glob,
+  IN MISC_FILE_WALK_VISIT  Visit,
+  IN VOID                  *Context
+  );
+
 #endif // MISC_FILE_LIB_H_
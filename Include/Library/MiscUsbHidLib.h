@@ -25,4 +25,63 @@
 /// USB Keycode is defined in USB HID Firmware spec.
 extern USB_HID_USAGE_ID gEfiKeyToUsbKeyCodeConvertionTable[];
 
+// MISC_NO_EFI_KEY
+/// Marks USB Keycodes without an EFI_KEY.
+#define MISC_NO_EFI_KEY  0xFF
+
+// MISC_USB_KB_KP_NUMBER_OF_USAGES
+/// The number of USB Keycodes, including the modifier keys.
+#define MISC_USB_KB_KP_NUMBER_OF_USAGES  \
+  (UsbHidUsageIdKbKpModifierKeyRightGui + 1)
+
+// MISC_USB_KEY_CODE_TO_EFI_KEY
+typedef struct {
+  UINT8 Primary;    ///< The EFI_KEY or MISC_NO_EFI_KEY.
+  UINT8 Alternate;  ///< Another EFI_KEY or MISC_NO_EFI_KEY.
+} MISC_USB_KEY_CODE_TO_EFI_KEY;
+
+// gUsbKeyCodeToEfiKeyConvertionTable
+/// USB Keycode to EFI_KEY conversion table, indexed by USB Keycode.
+extern CONST MISC_USB_KEY_CODE_TO_EFI_KEY
+gUsbKeyCodeToEfiKeyConvertionTable[MISC_USB_KB_KP_NUMBER_OF_USAGES];
+
+// MISC_HID_FIELD
+/// A field of a report, compiled from a report descriptor.
+typedef struct {
+  USB_HID_USAGE Application;     ///< The usage of the application
+                                 ///< collection holding the field.
+  USB_HID_USAGE Usage;           ///< The usage or, for array fields, the
+                                 ///< usage of LogicalMinimum.
+  USB_HID_USAGE UsageMaximum;    ///< For array fields, the last usage.
+  INT32         LogicalMinimum;
+  INT32         LogicalMaximum;
+  UINT32        BitOffset;       ///< From the start of the report, including
+                                 ///< the Report ID.
+  UINT8         BitSize;         ///< At most 32.
+  UINT8         ReportId;        ///< 0 if the device uses no Report IDs.
+  UINT8         Type;            ///< The main item tag, e.g.
+                                 ///< UsbHidMainItemTagInput.
+  UINT8         Reserved;
+  UINT16        Flags;           ///< The main item data, e.g.
+                                 ///< USB_HID_MAIN_ITEM_VARIABLE.
+} MISC_HID_FIELD;
+
+// MiscHidParseReportDescriptor
+EFI_STATUS
+MiscHidParseReportDescriptor (
+  IN     CONST VOID      *Descriptor,
+  IN     UINTN           DescriptorSize,
+  IN OUT UINTN           *NumberOfFields,
+  OUT    MISC_HID_FIELD  *Fields OPTIONAL
+  );
+
+// MiscHidGetFieldValue
+BOOLEAN
+MiscHidGetFieldValue (
+  IN  CONST MISC_HID_FIELD  *Field,
+  IN  CONST VOID            *Report,
+  IN  UINTN                 ReportSize,
+  OUT INT32                 *Value
+  );
+
 #endif // MISC_USB_HID_LIB_H_
@@ -0,0 +1,104 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#ifndef MISC_FILE_CACHE_H_
+#define MISC_FILE_CACHE_H_
+
+// MISC_FILE_CACHE_PROTOCOL_GUID
+#define MISC_FILE_CACHE_PROTOCOL_GUID  \
+  { 0x7D0C93A6, 0x2B5E, 0x4C81, { 0xA4, 0x3F, 0x96, 0x1E, 0x58, 0xD2, 0x0B, 0x7C } }
+
+// MISC_FILE_CACHE_PROTOCOL_REVISION
+#define MISC_FILE_CACHE_PROTOCOL_REVISION  0x00010000
+
+// MISC_FILE_CACHE_KEY
+/// Identifies one version of a file's content.
+typedef struct {
+  EFI_DEVICE_PATH_PROTOCOL *Volume;            ///< The volume's device path.
+  CONST CHAR16             *FileName;          ///< Matched case-insensitively.
+  EFI_TIME                 ModificationTime;   ///< From the file's FILE_INFO.
+  UINT64                   FileSize;           ///< From the file's FILE_INFO.
+} MISC_FILE_CACHE_KEY;
+
+typedef struct MISC_FILE_CACHE_PROTOCOL MISC_FILE_CACHE_PROTOCOL;
+
+// MISC_FILE_CACHE_LOOKUP
+/** Looks up a file's content and references it.
+
+  @param[in]  This    The protocol instance.
+  @param[in]  Key     The content to look up.
+  @param[out] Buffer  The cached content, Key->FileSize bytes.  It must not be
+                      modified and stays valid until it is released.
+
+  @retval EFI_SUCCESS    The content is cached and has been referenced.
+  @retval EFI_NOT_FOUND  The content is not cached.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *MISC_FILE_CACHE_LOOKUP)(
+  IN  MISC_FILE_CACHE_PROTOCOL   *This,
+  IN  CONST MISC_FILE_CACHE_KEY  *Key,
+  OUT CONST VOID                 **Buffer
+  );
+
+// MISC_FILE_CACHE_INSERT
+/** Copies a file's content into the cache.
+
+  Least recently used content that is not referenced is evicted to stay
+  within the cache's budget.
+
+  @param[in] This    The protocol instance.
+  @param[in] Key     The content's key.
+  @param[in] Buffer  The content, Key->FileSize bytes.
+
+  @retval EFI_SUCCESS           The content has been cached.
+  @retval EFI_ALREADY_STARTED   The content is cached already.
+  @retval EFI_BUFFER_TOO_SMALL  The content does not fit the budget.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *MISC_FILE_CACHE_INSERT)(
+  IN MISC_FILE_CACHE_PROTOCOL   *This,
+  IN CONST MISC_FILE_CACHE_KEY  *Key,
+  IN CONST VOID                 *Buffer
+  );
+
+// MISC_FILE_CACHE_RELEASE
+/** Releases a reference returned by Lookup().
+
+  @param[in] This    The protocol instance.
+  @param[in] Buffer  The buffer returned by Lookup().
+**/
+typedef
+VOID
+(EFIAPI *MISC_FILE_CACHE_RELEASE)(
+  IN MISC_FILE_CACHE_PROTOCOL  *This,
+  IN CONST VOID                *Buffer
+  );
+
+// MISC_FILE_CACHE_PROTOCOL
+struct MISC_FILE_CACHE_PROTOCOL {
+  UINT64                  Revision;  ///< MISC_FILE_CACHE_PROTOCOL_REVISION.
+  MISC_FILE_CACHE_LOOKUP  Lookup;    ///< Looks up and references content.
+  MISC_FILE_CACHE_INSERT  Insert;    ///< Copies content into the cache.
+  MISC_FILE_CACHE_RELEASE Release;   ///< Releases referenced content.
+};
+
+// gMiscFileCacheProtocolGuid
+extern EFI_GUID gMiscFileCacheProtocolGuid;
+
+#endif // MISC_FILE_CACHE_H_
@@ -0,0 +1,776 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <IndustryStandard/MiscCompactDevicePath.h>
+
+#include <Protocol/DevicePath.h>
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/MiscDevicePathLib.h>
+
+// COMPACT_DP_NO_GUID
+#define COMPACT_DP_NO_GUID  0xFF
+
+// COMPACT_DP_DICTIONARY_ENTRY
+typedef struct {
+  UINT8 Type;
+  UINT8 SubType;
+  UINT8 PrefixSize;
+  UINT8 GuidOffset;  ///< The GUID's offset in the data after the prefix or
+                     ///< COMPACT_DP_NO_GUID.
+  UINT8 Prefix[4];
+} COMPACT_DP_DICTIONARY_ENTRY;
+
+// COMPACT_DP_WRITER
+/// Writes past the end of the buffer are counted but not performed, so the
+/// size needed is known after a single pass.
+typedef struct {
+  UINT8 *Buffer;
+  UINTN Size;
+  UINTN Offset;
+} COMPACT_DP_WRITER;
+
+// COMPACT_DP_READER
+typedef struct {
+  CONST UINT8 *Buffer;
+  UINTN       Size;
+  UINTN       Offset;
+} COMPACT_DP_READER;
+
+// mDictionary
+STATIC CONST COMPACT_DP_DICTIONARY_ENTRY
+mDictionary[MISC_COMPACT_DP_DICTIONARY_SIZE] = {
+  {
+    ACPI_DEVICE_PATH, ACPI_DP, 4, COMPACT_DP_NO_GUID,
+    { 0xD0, 0x41, 0x03, 0x0A }
+  },
+  {
+    ACPI_DEVICE_PATH, ACPI_DP, 4, COMPACT_DP_NO_GUID,
+    { 0xD0, 0x41, 0x08, 0x0A }
+  },
+  { HARDWARE_DEVICE_PATH,  HW_PCI_DP,                  0, COMPACT_DP_NO_GUID },
+  { MESSAGING_DEVICE_PATH, MSG_USB_DP,                 0, COMPACT_DP_NO_GUID },
+  { MESSAGING_DEVICE_PATH, MSG_SATA_DP,                0, COMPACT_DP_NO_GUID },
+  { MESSAGING_DEVICE_PATH, MSG_NVME_NAMESPACE_DP,      0, COMPACT_DP_NO_GUID },
+  { MESSAGING_DEVICE_PATH, MSG_MAC_ADDR_DP,            0, COMPACT_DP_NO_GUID },
+  { HARDWARE_DEVICE_PATH,  HW_VENDOR_DP,               0, 0                  },
+  { MESSAGING_DEVICE_PATH, MSG_VENDOR_DP,              0, 0                  },
+  { MEDIA_DEVICE_PATH,     MEDIA_VENDOR_DP,            0, 0                  },
+  { MEDIA_DEVICE_PATH,     MEDIA_HARDDRIVE_DP,         0, 20                 },
+  { MEDIA_DEVICE_PATH,     MEDIA_FILEPATH_DP,          0, COMPACT_DP_NO_GUID },
+  { MEDIA_DEVICE_PATH,     MEDIA_PIWG_FW_VOL_DP,       0, 0                  },
+  { MEDIA_DEVICE_PATH,     MEDIA_PIWG_FW_FILE_DP,      0, 0                  },
+  { MESSAGING_DEVICE_PATH, MSG_SCSI_DP,                0, COMPACT_DP_NO_GUID },
+  { MESSAGING_DEVICE_PATH, MSG_DEVICE_LOGICAL_UNIT_DP, 0, COMPACT_DP_NO_GUID }
+};
+
+// InternalWriteBytes
+STATIC
+VOID
+InternalWriteBytes (
+  IN OUT COMPACT_DP_WRITER  *Writer,
+  IN     CONST VOID         *Data,
+  IN     UINTN              Size
+  )
+{
+  if ((Writer->Offset <= Writer->Size)
+   && (Size <= (Writer->Size - Writer->Offset))) {
+    CopyMem ((VOID *)&Writer->Buffer[Writer->Offset], Data, Size);
+  }
+
+  Writer->Offset += Size;
+}
+
+// InternalWriteByte
+STATIC
+VOID
+InternalWriteByte (
+  IN OUT COMPACT_DP_WRITER  *Writer,
+  IN     UINT8              Value
+  )
+{
+  InternalWriteBytes (Writer, (VOID *)&Value, sizeof (Value));
+}
+
+// InternalWriteVarint
+STATIC
+VOID
+InternalWriteVarint (
+  IN OUT COMPACT_DP_WRITER  *Writer,
+  IN     UINTN              Value
+  )
+{
+  UINT8 Byte;
+
+  ASSERT (Value <= MAX_UINT16);
+
+  do {
+    Byte    = (UINT8)(Value & 0x7F);
+    Value >>= 7;
+
+    if (Value != 0) {
+      Byte |= 0x80;
+    }
+
+    InternalWriteByte (Writer, Byte);
+  } while (Value != 0);
+}
+
+// InternalWriteNodeHeader
+STATIC
+VOID
+InternalWriteNodeHeader (
+  IN OUT COMPACT_DP_WRITER  *Writer,
+  IN     UINT8              Type,
+  IN     UINT8              SubType,
+  IN     UINTN              Size
+  )
+{
+  EFI_DEVICE_PATH_PROTOCOL Header;
+
+  ASSERT (Size <= MAX_UINT16);
+
+  Header.Type    = Type;
+  Header.SubType = SubType;
+
+  SetDevicePathNodeLength ((VOID *)&Header, Size);
+  InternalWriteBytes (Writer, (VOID *)&Header, sizeof (Header));
+}
+
+// InternalReadBytes
+/** Consumes bytes from a reader.
+
+  @return  Returned are the bytes consumed or NULL if the reader holds less
+           than Size bytes.
+**/
+STATIC
+CONST UINT8 *
+InternalReadBytes (
+  IN OUT COMPACT_DP_READER  *Reader,
+  IN     UINTN              Size
+  )
+{
+  CONST UINT8 *Bytes;
+
+  Bytes = NULL;
+
+  if (Size <= (Reader->Size - Reader->Offset)) {
+    Bytes           = &Reader->Buffer[Reader->Offset];
+    Reader->Offset += Size;
+  }
+
+  return Bytes;
+}
+
+// InternalReadByte
+STATIC
+BOOLEAN
+InternalReadByte (
+  IN OUT COMPACT_DP_READER  *Reader,
+  OUT    UINT8              *Value
+  )
+{
+  CONST UINT8 *Byte;
+
+  Byte = InternalReadBytes (Reader, sizeof (*Value));
+
+  if (Byte != NULL) {
+    *Value = *Byte;
+  }
+
+  return (BOOLEAN)(Byte != NULL);
+}
+
+// InternalReadVarint
+/** Consumes a varint from a reader.
+
+  @return  Returned is whether a well-formed varint not exceeding MAX_UINT16
+           has been read.
+**/
+STATIC
+BOOLEAN
+InternalReadVarint (
+  IN OUT COMPACT_DP_READER  *Reader,
+  OUT    UINTN              *Value
+  )
+{
+  BOOLEAN Result;
+
+  UINTN   Index;
+  UINT8   Byte;
+
+  Result = FALSE;
+  *Value = 0;
+
+  for (Index = 0; Index < MISC_COMPACT_DP_MAX_VARINT_SIZE; ++Index) {
+    if (!InternalReadByte (Reader, &Byte)) {
+      break;
+    }
+
+    *Value |= ((UINTN)(Byte & 0x7F) << (7 * Index));
+
+    if ((Byte & 0x80) == 0) {
+      Result = (BOOLEAN)(*Value <= MAX_UINT16);
+      break;
+    }
+  }
+
+  return Result;
+}
+
+// InternalMatchDictionary
+/** Finds the dictionary entry describing a node.
+
+  @param[in]  Node           The node to describe.
+  @param[in]  Guids          The GUIDs referenced so far.
+  @param[in]  NumberOfGuids  The number of GUIDs referenced so far.
+  @param[out] GuidIndex      The index of the node's GUID in Guids, or
+                             NumberOfGuids if it has not been referenced yet.
+
+  @return  Returned is the matching entry or NULL if the node has to be
+           stored as literal.
+**/
+STATIC
+CONST COMPACT_DP_DICTIONARY_ENTRY *
+InternalMatchDictionary (
+  IN  CONST EFI_DEVICE_PATH_PROTOCOL  *Node,
+  IN  CONST UINT8                     **Guids,
+  IN  UINTN                           NumberOfGuids,
+  OUT UINTN                           *GuidIndex
+  )
+{
+  CONST COMPACT_DP_DICTIONARY_ENTRY *Match;
+
+  CONST COMPACT_DP_DICTIONARY_ENTRY *Entry;
+  CONST UINT8                       *Data;
+  UINTN                             DataSize;
+  CONST UINT8                       *Guid;
+
+  Match    = NULL;
+  Data     = (CONST UINT8 *)(Node + 1);
+  DataSize = (DevicePathNodeLength ((CONST VOID *)Node) - sizeof (*Node));
+
+  for (
+    Entry = &mDictionary[0];
+    Entry < &mDictionary[ARRAY_SIZE (mDictionary)];
+    ++Entry
+    ) {
+    if ((Entry->Type == DevicePathType ((CONST VOID *)Node))
+     && (Entry->SubType == DevicePathSubType ((CONST VOID *)Node))
+     && (DataSize >= Entry->PrefixSize)
+     && (CompareMem (Data, Entry->Prefix, Entry->PrefixSize) == 0)) {
+      if (Entry->GuidOffset == COMPACT_DP_NO_GUID) {
+        Match = Entry;
+      } else if ((DataSize - Entry->PrefixSize)
+                   >= (Entry->GuidOffset + sizeof (GUID))) {
+        Guid = &Data[Entry->PrefixSize + Entry->GuidOffset];
+
+        for (*GuidIndex = 0; *GuidIndex < NumberOfGuids; ++*GuidIndex) {
+          if (CompareMem (Guids[*GuidIndex], Guid, sizeof (GUID)) == 0) {
+            break;
+          }
+        }
+
+        // Store the node as literal when no more GUIDs can be referenced.
+        if (*GuidIndex < MISC_COMPACT_DP_MAX_GUIDS) {
+          Match = Entry;
+        }
+      }
+
+      break;
+    }
+  }
+
+  return Match;
+}
+
+// InternalIsNarrowPath
+/** Determines whether a file path node can be stored with one byte per
+    character.
+**/
+STATIC
+BOOLEAN
+InternalIsNarrowPath (
+  IN CONST EFI_DEVICE_PATH_PROTOCOL  *Node
+  )
+{
+  BOOLEAN     Narrow;
+
+  CONST UINT8 *Data;
+  UINTN       DataSize;
+  UINTN       Index;
+
+  Narrow = FALSE;
+
+  if ((DevicePathType ((CONST VOID *)Node) == MEDIA_DEVICE_PATH)
+   && (DevicePathSubType ((CONST VOID *)Node) == MEDIA_FILEPATH_DP)) {
+    Data     = (CONST UINT8 *)(Node + 1);
+    DataSize = (DevicePathNodeLength ((CONST VOID *)Node) - sizeof (*Node));
+    Narrow   = (BOOLEAN)((DataSize % sizeof (CHAR16)) == 0);
+
+    // The node's data may be unaligned, check the characters' high bytes.
+    for (Index = 1; Narrow && (Index < DataSize); Index += sizeof (CHAR16)) {
+      Narrow = (BOOLEAN)(Data[Index] == 0);
+    }
+  }
+
+  return Narrow;
+}
+
+// InternalEncodeNode
+STATIC
+VOID
+InternalEncodeNode (
+  IN OUT COMPACT_DP_WRITER               *Writer,
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *Node,
+  IN OUT CONST UINT8                     **Guids,
+  IN OUT UINTN                           *NumberOfGuids
+  )
+{
+  CONST COMPACT_DP_DICTIONARY_ENTRY *Entry;
+  CONST UINT8                       *Data;
+  UINTN                             DataSize;
+  UINTN                             GuidIndex;
+  UINTN                             GuidEnd;
+  UINTN                             Index;
+  BOOLEAN                           Narrow;
+
+  Data     = (CONST UINT8 *)(Node + 1);
+  DataSize = (DevicePathNodeLength ((CONST VOID *)Node) - sizeof (*Node));
+  Narrow   = InternalIsNarrowPath (Node);
+  Entry    = NULL;
+
+  if (!Narrow) {
+    Entry = InternalMatchDictionary (Node, Guids, *NumberOfGuids, &GuidIndex);
+  }
+
+  if (Narrow) {
+    InternalWriteByte (Writer, MISC_COMPACT_DP_NARROW_PATH);
+    InternalWriteVarint (Writer, (DataSize / sizeof (CHAR16)));
+
+    for (Index = 0; Index < DataSize; Index += sizeof (CHAR16)) {
+      InternalWriteByte (Writer, Data[Index]);
+    }
+  } else if (Entry == NULL) {
+    InternalWriteByte (Writer, MISC_COMPACT_DP_LITERAL);
+    InternalWriteByte (Writer, DevicePathType ((CONST VOID *)Node));
+    InternalWriteByte (Writer, DevicePathSubType ((CONST VOID *)Node));
+    InternalWriteVarint (Writer, DataSize);
+    InternalWriteBytes (Writer, (CONST VOID *)Data, DataSize);
+  } else {
+    Data     += Entry->PrefixSize;
+    DataSize -= Entry->PrefixSize;
+
+    InternalWriteByte (
+      Writer,
+      (UINT8)(MISC_COMPACT_DP_DICTIONARY + (Entry - &mDictionary[0]))
+      );
+
+    if (Entry->GuidOffset == COMPACT_DP_NO_GUID) {
+      InternalWriteVarint (Writer, DataSize);
+      InternalWriteBytes (Writer, (CONST VOID *)Data, DataSize);
+    } else {
+      GuidEnd = (Entry->GuidOffset + sizeof (GUID));
+
+      InternalWriteVarint (Writer, (DataSize - sizeof (GUID)));
+      InternalWriteVarint (Writer, GuidIndex);
+
+      if (GuidIndex == *NumberOfGuids) {
+        Guids[GuidIndex] = &Data[Entry->GuidOffset];
+        ++(*NumberOfGuids);
+
+        InternalWriteBytes (
+          Writer,
+          (CONST VOID *)Guids[GuidIndex],
+          sizeof (GUID)
+          );
+      }
+
+      InternalWriteBytes (Writer, (CONST VOID *)Data, Entry->GuidOffset);
+      InternalWriteBytes (
+        Writer,
+        (CONST VOID *)&Data[GuidEnd],
+        (DataSize - GuidEnd)
+        );
+    }
+  }
+}
+
+// MiscEncodeCompactDevicePath
+/** Encodes a device path in the compact form for storage in NVRAM.
+
+  Nodes described by the dictionary are stored without their type and the
+  leading bytes of their data, GUIDs are stored only once, file paths are
+  stored with one byte per character where possible and lengths are stored
+  as varints.
+
+  @param[in]      DevicePath  The device path to encode.
+  @param[in, out] BufferSize  On input, the size, in bytes, of Buffer.  On
+                              output, the size of the compact device path.
+  @param[out]     Buffer      The buffer to encode the device path into.
+
+  @retval EFI_SUCCESS            The device path has been encoded.
+  @retval EFI_BUFFER_TOO_SMALL   Buffer is too small, BufferSize has been
+                                 updated with the size needed.
+  @retval EFI_INVALID_PARAMETER  A node of DevicePath is shorter than its
+                                 header.
+**/
+EFI_STATUS
+MiscEncodeCompactDevicePath (
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN OUT UINTN                           *BufferSize,
+  OUT    VOID                            *Buffer OPTIONAL
+  )
+{
+  EFI_STATUS                     Status;
+
+  COMPACT_DP_WRITER              Writer;
+  CONST UINT8                    *Guids[MISC_COMPACT_DP_MAX_GUIDS];
+  UINTN                          NumberOfGuids;
+  CONST EFI_DEVICE_PATH_PROTOCOL *Node;
+
+  ASSERT (DevicePath != NULL);
+  ASSERT (BufferSize != NULL);
+  ASSERT ((Buffer != NULL) || (*BufferSize == 0));
+
+  Status        = EFI_SUCCESS;
+  Writer.Buffer = (UINT8 *)Buffer;
+  Writer.Size   = *BufferSize;
+  Writer.Offset = 0;
+  NumberOfGuids = 0;
+
+  InternalWriteByte (&Writer, MISC_COMPACT_DEVICE_PATH_REVISION);
+
+  for (
+    Node = DevicePath;
+    !IsDevicePathEnd ((CONST VOID *)Node);
+    Node = NextDevicePathNode ((CONST VOID *)Node)
+    ) {
+    // A short node would make the walk loop or step backwards.
+    if (DevicePathNodeLength ((CONST VOID *)Node) < sizeof (*Node)) {
+      Status = EFI_INVALID_PARAMETER;
+      break;
+    }
+
+    if (IsDevicePathEndInstance ((CONST VOID *)Node)
+     && (DevicePathNodeLength ((CONST VOID *)Node) == sizeof (*Node))) {
+      InternalWriteByte (&Writer, MISC_COMPACT_DP_END_INSTANCE);
+    } else {
+      InternalEncodeNode (&Writer, Node, Guids, &NumberOfGuids);
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    InternalWriteByte (&Writer, MISC_COMPACT_DP_END_ENTIRE);
+
+    Status = ((Writer.Offset <= *BufferSize)
+                ? EFI_SUCCESS
+                : EFI_BUFFER_TOO_SMALL);
+
+    *BufferSize = Writer.Offset;
+  }
+
+  return Status;
+}
+
+// InternalDecodeDictionaryNode
+/** Decodes a node described by a dictionary entry.
+
+  @return  Returned is whether the node is well-formed.
+**/
+STATIC
+BOOLEAN
+InternalDecodeDictionaryNode (
+  IN OUT COMPACT_DP_READER                  *Reader,
+  IN OUT COMPACT_DP_WRITER                  *Writer,
+  IN     CONST COMPACT_DP_DICTIONARY_ENTRY  *Entry,
+  IN OUT CONST UINT8                        **Guids,
+  IN OUT UINTN                              *NumberOfGuids
+  )
+{
+  BOOLEAN     Result;
+
+  UINTN       RestSize;
+  UINTN       GuidIndex;
+  CONST UINT8 *Guid;
+  CONST UINT8 *Rest;
+  UINTN       NodeSize;
+
+  Result    = FALSE;
+  Guid      = NULL;
+  GuidIndex = 0;
+
+  if (InternalReadVarint (Reader, &RestSize)) {
+    NodeSize = (sizeof (EFI_DEVICE_PATH_PROTOCOL)
+                  + Entry->PrefixSize
+                  + RestSize);
+
+    if (Entry->GuidOffset != COMPACT_DP_NO_GUID) {
+      NodeSize += sizeof (GUID);
+
+      if ((RestSize >= Entry->GuidOffset)
+       && InternalReadVarint (Reader, &GuidIndex)) {
+        if (GuidIndex < *NumberOfGuids) {
+          Guid = Guids[GuidIndex];
+        } else if ((GuidIndex == *NumberOfGuids)
+                && (GuidIndex < MISC_COMPACT_DP_MAX_GUIDS)) {
+          Guid = InternalReadBytes (Reader, sizeof (GUID));
+
+          if (Guid != NULL) {
+            Guids[GuidIndex] = Guid;
+            ++(*NumberOfGuids);
+          }
+        }
+      }
+    }
+
+    Rest = InternalReadBytes (Reader, RestSize);
+
+    if ((Rest != NULL)
+     && (NodeSize <= MAX_UINT16)
+     && ((Entry->GuidOffset == COMPACT_DP_NO_GUID) || (Guid != NULL))) {
+      InternalWriteNodeHeader (
+        Writer,
+        Entry->Type,
+        Entry->SubType,
+        NodeSize
+        );
+
+      InternalWriteBytes (
+        Writer,
+        (CONST VOID *)Entry->Prefix,
+        Entry->PrefixSize
+        );
+
+      if (Guid == NULL) {
+        InternalWriteBytes (Writer, (CONST VOID *)Rest, RestSize);
+      } else {
+        InternalWriteBytes (Writer, (CONST VOID *)Rest, Entry->GuidOffset);
+        InternalWriteBytes (Writer, (CONST VOID *)Guid, sizeof (GUID));
+        InternalWriteBytes (
+          Writer,
+          (CONST VOID *)&Rest[Entry->GuidOffset],
+          (RestSize - Entry->GuidOffset)
+          );
+      }
+
+      Result = TRUE;
+    }
+  }
+
+  return Result;
+}
+
+// InternalDecodeLiteralNode
+/** Decodes a node stored as literal.
+
+  @return  Returned is whether the node is well-formed.
+**/
+STATIC
+BOOLEAN
+InternalDecodeLiteralNode (
+  IN OUT COMPACT_DP_READER  *Reader,
+  IN OUT COMPACT_DP_WRITER  *Writer
+  )
+{
+  BOOLEAN     Result;
+
+  UINT8       Type;
+  UINT8       SubType;
+  UINTN       DataSize;
+  CONST UINT8 *Data;
+
+  Result = FALSE;
+
+  if (InternalReadByte (Reader, &Type)
+   && InternalReadByte (Reader, &SubType)
+   && InternalReadVarint (Reader, &DataSize)) {
+    Data = InternalReadBytes (Reader, DataSize);
+
+    if ((Data != NULL)
+     && (DataSize <= (MAX_UINT16 - sizeof (EFI_DEVICE_PATH_PROTOCOL)))) {
+      InternalWriteNodeHeader (
+        Writer,
+        Type,
+        SubType,
+        (sizeof (EFI_DEVICE_PATH_PROTOCOL) + DataSize)
+        );
+
+      InternalWriteBytes (Writer, (CONST VOID *)Data, DataSize);
+
+      Result = TRUE;
+    }
+  }
+
+  return Result;
+}
+
+// InternalDecodeNarrowPath
+/** Decodes a file path node stored with one byte per character.
+
+  @return  Returned is whether the node is well-formed.
+**/
+STATIC
+BOOLEAN
+InternalDecodeNarrowPath (
+  IN OUT COMPACT_DP_READER  *Reader,
+  IN OUT COMPACT_DP_WRITER  *Writer
+  )
+{
+  BOOLEAN     Result;
+
+  UINTN       Length;
+  CONST UINT8 *Chars;
+  UINTN       Index;
+  CHAR16      Char;
+
+  Result = FALSE;
+
+  if (InternalReadVarint (Reader, &Length)) {
+    Chars = InternalReadBytes (Reader, Length);
+
+    if ((Chars != NULL)
+     && (Length <= ((MAX_UINT16 - sizeof (EFI_DEVICE_PATH_PROTOCOL))
+                      / sizeof (CHAR16)))) {
+      InternalWriteNodeHeader (
+        Writer,
+        MEDIA_DEVICE_PATH,
+        MEDIA_FILEPATH_DP,
+        (sizeof (EFI_DEVICE_PATH_PROTOCOL) + (Length * sizeof (CHAR16)))
+        );
+
+      for (Index = 0; Index < Length; ++Index) {
+        Char = Chars[Index];
+        InternalWriteBytes (Writer, (CONST VOID *)&Char, sizeof (Char));
+      }
+
+      Result = TRUE;
+    }
+  }
+
+  return Result;
+}
+
+// MiscDecodeCompactDevicePath
+/** Decodes a compact device path, e.g. read from NVRAM.
+
+  The compact device path is fully validated, so it may come from untrusted
+  storage.
+
+  @param[in]      Data        The compact device path to decode.
+  @param[in]      DataSize    The size, in bytes, of Data.
+  @param[in, out] BufferSize  On input, the size, in bytes, of DevicePath.
+                              On output, the size of the device path.
+  @param[out]     DevicePath  The buffer to decode the device path into.
+
+  @retval EFI_SUCCESS            The device path has been decoded.
+  @retval EFI_BUFFER_TOO_SMALL   DevicePath is too small, BufferSize has been
+                                 updated with the size needed.
+  @retval EFI_UNSUPPORTED        Data is of an unsupported revision.
+  @retval EFI_INVALID_PARAMETER  Data is malformed.
+**/
+EFI_STATUS
+MiscDecodeCompactDevicePath (
+  IN     CONST VOID                *Data,
+  IN     UINTN                     DataSize,
+  IN OUT UINTN                     *BufferSize,
+  OUT    EFI_DEVICE_PATH_PROTOCOL  *DevicePath OPTIONAL
+  )
+{
+  EFI_STATUS        Status;
+
+  COMPACT_DP_READER Reader;
+  COMPACT_DP_WRITER Writer;
+  CONST UINT8       *Guids[MISC_COMPACT_DP_MAX_GUIDS];
+  UINTN             NumberOfGuids;
+  UINT8             Code;
+  BOOLEAN           Valid;
+
+  ASSERT (Data != NULL);
+  ASSERT (BufferSize != NULL);
+  ASSERT ((DevicePath != NULL) || (*BufferSize == 0));
+
+  Reader.Buffer = (CONST UINT8 *)Data;
+  Reader.Size   = DataSize;
+  Reader.Offset = 0;
+  Writer.Buffer = (UINT8 *)DevicePath;
+  Writer.Size   = *BufferSize;
+  Writer.Offset = 0;
+  NumberOfGuids = 0;
+  Status        = EFI_INVALID_PARAMETER;
+
+  if (InternalReadByte (&Reader, &Code)) {
+    Status = EFI_UNSUPPORTED;
+
+    if (Code == MISC_COMPACT_DEVICE_PATH_REVISION) {
+      do {
+        Valid = InternalReadByte (&Reader, &Code);
+
+        if (!Valid) {
+          break;
+        }
+
+        if (Code == MISC_COMPACT_DP_END_ENTIRE) {
+          InternalWriteNodeHeader (
+            &Writer,
+            END_DEVICE_PATH_TYPE,
+            END_ENTIRE_DEVICE_PATH_SUBTYPE,
+            sizeof (EFI_DEVICE_PATH_PROTOCOL)
+            );
+        } else if (Code == MISC_COMPACT_DP_END_INSTANCE) {
+          InternalWriteNodeHeader (
+            &Writer,
+            END_DEVICE_PATH_TYPE,
+            END_INSTANCE_DEVICE_PATH_SUBTYPE,
+            sizeof (EFI_DEVICE_PATH_PROTOCOL)
+            );
+        } else if (Code == MISC_COMPACT_DP_LITERAL) {
+          Valid = InternalDecodeLiteralNode (&Reader, &Writer);
+        } else if (Code == MISC_COMPACT_DP_NARROW_PATH) {
+          Valid = InternalDecodeNarrowPath (&Reader, &Writer);
+        } else if ((Code >= MISC_COMPACT_DP_DICTIONARY)
+                && ((Code - MISC_COMPACT_DP_DICTIONARY)
+                      < ARRAY_SIZE (mDictionary))) {
+          Valid = InternalDecodeDictionaryNode (
+                    &Reader,
+                    &Writer,
+                    &mDictionary[Code - MISC_COMPACT_DP_DICTIONARY],
+                    Guids,
+                    &NumberOfGuids
+                    );
+        } else {
+          Valid = FALSE;
+        }
+      } while (Valid && (Code != MISC_COMPACT_DP_END_ENTIRE));
+
+      Status = EFI_INVALID_PARAMETER;
+
+      if (Valid && (Reader.Offset == Reader.Size)) {
+        Status = ((Writer.Offset <= *BufferSize)
+                    ? EFI_SUCCESS
+                    : EFI_BUFFER_TOO_SMALL);
+
+        *BufferSize = Writer.Offset;
+      }
+    }
+  }
+
+  return Status;
+}
@@ -0,0 +1,420 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscDevicePathLib.h>
+
+// DEVICE_PATH_INTERN_ENTRY_SIGNATURE
+#define DEVICE_PATH_INTERN_ENTRY_SIGNATURE  SIGNATURE_32 ('D', 'P', 'I', 'E')
+
+// DEVICE_PATH_INTERN_ENTRY_FROM_LINK
+#define DEVICE_PATH_INTERN_ENTRY_FROM_LINK(Entry)  \
+  CR (                                             \
+    (Entry),                                       \
+    DEVICE_PATH_INTERN_ENTRY,                      \
+    Link,                                          \
+    DEVICE_PATH_INTERN_ENTRY_SIGNATURE             \
+    )
+
+// DEVICE_PATH_INTERN_INITIAL_BUCKETS
+#define DEVICE_PATH_INTERN_INITIAL_BUCKETS  64
+
+// DEVICE_PATH_INTERN_ENTRY
+/// The device path is stored right after the entry.
+typedef struct {
+  UINT32                    Signature;
+  LIST_ENTRY                Link;
+  MISC_INTERNED_DEVICE_PATH Public;
+} DEVICE_PATH_INTERN_ENTRY;
+
+// MISC_DEVICE_PATH_INTERN_TABLE
+struct MISC_DEVICE_PATH_INTERN_TABLE {
+  UINTN      NumberOfEntries;
+  UINTN      NumberOfBuckets;       ///< Always a power of two.
+  LIST_ENTRY *Buckets;
+};
+
+// MiscHashDevicePath
+/** Hashes a device path and determines its size in the same pass.
+
+  The node lengths are validated while walking, so DevicePath may come from
+  an untrusted source such as a variable.
+
+  @param[in]  DevicePath  The device path to hash.
+  @param[in]  MaxSize     The maximum size, in bytes, of DevicePath or 0 for
+                          no limit.
+  @param[out] Hash        The 64-bit FNV-1a hash of DevicePath's bytes.
+  @param[out] Size        Optional, the size, in bytes, of DevicePath,
+                          including the end node.
+
+  @retval EFI_SUCCESS            DevicePath has been hashed.
+  @retval EFI_INVALID_PARAMETER  A node is shorter than its header or
+                                 DevicePath exceeds MaxSize.
+**/
+EFI_STATUS
+MiscHashDevicePath (
+  IN  CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN  UINTN                           MaxSize,
+  OUT UINT64                          *Hash,
+  OUT UINTN                           *Size OPTIONAL
+  )
+{
+  EFI_STATUS  Status;
+
+  UINT64      NewHash;
+  CONST UINT8 *Bytes;
+  UINTN       NodeSize;
+  UINTN       TotalSize;
+  UINTN       Index;
+
+  ASSERT (DevicePath != NULL);
+  ASSERT (Hash != NULL);
+
+  if (MaxSize == 0) {
+    MaxSize = MAX_UINTN;
+  }
+
+  Status    = EFI_SUCCESS;
+  NewHash   = 0xCBF29CE484222325ULL;
+  TotalSize = 0;
+  Bytes     = (CONST UINT8 *)DevicePath;
+
+  do {
+    // The header must fit before its length can be read.
+    if ((MaxSize - TotalSize) < sizeof (EFI_DEVICE_PATH_PROTOCOL)) {
+      Status = EFI_INVALID_PARAMETER;
+      break;
+    }
+
+    NodeSize = DevicePathNodeLength ((CONST VOID *)Bytes);
+
+    if ((NodeSize < sizeof (EFI_DEVICE_PATH_PROTOCOL))
+     || (NodeSize > (MaxSize - TotalSize))) {
+      Status = EFI_INVALID_PARAMETER;
+      break;
+    }
+
+    for (Index = 0; Index < NodeSize; ++Index) {
+      NewHash = MultU64x64 ((NewHash ^ Bytes[Index]), 0x00000100000001B3ULL);
+    }
+
+    TotalSize += NodeSize;
+    Bytes     += NodeSize;
+  } while (!IsDevicePathEnd ((CONST VOID *)(Bytes - NodeSize)));
+
+  if (!EFI_ERROR (Status)) {
+    *Hash = NewHash;
+
+    if (Size != NULL) {
+      *Size = TotalSize;
+    }
+  }
+
+  return Status;
+}
+
+// InternalFindInterned
+STATIC
+DEVICE_PATH_INTERN_ENTRY *
+InternalFindInterned (
+  IN CONST MISC_DEVICE_PATH_INTERN_TABLE  *Table,
+  IN CONST EFI_DEVICE_PATH_PROTOCOL       *DevicePath,
+  IN UINT64                               Hash,
+  IN UINTN                                Size
+  )
+{
+  DEVICE_PATH_INTERN_ENTRY *Entry;
+
+  LIST_ENTRY               *Bucket;
+  LIST_ENTRY               *Link;
+  DEVICE_PATH_INTERN_ENTRY *Candidate;
+
+  Entry  = NULL;
+  Bucket = &Table->Buckets[(UINTN)Hash & (Table->NumberOfBuckets - 1)];
+
+  for (
+    Link = GetFirstNode (Bucket);
+    !IsNull (Bucket, Link);
+    Link = GetNextNode (Bucket, Link)
+    ) {
+    Candidate = DEVICE_PATH_INTERN_ENTRY_FROM_LINK (Link);
+
+    if ((Candidate->Public.Hash == Hash)
+     && (Candidate->Public.Size == Size)
+     && (CompareMem (
+           (VOID *)Candidate->Public.DevicePath,
+           (VOID *)DevicePath,
+           Size
+           ) == 0)) {
+      Entry = Candidate;
+      break;
+    }
+  }
+
+  return Entry;
+}
+
+// InternalGrowInternTable
+/** Doubles the number of buckets of an intern table.
+
+  Failing to grow only lengthens the chains, so it is not reported.
+**/
+STATIC
+VOID
+InternalGrowInternTable (
+  IN OUT MISC_DEVICE_PATH_INTERN_TABLE  *Table
+  )
+{
+  LIST_ENTRY               *Buckets;
+  UINTN                    NumberOfBuckets;
+  UINTN                    Index;
+  LIST_ENTRY               *Link;
+  DEVICE_PATH_INTERN_ENTRY *Entry;
+
+  NumberOfBuckets = (Table->NumberOfBuckets * 2);
+  Buckets         = AllocatePool (NumberOfBuckets * sizeof (*Buckets));
+
+  if (Buckets != NULL) {
+    for (Index = 0; Index < NumberOfBuckets; ++Index) {
+      InitializeListHead (&Buckets[Index]);
+    }
+
+    for (Index = 0; Index < Table->NumberOfBuckets; ++Index) {
+      while (!IsListEmpty (&Table->Buckets[Index])) {
+        Link  = GetFirstNode (&Table->Buckets[Index]);
+        Entry = DEVICE_PATH_INTERN_ENTRY_FROM_LINK (Link);
+
+        RemoveEntryList (Link);
+        InsertTailList (
+          &Buckets[(UINTN)Entry->Public.Hash & (NumberOfBuckets - 1)],
+          Link
+          );
+      }
+    }
+
+    FreePool ((VOID *)Table->Buckets);
+
+    Table->Buckets         = Buckets;
+    Table->NumberOfBuckets = NumberOfBuckets;
+  }
+}
+
+// MiscCreateDevicePathInternTable
+/** Creates an empty device path intern table.
+
+  @param[out] Table  The created table.  Destroy with
+                     MiscDestroyDevicePathInternTable().
+
+  @retval EFI_SUCCESS           The table has been created.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+**/
+EFI_STATUS
+MiscCreateDevicePathInternTable (
+  OUT MISC_DEVICE_PATH_INTERN_TABLE  **Table
+  )
+{
+  EFI_STATUS                    Status;
+
+  MISC_DEVICE_PATH_INTERN_TABLE *NewTable;
+  UINTN                         Index;
+
+  ASSERT (Table != NULL);
+
+  NewTable = AllocatePool (sizeof (*NewTable));
+  Status   = EFI_OUT_OF_RESOURCES;
+
+  if (NewTable != NULL) {
+    NewTable->NumberOfEntries = 0;
+    NewTable->NumberOfBuckets = DEVICE_PATH_INTERN_INITIAL_BUCKETS;
+    NewTable->Buckets         = AllocatePool (
+                                  DEVICE_PATH_INTERN_INITIAL_BUCKETS
+                                    * sizeof (*NewTable->Buckets)
+                                  );
+
+    if (NewTable->Buckets != NULL) {
+      for (Index = 0; Index < DEVICE_PATH_INTERN_INITIAL_BUCKETS; ++Index) {
+        InitializeListHead (&NewTable->Buckets[Index]);
+      }
+
+      *Table = NewTable;
+      Status = EFI_SUCCESS;
+    } else {
+      FreePool ((VOID *)NewTable);
+    }
+  }
+
+  return Status;
+}
+
+// MiscDestroyDevicePathInternTable
+/** Destroys an intern table and all device paths interned into it.
+
+  @param[in] Table  The table to destroy.
+**/
+VOID
+MiscDestroyDevicePathInternTable (
+  IN MISC_DEVICE_PATH_INTERN_TABLE  *Table
+  )
+{
+  UINTN                    Index;
+  LIST_ENTRY               *Link;
+  DEVICE_PATH_INTERN_ENTRY *Entry;
+
+  ASSERT (Table != NULL);
+
+  for (Index = 0; Index < Table->NumberOfBuckets; ++Index) {
+    while (!IsListEmpty (&Table->Buckets[Index])) {
+      Link  = GetFirstNode (&Table->Buckets[Index]);
+      Entry = DEVICE_PATH_INTERN_ENTRY_FROM_LINK (Link);
+
+      RemoveEntryList (Link);
+      FreePool ((VOID *)Entry);
+    }
+  }
+
+  FreePool ((VOID *)Table->Buckets);
+  FreePool ((VOID *)Table);
+}
+
+// MiscLookupDevicePath
+/** Looks up a device path in an intern table without interning it.
+
+  @param[in]  Table       The table to look up in.
+  @param[in]  DevicePath  The device path to look up.
+  @param[in]  MaxSize     The maximum size, in bytes, of DevicePath or 0 for
+                          no limit.
+  @param[out] Interned    The interned device path equal to DevicePath.
+
+  @retval EFI_SUCCESS            DevicePath has been interned before.
+  @retval EFI_NOT_FOUND          DevicePath has not been interned.
+  @retval EFI_INVALID_PARAMETER  DevicePath is malformed or exceeds MaxSize.
+**/
+EFI_STATUS
+MiscLookupDevicePath (
+  IN  CONST MISC_DEVICE_PATH_INTERN_TABLE  *Table,
+  IN  CONST EFI_DEVICE_PATH_PROTOCOL       *DevicePath,
+  IN  UINTN                                MaxSize,
+  OUT CONST MISC_INTERNED_DEVICE_PATH      **Interned
+  )
+{
+  EFI_STATUS               Status;
+
+  UINT64                   Hash;
+  UINTN                    Size;
+  DEVICE_PATH_INTERN_ENTRY *Entry;
+
+  ASSERT (Table != NULL);
+  ASSERT (DevicePath != NULL);
+  ASSERT (Interned != NULL);
+
+  Status = MiscHashDevicePath (DevicePath, MaxSize, &Hash, &Size);
+
+  if (!EFI_ERROR (Status)) {
+    Entry  = InternalFindInterned (Table, DevicePath, Hash, Size);
+    Status = EFI_NOT_FOUND;
+
+    if (Entry != NULL) {
+      *Interned = &Entry->Public;
+      Status    = EFI_SUCCESS;
+    }
+  }
+
+  return Status;
+}
+
+// MiscInternDevicePath
+/** Interns a device path.
+
+  Each distinct device path is stored once per table, so interned device
+  paths of the same table are equal exactly when their pointers are.  They
+  stay valid until the table is destroyed.
+
+  @param[in]  Table       The table to intern into.
+  @param[in]  DevicePath  The device path to intern.  It is copied, so the
+                          caller keeps ownership.
+  @param[in]  MaxSize     The maximum size, in bytes, of DevicePath or 0 for
+                          no limit.
+  @param[out] Interned    The interned device path equal to DevicePath.
+
+  @retval EFI_SUCCESS            DevicePath has been interned.
+  @retval EFI_INVALID_PARAMETER  DevicePath is malformed or exceeds MaxSize.
+  @retval EFI_OUT_OF_RESOURCES   Memory allocation failed.
+**/
+EFI_STATUS
+MiscInternDevicePath (
+  IN OUT MISC_DEVICE_PATH_INTERN_TABLE   *Table,
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN     UINTN                           MaxSize,
+  OUT    CONST MISC_INTERNED_DEVICE_PATH **Interned
+  )
+{
+  EFI_STATUS               Status;
+
+  UINT64                   Hash;
+  UINTN                    Size;
+  DEVICE_PATH_INTERN_ENTRY *Entry;
+
+  ASSERT (Table != NULL);
+  ASSERT (DevicePath != NULL);
+  ASSERT (Interned != NULL);
+
+  Entry  = NULL;
+  Status = MiscHashDevicePath (DevicePath, MaxSize, &Hash, &Size);
+
+  if (!EFI_ERROR (Status)) {
+    Entry = InternalFindInterned (Table, DevicePath, Hash, Size);
+  }
+
+  if (!EFI_ERROR (Status) && (Entry == NULL)) {
+    Entry  = AllocatePool (sizeof (*Entry) + Size);
+    Status = EFI_OUT_OF_RESOURCES;
+
+    if (Entry != NULL) {
+      Entry->Signature         = DEVICE_PATH_INTERN_ENTRY_SIGNATURE;
+      Entry->Public.Hash       = Hash;
+      Entry->Public.Size       = Size;
+      Entry->Public.DevicePath = (EFI_DEVICE_PATH_PROTOCOL *)(Entry + 1);
+
+      CopyMem ((VOID *)(Entry + 1), (VOID *)DevicePath, Size);
+
+      // Keep the average chain length at two or below.
+      if (Table->NumberOfEntries >= (Table->NumberOfBuckets * 2)) {
+        InternalGrowInternTable (Table);
+      }
+
+      InsertTailList (
+        &Table->Buckets[(UINTN)Hash & (Table->NumberOfBuckets - 1)],
+        &Entry->Link
+        );
+
+      ++Table->NumberOfEntries;
+
+      Status = EFI_SUCCESS;
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    *Interned = &Entry->Public;
+  }
+
+  return Status;
+}
@@ -0,0 +1,213 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Protocol/DevicePath.h>
+
+#include <Library/DebugLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/MiscDevicePathLib.h>
+
+// InternalGetNodeKind
+/** Determines the typed view of a node.
+
+  @param[in]  Node  The node to inspect.
+  @param[in]  Size  The node's size.
+
+  @return  Returned is the node's kind or MiscDevicePathNodeOther if the node
+           is too short for its typed view.
+**/
+STATIC
+MISC_DEVICE_PATH_NODE_KIND
+InternalGetNodeKind (
+  IN CONST EFI_DEVICE_PATH_PROTOCOL  *Node,
+  IN UINTN                           Size
+  )
+{
+  MISC_DEVICE_PATH_NODE_KIND Kind;
+
+  Kind = MiscDevicePathNodeOther;
+
+  switch (DevicePathType ((CONST VOID *)Node)) {
+    case HARDWARE_DEVICE_PATH:
+    {
+      if ((DevicePathSubType ((CONST VOID *)Node) == HW_PCI_DP)
+       && (Size >= sizeof (PCI_DEVICE_PATH))) {
+        Kind = MiscDevicePathNodePci;
+      }
+
+      break;
+    }
+
+    case MESSAGING_DEVICE_PATH:
+    {
+      if ((DevicePathSubType ((CONST VOID *)Node) == MSG_USB_DP)
+       && (Size >= sizeof (USB_DEVICE_PATH))) {
+        Kind = MiscDevicePathNodeUsb;
+      }
+
+      break;
+    }
+
+    case MEDIA_DEVICE_PATH:
+    {
+      if ((DevicePathSubType ((CONST VOID *)Node) == MEDIA_HARDDRIVE_DP)
+       && (Size >= sizeof (HARDDRIVE_DEVICE_PATH))) {
+        Kind = MiscDevicePathNodeHardDrive;
+      } else if ((DevicePathSubType ((CONST VOID *)Node) == MEDIA_FILEPATH_DP)
+              && (((Size - SIZE_OF_FILEPATH_DEVICE_PATH) % sizeof (CHAR16))
+                    == 0)) {
+        Kind = MiscDevicePathNodeFilePath;
+      }
+
+      break;
+    }
+
+    default:
+    {
+      break;
+    }
+  }
+
+  return Kind;
+}
+
+// MiscInitDevicePathIterator
+/** Validates a device path and prepares iterating its nodes.
+
+  All node lengths are checked against the buffer once, so the nodes can be
+  walked without further bounds checks.
+
+  @param[out] Iterator    The iterator to initialize.
+  @param[in]  DevicePath  The device path to iterate.
+  @param[in]  MaxSize     The size, in bytes, of the buffer holding
+                          DevicePath.
+  @param[in]  Type        The type of the nodes to yield or
+                          MISC_DEVICE_PATH_ANY_TYPE.
+  @param[in]  SubType     The sub-type of the nodes to yield or
+                          MISC_DEVICE_PATH_ANY_TYPE.
+
+  @retval EFI_SUCCESS            The iterator has been initialized.
+  @retval EFI_INVALID_PARAMETER  DevicePath is malformed or exceeds MaxSize.
+**/
+EFI_STATUS
+MiscInitDevicePathIterator (
+  OUT MISC_DEVICE_PATH_ITERATOR       *Iterator,
+  IN  CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN  UINTN                           MaxSize,
+  IN  UINT8                           Type,
+  IN  UINT8                           SubType
+  )
+{
+  EFI_STATUS  Status;
+
+  CONST UINT8 *Node;
+  UINTN       Remaining;
+  UINTN       Size;
+
+  ASSERT (Iterator != NULL);
+  ASSERT (DevicePath != NULL);
+
+  Node      = (CONST UINT8 *)DevicePath;
+  Remaining = MaxSize;
+  Status    = EFI_INVALID_PARAMETER;
+
+  while (Remaining >= sizeof (EFI_DEVICE_PATH_PROTOCOL)) {
+    Size = DevicePathNodeLength ((CONST VOID *)Node);
+
+    if ((Size < sizeof (EFI_DEVICE_PATH_PROTOCOL)) || (Size > Remaining)) {
+      break;
+    }
+
+    if (IsDevicePathEnd ((CONST VOID *)Node)) {
+      Iterator->Current = (CONST EFI_DEVICE_PATH_PROTOCOL *)DevicePath;
+      Iterator->End     = (CONST EFI_DEVICE_PATH_PROTOCOL *)Node;
+      Iterator->Type    = Type;
+      Iterator->SubType = SubType;
+
+      Status = EFI_SUCCESS;
+      break;
+    }
+
+    Node      += Size;
+    Remaining -= Size;
+  }
+
+  return Status;
+}
+
+// MiscNextDevicePathNode
+/** Yields the next node matching the iterator's filter.
+
+  The end node of the device path is not yielded, end-of-instance nodes are.
+
+  @param[in, out] Iterator  The iterator to advance.
+  @param[out]     Node      The node yielded.
+
+  @return  Returned is whether a node has been yielded.
+**/
+BOOLEAN
+MiscNextDevicePathNode (
+  IN OUT MISC_DEVICE_PATH_ITERATOR  *Iterator,
+  OUT    MISC_DEVICE_PATH_NODE      *Node
+  )
+{
+  BOOLEAN                        Found;
+
+  CONST EFI_DEVICE_PATH_PROTOCOL *Current;
+  UINTN                          Size;
+
+  ASSERT (Iterator != NULL);
+  ASSERT (Node != NULL);
+
+  Found = FALSE;
+
+  while (Iterator->Current < Iterator->End) {
+    Current = Iterator->Current;
+    Size    = DevicePathNodeLength ((CONST VOID *)Current);
+
+    Iterator->Current = (CONST EFI_DEVICE_PATH_PROTOCOL *)(
+                          (CONST UINT8 *)Current + Size
+                          );
+
+    if (((Iterator->Type == MISC_DEVICE_PATH_ANY_TYPE)
+      || (Iterator->Type == DevicePathType ((CONST VOID *)Current)))
+     && ((Iterator->SubType == MISC_DEVICE_PATH_ANY_TYPE)
+      || (Iterator->SubType == DevicePathSubType ((CONST VOID *)Current)))) {
+      Node->View.Generic = Current;
+      Node->Size         = Size;
+      Node->Kind         = InternalGetNodeKind (Current, Size);
+      Node->PathLength   = 0;
+
+      if (Node->Kind == MiscDevicePathNodeFilePath) {
+        Node->PathLength = ((Size - SIZE_OF_FILEPATH_DEVICE_PATH)
+                             / sizeof (CHAR16));
+
+        // The terminator may be missing.
+        if ((Node->PathLength > 0)
+         && (Node->View.FilePath->PathName[Node->PathLength - 1] == L'\0')) {
+          --Node->PathLength;
+        }
+      }
+
+      Found = TRUE;
+      break;
+    }
+  }
+
+  return Found;
+}
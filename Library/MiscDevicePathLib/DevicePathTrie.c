@@ -0,0 +1,516 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Protocol/DevicePath.h>
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/EfiBootServicesLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscDevicePathLib.h>
+
+// DEVICE_PATH_TRIE_HANDLE
+typedef struct DEVICE_PATH_TRIE_HANDLE DEVICE_PATH_TRIE_HANDLE;
+
+struct DEVICE_PATH_TRIE_HANDLE {
+  DEVICE_PATH_TRIE_HANDLE *Next;
+  EFI_HANDLE              Handle;
+};
+
+// DEVICE_PATH_TRIE_NODE
+/// The device path node is stored right after the trie node.
+typedef struct DEVICE_PATH_TRIE_NODE DEVICE_PATH_TRIE_NODE;
+
+struct DEVICE_PATH_TRIE_NODE {
+  DEVICE_PATH_TRIE_NODE   *Sibling;
+  DEVICE_PATH_TRIE_NODE   *Child;
+  DEVICE_PATH_TRIE_HANDLE *Handles;   ///< The handles ending at this node.
+};
+
+// MISC_DEVICE_PATH_TRIE
+struct MISC_DEVICE_PATH_TRIE {
+  DEVICE_PATH_TRIE_NODE Root;
+  EFI_EVENT             Event;
+  VOID                  *Registration;
+  BOOLEAN               Incomplete;     ///< A handle could not be inserted.
+};
+
+// DEVICE_PATH_TRIE_NODE_PATH
+#define DEVICE_PATH_TRIE_NODE_PATH(Node)  \
+  ((EFI_DEVICE_PATH_PROTOCOL *)((DEVICE_PATH_TRIE_NODE *)(Node) + 1))
+
+// InternalFindTrieChild
+STATIC
+DEVICE_PATH_TRIE_NODE *
+InternalFindTrieChild (
+  IN CONST DEVICE_PATH_TRIE_NODE     *Node,
+  IN CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePathNode
+  )
+{
+  DEVICE_PATH_TRIE_NODE *Child;
+
+  UINTN                 Size;
+
+  Size = DevicePathNodeLength ((CONST VOID *)DevicePathNode);
+
+  for (Child = Node->Child; Child != NULL; Child = Child->Sibling) {
+    if ((DevicePathNodeLength (DEVICE_PATH_TRIE_NODE_PATH (Child)) == Size)
+     && (CompareMem (
+           (VOID *)DEVICE_PATH_TRIE_NODE_PATH (Child),
+           (VOID *)DevicePathNode,
+           Size
+           ) == 0)) {
+      break;
+    }
+  }
+
+  return Child;
+}
+
+// InternalInsertTrieHandle
+/** Inserts a handle at the end of its device path.
+
+  Must be called at TPL_CALLBACK.
+
+  @retval EFI_SUCCESS           The handle has been inserted.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+**/
+STATIC
+EFI_STATUS
+InternalInsertTrieHandle (
+  IN OUT MISC_DEVICE_PATH_TRIE           *Trie,
+  IN     EFI_HANDLE                      Handle,
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath
+  )
+{
+  EFI_STATUS              Status;
+
+  DEVICE_PATH_TRIE_NODE   *Node;
+  DEVICE_PATH_TRIE_NODE   *Child;
+  DEVICE_PATH_TRIE_HANDLE *TrieHandle;
+  UINTN                   Size;
+
+  Node   = &Trie->Root;
+  Status = EFI_SUCCESS;
+
+  while (!IsDevicePathEnd ((CONST VOID *)DevicePath)) {
+    Child = InternalFindTrieChild (Node, DevicePath);
+
+    if (Child == NULL) {
+      Size  = DevicePathNodeLength ((CONST VOID *)DevicePath);
+      Child = AllocatePool (sizeof (*Child) + Size);
+
+      if (Child == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+        break;
+      }
+
+      Child->Child   = NULL;
+      Child->Handles = NULL;
+      Child->Sibling = Node->Child;
+      Node->Child    = Child;
+
+      CopyMem (
+        (VOID *)DEVICE_PATH_TRIE_NODE_PATH (Child),
+        (VOID *)DevicePath,
+        Size
+        );
+    }
+
+    Node       = Child;
+    DevicePath = NextDevicePathNode ((CONST VOID *)DevicePath);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    // Reinstalling an unchanged device path notifies again.
+    for (
+      TrieHandle = Node->Handles;
+      TrieHandle != NULL;
+      TrieHandle = TrieHandle->Next
+      ) {
+      if (TrieHandle->Handle == Handle) {
+        break;
+      }
+    }
+
+    if (TrieHandle == NULL) {
+      TrieHandle = AllocatePool (sizeof (*TrieHandle));
+      Status     = EFI_OUT_OF_RESOURCES;
+
+      if (TrieHandle != NULL) {
+        TrieHandle->Handle = Handle;
+        TrieHandle->Next   = Node->Handles;
+        Node->Handles      = TrieHandle;
+
+        Status = EFI_SUCCESS;
+      }
+    }
+  }
+
+  return Status;
+}
+
+// InternalInsertTrieHandles
+/** Inserts the handles newly carrying a device path.
+**/
+STATIC
+VOID
+EFIAPI
+InternalInsertTrieHandles (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  MISC_DEVICE_PATH_TRIE    *Trie;
+  EFI_HANDLE               Handle;
+  UINTN                    BufferSize;
+  EFI_DEVICE_PATH_PROTOCOL *DevicePath;
+  EFI_STATUS               Status;
+
+  Trie = (MISC_DEVICE_PATH_TRIE *)Context;
+
+  do {
+    BufferSize = sizeof (Handle);
+    Status     = EfiLocateHandle (
+                   ByRegisterNotify,
+                   NULL,
+                   Trie->Registration,
+                   &BufferSize,
+                   &Handle
+                   );
+
+    if (!EFI_ERROR (Status)) {
+      Status = EfiHandleProtocol (
+                 Handle,
+                 &gEfiDevicePathProtocolGuid,
+                 (VOID **)&DevicePath
+                 );
+
+      if (!EFI_ERROR (Status)) {
+        Status = InternalInsertTrieHandle (Trie, Handle, DevicePath);
+
+        if (EFI_ERROR (Status)) {
+          Trie->Incomplete = TRUE;
+        }
+      }
+
+      // A handle losing its device path meanwhile does not end the queue.
+      Status = EFI_SUCCESS;
+    }
+  } while (!EFI_ERROR (Status));
+}
+
+// InternalFreeTrieNodes
+STATIC
+VOID
+InternalFreeTrieNodes (
+  IN DEVICE_PATH_TRIE_NODE  *Node
+  )
+{
+  DEVICE_PATH_TRIE_NODE   *Child;
+  DEVICE_PATH_TRIE_HANDLE *TrieHandle;
+
+  while (Node->Handles != NULL) {
+    TrieHandle    = Node->Handles;
+    Node->Handles = TrieHandle->Next;
+
+    FreePool ((VOID *)TrieHandle);
+  }
+
+  // The recursion is bounded by the depth of the device paths.
+  while (Node->Child != NULL) {
+    Child       = Node->Child;
+    Node->Child = Child->Sibling;
+
+    InternalFreeTrieNodes (Child);
+    FreePool ((VOID *)Child);
+  }
+}
+
+// MiscCreateDevicePathTrie
+/** Creates a trie of the device paths of all handles.
+
+  The trie is kept current as device paths are installed.  Handles losing
+  their device path are dropped when encountered by a query.
+
+  @param[out] Trie  The created trie.  Destroy with
+                    MiscDestroyDevicePathTrie().
+
+  @retval EFI_SUCCESS           The trie has been created.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+**/
+EFI_STATUS
+MiscCreateDevicePathTrie (
+  OUT MISC_DEVICE_PATH_TRIE  **Trie
+  )
+{
+  EFI_STATUS               Status;
+
+  MISC_DEVICE_PATH_TRIE    *NewTrie;
+  UINTN                    NumberOfHandles;
+  EFI_HANDLE               *Handles;
+  EFI_DEVICE_PATH_PROTOCOL *DevicePath;
+  UINTN                    Index;
+  EFI_TPL                  OldTpl;
+
+  ASSERT (Trie != NULL);
+
+  NewTrie = AllocateZeroPool (sizeof (*NewTrie));
+  Status  = EFI_OUT_OF_RESOURCES;
+
+  if (NewTrie != NULL) {
+    Status = EfiCreateEvent (
+               EVT_NOTIFY_SIGNAL,
+               TPL_CALLBACK,
+               InternalInsertTrieHandles,
+               (VOID *)NewTrie,
+               &NewTrie->Event
+               );
+
+    // Register first, so no handle is missed while populating the trie.
+    if (!EFI_ERROR (Status)) {
+      Status = EfiRegisterProtocolNotify (
+                 &gEfiDevicePathProtocolGuid,
+                 NewTrie->Event,
+                 &NewTrie->Registration
+                 );
+
+      if (EFI_ERROR (Status)) {
+        EfiCloseEvent (NewTrie->Event);
+      }
+    }
+
+    if (EFI_ERROR (Status)) {
+      FreePool ((VOID *)NewTrie);
+    } else {
+      Status = EfiLocateHandleBuffer (
+                 ByProtocol,
+                 &gEfiDevicePathProtocolGuid,
+                 NULL,
+                 &NumberOfHandles,
+                 &Handles
+                 );
+
+      if (!EFI_ERROR (Status)) {
+        OldTpl = EfiRaiseTPL (TPL_CALLBACK);
+
+        for (Index = 0; Index < NumberOfHandles; ++Index) {
+          Status = EfiHandleProtocol (
+                     Handles[Index],
+                     &gEfiDevicePathProtocolGuid,
+                     (VOID **)&DevicePath
+                     );
+
+          if (!EFI_ERROR (Status)) {
+            Status = InternalInsertTrieHandle (
+                       NewTrie,
+                       Handles[Index],
+                       DevicePath
+                       );
+
+            if (EFI_ERROR (Status)) {
+              NewTrie->Incomplete = TRUE;
+            }
+          }
+        }
+
+        EfiRestoreTPL (OldTpl);
+
+        FreePool ((VOID *)Handles);
+      }
+
+      *Trie  = NewTrie;
+      Status = EFI_SUCCESS;
+    }
+  }
+
+  return Status;
+}
+
+// MiscDestroyDevicePathTrie
+/** Stops tracking device paths and destroys a trie.
+
+  @param[in] Trie  The trie to destroy.
+**/
+VOID
+MiscDestroyDevicePathTrie (
+  IN MISC_DEVICE_PATH_TRIE  *Trie
+  )
+{
+  ASSERT (Trie != NULL);
+
+  // Closing the event also cancels the notify registration.
+  EfiCloseEvent (Trie->Event);
+
+  InternalFreeTrieNodes (&Trie->Root);
+  FreePool ((VOID *)Trie);
+}
+
+// InternalValidateTrieHandle
+/** Checks a handle found by the trie against its current device path.
+
+  @retval EFI_SUCCESS      The handle's device path matches and it supports
+                           Protocol.
+  @retval EFI_UNSUPPORTED  The handle's device path matches, but it does not
+                           support Protocol.
+  @retval EFI_NOT_FOUND    The handle's device path does not match anymore.
+**/
+STATIC
+EFI_STATUS
+InternalValidateTrieHandle (
+  IN EFI_HANDLE                      Handle,
+  IN EFI_GUID                        *Protocol,
+  IN CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN UINTN                           Size
+  )
+{
+  EFI_STATUS               Status;
+
+  EFI_DEVICE_PATH_PROTOCOL *HandlePath;
+  VOID                     *Interface;
+
+  Status = EfiHandleProtocol (
+             Handle,
+             &gEfiDevicePathProtocolGuid,
+             (VOID **)&HandlePath
+             );
+
+  if (!EFI_ERROR (Status)) {
+    Status = EFI_NOT_FOUND;
+
+    if ((GetDevicePathSize (HandlePath) == (Size + END_DEVICE_PATH_LENGTH))
+     && (CompareMem ((VOID *)HandlePath, (VOID *)DevicePath, Size) == 0)) {
+      Status = EfiHandleProtocol (Handle, Protocol, &Interface);
+
+      if (EFI_ERROR (Status)) {
+        Status = EFI_UNSUPPORTED;
+      }
+    }
+  } else {
+    Status = EFI_NOT_FOUND;
+  }
+
+  return Status;
+}
+
+// MiscTrieLocateDevicePath
+/** Locates the handle with the longest device path prefix that supports a
+    protocol.
+
+  This behaves as EfiLocateDevicePath(), but costs a walk of DevicePath
+  instead of a scan of all handles supporting Protocol.  Must be called at
+  or below TPL_CALLBACK.
+
+  @param[in]      Trie        The trie to look up in.
+  @param[in]      Protocol    The protocol to search for.
+  @param[in, out] DevicePath  On input, the device path to look up.  On
+                              output, the remaining part of it.
+  @param[out]     Device      The handle found.
+
+  @retval EFI_SUCCESS    The handle has been found.
+  @retval EFI_NOT_FOUND  No handle on DevicePath supports Protocol.
+**/
+EFI_STATUS
+MiscTrieLocateDevicePath (
+  IN OUT MISC_DEVICE_PATH_TRIE     *Trie,
+  IN     EFI_GUID                  *Protocol,
+  IN OUT EFI_DEVICE_PATH_PROTOCOL  **DevicePath,
+  OUT    EFI_HANDLE                *Device
+  )
+{
+  EFI_STATUS               Status;
+
+  EFI_DEVICE_PATH_PROTOCOL *Source;
+  EFI_DEVICE_PATH_PROTOCOL *Current;
+  DEVICE_PATH_TRIE_NODE    *Node;
+  DEVICE_PATH_TRIE_HANDLE  **Link;
+  DEVICE_PATH_TRIE_HANDLE  *TrieHandle;
+  EFI_HANDLE               BestDevice;
+  UINTN                    BestSize;
+  UINTN                    Size;
+  EFI_TPL                  OldTpl;
+
+  ASSERT (Trie != NULL);
+  ASSERT (Protocol != NULL);
+  ASSERT (DevicePath != NULL);
+  ASSERT (*DevicePath != NULL);
+  ASSERT (Device != NULL);
+
+  if (Trie->Incomplete) {
+    Status = EfiLocateDevicePath (Protocol, DevicePath, Device);
+  } else {
+    Source     = *DevicePath;
+    Current    = Source;
+    Node       = &Trie->Root;
+    Size       = 0;
+    BestDevice = NULL;
+    BestSize   = 0;
+
+    // Keep the notification from modifying the trie while it is walked.
+    OldTpl = EfiRaiseTPL (TPL_CALLBACK);
+
+    do {
+      Link = &Node->Handles;
+
+      while (*Link != NULL) {
+        TrieHandle = *Link;
+        Status     = InternalValidateTrieHandle (
+                       TrieHandle->Handle,
+                       Protocol,
+                       Source,
+                       Size
+                       );
+
+        if (Status == EFI_NOT_FOUND) {
+          *Link = TrieHandle->Next;
+          FreePool ((VOID *)TrieHandle);
+        } else {
+          if (!EFI_ERROR (Status)) {
+            BestDevice = TrieHandle->Handle;
+            BestSize   = Size;
+          }
+
+          Link = &TrieHandle->Next;
+        }
+      }
+
+      // Only the first instance of a multi-instance path is matched.
+      if (IsDevicePathEndType ((CONST VOID *)Current)) {
+        break;
+      }
+
+      Node = InternalFindTrieChild (Node, Current);
+
+      Size   += DevicePathNodeLength ((CONST VOID *)Current);
+      Current = NextDevicePathNode ((CONST VOID *)Current);
+    } while (Node != NULL);
+
+    EfiRestoreTPL (OldTpl);
+
+    Status = EFI_NOT_FOUND;
+
+    if (BestDevice != NULL) {
+      *Device     = BestDevice;
+      *DevicePath = (EFI_DEVICE_PATH_PROTOCOL *)((UINT8 *)Source + BestSize);
+      Status      = EFI_SUCCESS;
+    }
+  }
+
+  return Status;
+}
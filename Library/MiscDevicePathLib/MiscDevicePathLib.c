@@ -16,142 +16,640 @@
 
 #include <Uefi.h>
 
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/MiscDevicePathLib.h>
 #include <Library/PcdLib.h>
 
-// TODO: Rather split the functions than using a PCDs?
-#define _PCD_GET_MODE_BOOL_PcdSupportMultiNodeFilePaths 1
-#define _PCD_GET_MODE_BOOL_PcdSupportNonterminatedPaths 1
+// InternalWalkFilePathNodes
+/** Walks the file path nodes of a device path and concatenates their paths.
+
+  The same walk serves for sizing and for filling, so both passes agree on
+  the separators inserted and the terminators dropped.  The path shapes
+  supported are passed as constants, so each caller is specialised to the
+  branches it needs when the walk is inlined.
+
+  @param[in]  DevicePath     The device path to walk.
+  @param[in]  MultiNode      Whether the path may span multiple nodes.  If
+                             FALSE, only the first file path node is
+                             converted.
+  @param[in]  Nonterminated  Whether the nodes' paths may lack their
+                             terminator.
+  @param[out] Buffer         Optional, the buffer to write the path into, not
+                             terminated.  Must hold the number of
+                             characters returned.
+  @param[out] Found          Whether a file path node has been found.
+
+  @return  Returned is the length, in characters, of the path.
+**/
+STATIC
+UINTN
+InternalWalkFilePathNodes (
+  IN  CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN  BOOLEAN                         MultiNode,
+  IN  BOOLEAN                         Nonterminated,
+  OUT CHAR16                          *Buffer OPTIONAL,
+  OUT BOOLEAN                         *Found
+  )
+{
+  UINTN            Length;
+
+  EFI_DEV_PATH_PTR DevPath;
+  CONST CHAR16     *NodePath;
+  UINTN            NodeLength;
+  CHAR16           LastChar;
+
+  Length   = 0;
+  LastChar = L'\0';
+  *Found   = FALSE;
+
+  DevPath.DevPath = (EFI_DEVICE_PATH_PROTOCOL *)DevicePath;
+
+  while (!IsDevicePathEnd ((CONST VOID *)DevPath.Raw)) {
+    if ((DevicePathType ((CONST VOID *)DevPath.Raw) == MEDIA_DEVICE_PATH)
+     && (DevicePathSubType ((CONST VOID *)DevPath.Raw) == MEDIA_FILEPATH_DP)) {
+      *Found     = TRUE;
+      NodePath   = &DevPath.FilePath->PathName[0];
+      NodeLength = ((DevicePathNodeLength ((CONST VOID *)DevPath.Raw)
+                      - sizeof (*DevPath.DevPath)) / sizeof (*NodePath));
+
+      // Ensure the length does not include \0.
+
+      if (Nonterminated) {
+        if ((NodeLength > 0) && (NodePath[NodeLength - 1] == L'\0')) {
+          --NodeLength;
+        }
+      } else if (NodeLength > 0) {
+        --NodeLength;
+      }
+
+      // Ensure the path ends with '\' and the node's path doesn't start with
+      // '\' for all nodes but the first.
+      // This is only required for paths consisting of multiple nodes.
+
+      if (MultiNode && (Length > 0)) {
+        if (LastChar != L'\\') {
+          if (Buffer != NULL) {
+            Buffer[Length] = L'\\';
+          }
+
+          ++Length;
+          LastChar = L'\\';
+        }
+
+        if ((NodeLength > 0) && (NodePath[0] == L'\\')) {
+          ++NodePath;
+          --NodeLength;
+        }
+      }
+
+      if (NodeLength > 0) {
+        if (Buffer != NULL) {
+          CopyMem (
+            (VOID *)&Buffer[Length],
+            (VOID *)NodePath,
+            (NodeLength * sizeof (*NodePath))
+            );
+        }
+
+        Length  += NodeLength;
+        LastChar = NodePath[NodeLength - 1];
+      }
+
+      if (!MultiNode) {
+        break;
+      }
+    } else if (MultiNode) {
+      // No non-FilePath Nodes should be present after the first.
+      ASSERT (!*Found);
+    }
+
+    DevPath.DevPath = NextDevicePathNode ((CONST VOID *)DevPath.Raw);
+  }
+
+  return Length;
+}
+
+// InternalFileDevicePathToText
+/** Walks the file path nodes of a device path as configured by the feature
+    PCDs.
+**/
+STATIC
+UINTN
+InternalFileDevicePathToText (
+  IN  CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  OUT CHAR16                          *Buffer OPTIONAL,
+  OUT BOOLEAN                         *Found
+  )
+{
+  return InternalWalkFilePathNodes (
+           DevicePath,
+           FeaturePcdGet (PcdSupportMultiNodeFilePaths),
+           FeaturePcdGet (PcdSupportNonterminatedPaths),
+           Buffer,
+           Found
+           );
+}
 
 // MiscFileDevicePathToText
-// TODO: This could use a cleanup.
+/** Converts the file path nodes of a device path to a path.
+
+  The path is sized first and then written into a single allocation.
+
+  @param[in]  DevicePath  The device path to convert.
+  @param[out] TextSize    Optional, the size, in bytes, of the path, excluding
+                          the terminator.
+
+  @return  Returned is the path or NULL if DevicePath has no file path node
+           or memory allocation failed.  Free with FreePool().
+**/
 CHAR16 *
 MiscFileDevicePathToText (
   IN     EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
   IN OUT UINTN                     *TextSize OPTIONAL
   )
 {
-  CHAR16           *FilePath;
+  CHAR16  *FilePath;
 
-  UINTN            FilePathSize;
-  EFI_DEV_PATH_PTR DevPath;
-  UINTN            DevFilePathSize;
-  CHAR16           *DevFilePath;
-  CHAR16           *TempFilePath;
-  UINTN            Index;
-  BOOLEAN          FilePathFound;
+  UINTN   Length;
+  BOOLEAN Found;
 
   ASSERT (DevicePath != NULL);
 
-  FilePathSize = 0;
-  FilePath     = NULL;
+  FilePath = NULL;
+  Length   = InternalFileDevicePathToText (DevicePath, NULL, &Found);
+
+  if (Found) {
+    FilePath = AllocatePool ((Length + 1) * sizeof (*FilePath));
 
-  DevPath.DevPath = DevicePath;
+    if (FilePath != NULL) {
+      InternalFileDevicePathToText (DevicePath, FilePath, &Found);
 
-  if (PcdGetBool (PcdSupportMultiNodeFilePaths)) {
-    FilePathFound = FALSE;
+      FilePath[Length] = L'\0';
+    }
   }
 
-  while (!IsDevicePathEnd ((CONST VOID *)DevPath.Raw)) {
-    if ((DevicePathType ((CONST VOID *)DevPath.Raw) == MEDIA_DEVICE_PATH)
-     && (DevicePathSubType ((CONST VOID *)DevPath.Raw) == MEDIA_FILEPATH_DP)) {
-      if (PcdGetBool (PcdSupportMultiNodeFilePaths)) {
-        FilePathFound = TRUE;
-      }
+  if (TextSize != NULL) {
+    *TextSize = ((FilePath != NULL) ? (Length * sizeof (*FilePath)) : 0);
+  }
 
-      DevFilePathSize  = DevicePathNodeLength ((CONST VOID *)DevPath.Raw);
-      DevFilePathSize -= sizeof (*DevPath.DevPath);
-      DevFilePath      = &DevPath.FilePath->PathName[0];
+  return FilePath;
+}
 
-      // Ensure the size does not include \0.
+// InternalFileDevicePathToTextBuffer
+/** Converts the file path nodes of a device path to a path in a caller
+    buffer, supporting the path shapes passed.
+
+  @param[in]      DevicePath     The device path to convert.
+  @param[in]      MultiNode      Whether the path may span multiple nodes.
+  @param[in]      Nonterminated  Whether the nodes' paths may lack their
+                                 terminator.
+  @param[in, out] BufferSize     On input, the size, in bytes, of Buffer.  On
+                                 output, the size of the path, including the
+                                 terminator.
+  @param[out]     Buffer         The buffer to write the path into.
+
+  @retval EFI_SUCCESS           The path has been written.
+  @retval EFI_BUFFER_TOO_SMALL  Buffer is too small, BufferSize has been
+                                updated with the size needed.
+  @retval EFI_NOT_FOUND         DevicePath has no file path node.
+**/
+STATIC
+EFI_STATUS
+InternalFileDevicePathToTextBuffer (
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN     BOOLEAN                         MultiNode,
+  IN     BOOLEAN                         Nonterminated,
+  IN OUT UINTN                           *BufferSize,
+  OUT    CHAR16                          *Buffer OPTIONAL
+  )
+{
+  EFI_STATUS Status;
 
-      if (PcdGetBool (PcdSupportNonterminatedPaths)) {
-        Index = ((DevFilePathSize / sizeof (DevFilePath[0])) - 1);
+  UINTN      Length;
+  UINTN      Size;
+  BOOLEAN    Found;
 
-        if (DevFilePath[Index] == L'\0') {
-          DevFilePathSize -= sizeof (DevFilePath[0]);
-        }
-      } else {
-        DevFilePathSize -= sizeof (DevFilePath[0]);
-      }
+  ASSERT (DevicePath != NULL);
+  ASSERT (BufferSize != NULL);
+  ASSERT ((Buffer != NULL) || (*BufferSize == 0));
+
+  Length = InternalWalkFilePathNodes (
+             DevicePath,
+             MultiNode,
+             Nonterminated,
+             NULL,
+             &Found
+             );
+
+  Size   = ((Length + 1) * sizeof (*Buffer));
+  Status = EFI_NOT_FOUND;
+
+  if (Found) {
+    Status = EFI_BUFFER_TOO_SMALL;
+
+    if (*BufferSize >= Size) {
+      InternalWalkFilePathNodes (
+        DevicePath,
+        MultiNode,
+        Nonterminated,
+        Buffer,
+        &Found
+        );
 
-      // Ensure FilePath ends with '\' and DevFilePath doesn't start with '\'
-      // for all iterations but the first.
-      // This is only required for FilePaths consisting of multiple Nodes.
+      Buffer[Length] = L'\0';
+      Status         = EFI_SUCCESS;
+    }
 
-      if (PcdGetBool (PcdSupportMultiNodeFilePaths) && (FilePathSize > 0)) {
-        Index = ((FilePathSize / sizeof (FilePath[0])) - 1);
+    *BufferSize = Size;
+  }
 
-        if (FilePath[Index] != L'\\') {
-          FilePathSize += sizeof (L'\\');
+  return Status;
+}
 
-          // Overwrite '\0' with '\' - a new will be appended anyway.
-          FilePath[Index + 1] = L'\\';
-        }
+// MiscFileDevicePathToTextBuffer
+/** Converts the file path nodes of a device path to a path in a caller
+    buffer.
 
-        if (DevFilePath[0] == L'\\') {
-          ++DevFilePath;
-          --DevFilePathSize;
-        }
-      }
+  The path shapes supported are selected by PcdSupportMultiNodeFilePaths and
+  PcdSupportNonterminatedPaths.
 
-      TempFilePath = AllocatePool (
-                       FilePathSize + DevFilePathSize + sizeof (L'\0')
-                       );
+  @param[in]      DevicePath  The device path to convert.
+  @param[in, out] BufferSize  On input, the size, in bytes, of Buffer.  On
+                              output, the size of the path, including the
+                              terminator.
+  @param[out]     Buffer      The buffer to write the path into.
 
-      if (TempFilePath == NULL) {
-        // FilePath cannot be non-NULL in the first iteration.
-        if (PcdGetBool (PcdSupportMultiNodeFilePaths)) {
-          FilePath = NULL;
-        }
+  @retval EFI_SUCCESS           The path has been written.
+  @retval EFI_BUFFER_TOO_SMALL  Buffer is too small, BufferSize has been
+                                updated with the size needed.
+  @retval EFI_NOT_FOUND         DevicePath has no file path node.
+**/
+EFI_STATUS
+MiscFileDevicePathToTextBuffer (
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN OUT UINTN                           *BufferSize,
+  OUT    CHAR16                          *Buffer OPTIONAL
+  )
+{
+  return InternalFileDevicePathToTextBuffer (
+           DevicePath,
+           FeaturePcdGet (PcdSupportMultiNodeFilePaths),
+           FeaturePcdGet (PcdSupportNonterminatedPaths),
+           BufferSize,
+           Buffer
+           );
+}
 
-        break;
-      }
+// MiscSingleNodeFilePathToText
+/** Converts the first file path node of a device path to a path in a caller
+    buffer.  The node's path must be terminated.
 
-      if (PcdGetBool (PcdSupportMultiNodeFilePaths) && (FilePath != NULL)) {
-        CopyMem ((VOID *)TempFilePath, (VOID *)FilePath, FilePathSize);
-        FreePool ((VOID *)FilePath);
-      }
+  Parameters and return values are as for MiscFileDevicePathToTextBuffer().
+**/
+EFI_STATUS
+MiscSingleNodeFilePathToText (
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN OUT UINTN                           *BufferSize,
+  OUT    CHAR16                          *Buffer OPTIONAL
+  )
+{
+  return InternalFileDevicePathToTextBuffer (
+           DevicePath,
+           FALSE,
+           FALSE,
+           BufferSize,
+           Buffer
+           );
+}
+
+// MiscSingleNodeNonterminatedFilePathToText
+/** Converts the first file path node of a device path to a path in a caller
+    buffer.  The node's path may lack its terminator.
+
+  Parameters and return values are as for MiscFileDevicePathToTextBuffer().
+**/
+EFI_STATUS
+MiscSingleNodeNonterminatedFilePathToText (
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN OUT UINTN                           *BufferSize,
+  OUT    CHAR16                          *Buffer OPTIONAL
+  )
+{
+  return InternalFileDevicePathToTextBuffer (
+           DevicePath,
+           FALSE,
+           TRUE,
+           BufferSize,
+           Buffer
+           );
+}
+
+// MiscMultiNodeFilePathToText
+/** Converts the file path nodes of a device path to a path in a caller
+    buffer.  The nodes' paths must be terminated.
+
+  Parameters and return values are as for MiscFileDevicePathToTextBuffer().
+**/
+EFI_STATUS
+MiscMultiNodeFilePathToText (
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN OUT UINTN                           *BufferSize,
+  OUT    CHAR16                          *Buffer OPTIONAL
+  )
+{
+  return InternalFileDevicePathToTextBuffer (
+           DevicePath,
+           TRUE,
+           FALSE,
+           BufferSize,
+           Buffer
+           );
+}
+
+// MiscMultiNodeNonterminatedFilePathToText
+/** Converts the file path nodes of a device path to a path in a caller
+    buffer.  The nodes' paths may lack their terminators.
+
+  Parameters and return values are as for MiscFileDevicePathToTextBuffer().
+**/
+EFI_STATUS
+MiscMultiNodeNonterminatedFilePathToText (
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *DevicePath,
+  IN OUT UINTN                           *BufferSize,
+  OUT    CHAR16                          *Buffer OPTIONAL
+  )
+{
+  return InternalFileDevicePathToTextBuffer (
+           DevicePath,
+           TRUE,
+           TRUE,
+           BufferSize,
+           Buffer
+           );
+}
+
+// MiscFileDevicePathsToText
+/** Converts the file path nodes of many device paths to paths in a single
+    string table.
+
+  All paths are sized first and then written back to back into one
+  allocation, which also holds the table and its offsets.
+
+  @param[in] NumberOfDevicePaths  The number of device paths to convert.
+  @param[in] DevicePaths          The device paths to convert.
+
+  @return  Returned is the string table or NULL if memory allocation failed.
+           Free with FreePool().
+**/
+MISC_FILE_PATH_TEXT_TABLE *
+MiscFileDevicePathsToText (
+  IN UINTN                           NumberOfDevicePaths,
+  IN CONST EFI_DEVICE_PATH_PROTOCOL  **DevicePaths
+  )
+{
+  MISC_FILE_PATH_TEXT_TABLE *Table;
+
+  UINTN                     *Offsets;
+  CHAR16                    *Strings;
+  UINTN                     Index;
+  UINTN                     Length;
+  UINTN                     TotalLength;
+  BOOLEAN                   Found;
+
+  ASSERT ((DevicePaths != NULL) || (NumberOfDevicePaths == 0));
+
+  TotalLength = 0;
+
+  for (Index = 0; Index < NumberOfDevicePaths; ++Index) {
+    ASSERT (DevicePaths[Index] != NULL);
+
+    Length = InternalFileDevicePathToText (DevicePaths[Index], NULL, &Found);
+
+    if (Found) {
+      TotalLength += (Length + 1);
+    }
+  }
+
+  Table = AllocatePool (
+            sizeof (*Table)
+              + (NumberOfDevicePaths * sizeof (*Offsets))
+              + (TotalLength * sizeof (*Strings))
+            );
+
+  if (Table != NULL) {
+    Offsets = (UINTN *)(Table + 1);
+    Strings = (CHAR16 *)&Offsets[NumberOfDevicePaths];
 
-      FilePath = TempFilePath;
+    Table->NumberOfPaths = NumberOfDevicePaths;
+    Table->Offsets       = Offsets;
+    Table->Strings       = Strings;
 
-      // Index of the first character after FilePath.
-      if (PcdGetBool (PcdSupportMultiNodeFilePaths)) {
-        Index = (FilePathSize / sizeof (FilePath[0]));
-      } else {
-        Index = 0;
+    TotalLength = 0;
+
+    for (Index = 0; Index < NumberOfDevicePaths; ++Index) {
+      Length = InternalFileDevicePathToText (
+                 DevicePaths[Index],
+                 &Strings[TotalLength],
+                 &Found
+                 );
+
+      Offsets[Index] = MISC_FILE_PATH_TEXT_NONE;
+
+      if (Found) {
+        Offsets[Index]                = TotalLength;
+        Strings[TotalLength + Length] = L'\0';
+        TotalLength                  += (Length + 1);
       }
+    }
+  }
 
-      CopyMem (
-        (VOID *)&FilePath[Index],
-        (VOID *)DevFilePath,
-        DevFilePathSize
-        );
+  return Table;
+}
+
+// InternalPutPathChar
+/** Writes a character to a device path buffer if it fits and accounts for
+    it either way.
+**/
+STATIC
+VOID
+InternalPutPathChar (
+  IN OUT UINT8   *Buffer OPTIONAL,
+  IN     UINTN   BufferSize,
+  IN OUT UINTN   *Offset,
+  IN     CHAR16  Char
+  )
+{
+  if ((*Offset <= BufferSize) && (sizeof (Char) <= (BufferSize - *Offset))) {
+    WriteUnaligned16 ((UINT16 *)&Buffer[*Offset], (UINT16)Char);
+  }
 
-      FilePathSize += DevFilePathSize;
+  *Offset += sizeof (Char);
+}
 
-      // Index of the first character after FilePath.
-      Index = (FilePathSize / sizeof (FilePath[0]));
+// InternalCloseFilePathNode
+/** Terminates a file path node and writes its header if it fits.
 
-      FilePath[Index] = L'\0';
+  @param[in, out] Buffer      The device path buffer.
+  @param[in]      BufferSize  The size, in bytes, of Buffer.
+  @param[in]      NodeOffset  The offset of the node in Buffer.
+  @param[in, out] Offset      The offset past the node's last character.
 
-      if (!PcdGetBool (PcdSupportMultiNodeFilePaths)) {
-        break;
+  @return  Returned is whether the node's size is valid.
+**/
+STATIC
+BOOLEAN
+InternalCloseFilePathNode (
+  IN OUT UINT8  *Buffer OPTIONAL,
+  IN     UINTN  BufferSize,
+  IN     UINTN  NodeOffset,
+  IN OUT UINTN  *Offset
+  )
+{
+  BOOLEAN                  Valid;
+
+  EFI_DEVICE_PATH_PROTOCOL *Node;
+
+  InternalPutPathChar (Buffer, BufferSize, Offset, L'\0');
+
+  Valid = (BOOLEAN)((*Offset - NodeOffset) <= MAX_UINT16);
+
+  if (Valid
+   && (NodeOffset <= BufferSize)
+   && (SIZE_OF_FILEPATH_DEVICE_PATH <= (BufferSize - NodeOffset))) {
+    Node          = (EFI_DEVICE_PATH_PROTOCOL *)&Buffer[NodeOffset];
+    Node->Type    = MEDIA_DEVICE_PATH;
+    Node->SubType = MEDIA_FILEPATH_DP;
+
+    SetDevicePathNodeLength ((VOID *)Node, (*Offset - NodeOffset));
+  }
+
+  return Valid;
+}
+
+// MiscTextToFileDevicePath
+/** Converts a path to file path nodes in a caller buffer.
+
+  The path is split in a single pass and written directly into the buffer.
+  In multi-node form, each path component gets its own node, the first one
+  keeps the path's leading separator and empty components are dropped.  In
+  single-node form, the path is stored unchanged in a single node.  Both
+  forms convert back with MiscFileDevicePathToText().
+
+  @param[in]      Prefix      Optional, the device path to put in front of the
+                              file path nodes, e.g. the volume's.
+  @param[in]      Path        The path to convert.
+  @param[in]      MultiNode   Whether to create a node per path component.
+  @param[in, out] BufferSize  On input, the size, in bytes, of DevicePath.
+                              On output, the size of the device path.
+  @param[out]     DevicePath  The buffer to write the device path into.
+
+  @retval EFI_SUCCESS            The device path has been written.
+  @retval EFI_BUFFER_TOO_SMALL   DevicePath is too small, BufferSize has been
+                                 updated with the size needed.
+  @retval EFI_INVALID_PARAMETER  A node would exceed the maximum node size.
+**/
+EFI_STATUS
+MiscTextToFileDevicePath (
+  IN     CONST EFI_DEVICE_PATH_PROTOCOL  *Prefix OPTIONAL,
+  IN     CONST CHAR16                    *Path,
+  IN     BOOLEAN                         MultiNode,
+  IN OUT UINTN                           *BufferSize,
+  OUT    EFI_DEVICE_PATH_PROTOCOL        *DevicePath OPTIONAL
+  )
+{
+  EFI_STATUS   Status;
+
+  UINT8        *Buffer;
+  UINTN        Offset;
+  UINTN        FirstNodeOffset;
+  UINTN        NodeOffset;
+  UINTN        NodeLength;
+  CONST CHAR16 *Walker;
+  BOOLEAN      Valid;
+
+  ASSERT (Path != NULL);
+  ASSERT (BufferSize != NULL);
+  ASSERT ((DevicePath != NULL) || (*BufferSize == 0));
+
+  Buffer = (UINT8 *)DevicePath;
+  Offset = 0;
+
+  if (Prefix != NULL) {
+    Offset = (GetDevicePathSize (Prefix) - END_DEVICE_PATH_LENGTH);
+
+    if (Offset <= *BufferSize) {
+      CopyMem ((VOID *)Buffer, (CONST VOID *)Prefix, Offset);
+    }
+  }
+
+  FirstNodeOffset = Offset;
+  NodeOffset      = Offset;
+  Offset         += SIZE_OF_FILEPATH_DEVICE_PATH;
+  NodeLength      = 0;
+  Valid           = TRUE;
+  Walker          = Path;
+
+  if (MultiNode && (*Walker == L'\\')) {
+    InternalPutPathChar (Buffer, *BufferSize, &Offset, L'\\');
+    ++NodeLength;
+
+    do {
+      ++Walker;
+    } while (*Walker == L'\\');
+  }
+
+  for (; *Walker != L'\0'; ++Walker) {
+    if (!MultiNode || (*Walker != L'\\')) {
+      InternalPutPathChar (Buffer, *BufferSize, &Offset, *Walker);
+      ++NodeLength;
+    } else if (NodeLength > 0) {
+      if (!InternalCloseFilePathNode (
+             Buffer,
+             *BufferSize,
+             NodeOffset,
+             &Offset
+             )) {
+        Valid = FALSE;
       }
-    } else if (PcdGetBool (PcdSupportMultiNodeFilePaths)) {
-      // No non-FilePath Nodes should be present after the first.
-      ASSERT (!FilePathFound);
+
+      NodeOffset  = Offset;
+      Offset     += SIZE_OF_FILEPATH_DEVICE_PATH;
+      NodeLength  = 0;
     }
+  }
 
-    DevPath.DevPath = NextDevicePathNode ((CONST VOID *)DevPath.Raw);
+  // Drop the empty node opened by a trailing separator.
+
+  if ((NodeLength == 0) && (NodeOffset > FirstNodeOffset)) {
+    Offset = NodeOffset;
+  } else {
+    if (!InternalCloseFilePathNode (
+           Buffer,
+           *BufferSize,
+           NodeOffset,
+           &Offset
+           )) {
+      Valid = FALSE;
+    }
   }
 
-  if (TextSize != NULL) {
-    *TextSize = FilePathSize;
+  if ((Offset <= *BufferSize)
+   && (END_DEVICE_PATH_LENGTH <= (*BufferSize - Offset))) {
+    SetDevicePathEndNode ((VOID *)&Buffer[Offset]);
   }
 
-  return FilePath;
+  Offset += END_DEVICE_PATH_LENGTH;
+  Status  = EFI_INVALID_PARAMETER;
+
+  if (Valid) {
+    Status = ((Offset <= *BufferSize) ? EFI_SUCCESS : EFI_BUFFER_TOO_SMALL);
+
+    *BufferSize = Offset;
+  }
+
+  return Status;
 }
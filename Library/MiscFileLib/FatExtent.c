@@ -0,0 +1,1173 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Guid/FileInfo.h>
+
+#include <Protocol/BlockIo.h>
+#include <Protocol/DiskIo.h>
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/EfiBootServicesLib.h>
+#include <Library/FileHandleLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscFileLib.h>
+#include <Library/MiscRuntimeLib.h>
+
+#include "MiscFileLibInternal.h"
+
+#pragma pack (1)
+
+// FAT_BOOT_SECTOR
+/// The BIOS parameter block shared by all FAT types.
+typedef struct {
+  UINT8  JumpBoot[3];
+  UINT8  OemName[8];
+  UINT16 BytesPerSector;
+  UINT8  SectorsPerCluster;
+  UINT16 ReservedSectors;
+  UINT8  NumberOfFats;
+  UINT16 RootEntries;
+  UINT16 Sectors16;
+  UINT8  Media;
+  UINT16 FatSize16;
+  UINT16 SectorsPerTrack;
+  UINT16 NumberOfHeads;
+  UINT32 HiddenSectors;
+  UINT32 Sectors32;
+  UINT32 FatSize32;         ///< FAT32 only.
+  UINT16 ExtendedFlags;     ///< FAT32 only.
+  UINT16 FsVersion;         ///< FAT32 only.
+  UINT32 RootCluster;       ///< FAT32 only.
+} FAT_BOOT_SECTOR;
+
+// FAT_DIRECTORY_ENTRY
+typedef struct {
+  UINT8  Name[11];
+  UINT8  Attributes;
+  UINT8  CaseFlags;
+  UINT8  CreateTimeTenth;
+  UINT16 CreateTime;
+  UINT16 CreateDate;
+  UINT16 AccessDate;
+  UINT16 FirstClusterHigh;
+  UINT16 ModifyTime;
+  UINT16 ModifyDate;
+  UINT16 FirstClusterLow;
+  UINT32 FileSize;
+} FAT_DIRECTORY_ENTRY;
+
+// FAT_LFN_ENTRY
+typedef struct {
+  UINT8  Ordinal;
+  UINT16 Name1[5];
+  UINT8  Attributes;
+  UINT8  Type;
+  UINT8  Checksum;
+  UINT16 Name2[6];
+  UINT16 FirstCluster;
+  UINT16 Name3[2];
+} FAT_LFN_ENTRY;
+
+#pragma pack ()
+
+// FAT_ATTRIBUTE_VOLUME_ID
+#define FAT_ATTRIBUTE_VOLUME_ID  0x08
+
+// FAT_ATTRIBUTE_DIRECTORY
+#define FAT_ATTRIBUTE_DIRECTORY  0x10
+
+// FAT_ATTRIBUTE_LFN
+#define FAT_ATTRIBUTE_LFN  0x0F
+
+// FAT_ENTRY_FREE
+#define FAT_ENTRY_FREE  0x00
+
+// FAT_ENTRY_DELETED
+#define FAT_ENTRY_DELETED  0xE5
+
+// FAT_ENTRY_KANJI_E5
+/// Stored in place of a leading 0xE5 of a name, which marks deleted entries.
+#define FAT_ENTRY_KANJI_E5  0x05
+
+// FAT_LFN_LAST
+#define FAT_LFN_LAST  0x40
+
+// FAT_LFN_ORDINAL_MASK
+#define FAT_LFN_ORDINAL_MASK  0x1F
+
+// FAT_LFN_CHARS
+#define FAT_LFN_CHARS  13
+
+// FAT_LFN_MAX_ENTRIES
+#define FAT_LFN_MAX_ENTRIES  20
+
+// FAT_LFN_NONE
+/// Marks the absence of a pending long name.
+#define FAT_LFN_NONE  MAX_UINT8
+
+// FAT_FIRST_CLUSTER
+#define FAT_FIRST_CLUSTER  2
+
+// FAT32_MAX_CLUSTERS
+#define FAT32_MAX_CLUSTERS  0x0FFFFFF5
+
+// MISC_FAT_WINDOW_SIZE
+/// The size of the FAT window cached while following cluster chains.
+#define MISC_FAT_WINDOW_SIZE  SIZE_64KB
+
+// MISC_FAT_VOLUME
+typedef struct {
+  EFI_DISK_IO_PROTOCOL  *DiskIo;
+  EFI_BLOCK_IO_PROTOCOL *BlockIo;
+  UINT32                MediaId;
+  UINT8                 FatBits;            ///< 12, 16 or 32.
+  UINT32                BytesPerCluster;
+  UINT32                NumberOfClusters;
+  UINT64                FatOffset;
+  UINT64                FatSize;
+  UINT64                RootOffset;         ///< FAT12 and FAT16 only.
+  UINT32                RootSize;           ///< FAT12 and FAT16 only.
+  UINT32                RootCluster;        ///< FAT32 only.
+  UINT64                DataOffset;
+  UINT8                 *FatWindow;
+  UINT64                FatWindowOffset;
+  UINTN                 FatWindowSize;
+} MISC_FAT_VOLUME;
+
+// MISC_FAT_NAME_STATE
+/// The long name being assembled while scanning a directory.
+typedef struct {
+  UINT8  Ordinal;           ///< The next expected ordinal or FAT_LFN_NONE.
+  UINT8  Checksum;
+  CHAR16 Name[(FAT_LFN_MAX_ENTRIES * FAT_LFN_CHARS) + 1];
+} MISC_FAT_NAME_STATE;
+
+// InternalFatReadDisk
+STATIC
+EFI_STATUS
+InternalFatReadDisk (
+  IN  MISC_FAT_VOLUME  *Volume,
+  IN  UINT64           Offset,
+  IN  UINTN            Size,
+  OUT VOID             *Buffer
+  )
+{
+  return Volume->DiskIo->ReadDisk (
+                           Volume->DiskIo,
+                           Volume->MediaId,
+                           Offset,
+                           Size,
+                           Buffer
+                           );
+}
+
+// InternalFatOpenVolume
+/** Validates the boot sector of a volume and derives its layout.
+
+  @retval EFI_SUCCESS           The volume is formatted FAT12, FAT16 or FAT32.
+  @retval EFI_UNSUPPORTED       The volume is not formatted FAT or has no
+                                block device.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+**/
+STATIC
+EFI_STATUS
+InternalFatOpenVolume (
+  IN  EFI_HANDLE       VolumeHandle,
+  OUT MISC_FAT_VOLUME  *Volume
+  )
+{
+  EFI_STATUS      Status;
+
+  UINT8           Sector[512];
+  FAT_BOOT_SECTOR *BootSector;
+  UINT32          BytesPerSector;
+  UINT32          SectorsPerCluster;
+  UINT32          FatSectors;
+  UINT32          TotalSectors;
+  UINT32          RootSectors;
+  UINT64          DataSector;
+
+  ZeroMem ((VOID *)Volume, sizeof (*Volume));
+
+  Status = EfiHandleProtocol (
+             VolumeHandle,
+             &gEfiDiskIoProtocolGuid,
+             (VOID **)&Volume->DiskIo
+             );
+
+  if (!EFI_ERROR (Status)) {
+    Status = EfiHandleProtocol (
+               VolumeHandle,
+               &gEfiBlockIoProtocolGuid,
+               (VOID **)&Volume->BlockIo
+               );
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Volume->MediaId = Volume->BlockIo->Media->MediaId;
+
+    Status = InternalFatReadDisk (Volume, 0, sizeof (Sector), Sector);
+  }
+
+  if (EFI_ERROR (Status)) {
+    Status = EFI_UNSUPPORTED;
+  } else {
+    BootSector        = (FAT_BOOT_SECTOR *)Sector;
+    BytesPerSector    = BootSector->BytesPerSector;
+    SectorsPerCluster = BootSector->SectorsPerCluster;
+    FatSectors        = BootSector->FatSize16;
+    TotalSectors      = BootSector->Sectors16;
+
+    if (FatSectors == 0) {
+      FatSectors = BootSector->FatSize32;
+    }
+
+    if (TotalSectors == 0) {
+      TotalSectors = BootSector->Sectors32;
+    }
+
+    RootSectors = (((BootSector->RootEntries * sizeof (FAT_DIRECTORY_ENTRY))
+                      + BytesPerSector - 1) / MAX (BytesPerSector, 1));
+    DataSector  = (BootSector->ReservedSectors
+                    + MultU64x32 (FatSectors, BootSector->NumberOfFats)
+                    + RootSectors);
+
+    // exFAT and NTFS zero the fields checked, so they are rejected here.
+    Status = EFI_UNSUPPORTED;
+
+    if ((Sector[510] == 0x55) && (Sector[511] == 0xAA)
+     && (BytesPerSector >= 512) && (BytesPerSector <= SIZE_4KB)
+     && ((BytesPerSector & (BytesPerSector - 1)) == 0)
+     && (SectorsPerCluster != 0)
+     && ((SectorsPerCluster & (SectorsPerCluster - 1)) == 0)
+     && (BootSector->ReservedSectors != 0)
+     && (BootSector->NumberOfFats != 0)
+     && (FatSectors != 0)
+     && (DataSector < TotalSectors)) {
+      Volume->BytesPerCluster  = (BytesPerSector * SectorsPerCluster);
+      Volume->NumberOfClusters = (UINT32)DivU64x32 (
+                                           (TotalSectors - DataSector),
+                                           SectorsPerCluster
+                                           );
+      Volume->FatOffset        = MultU64x32 (
+                                   BootSector->ReservedSectors,
+                                   BytesPerSector
+                                   );
+      Volume->FatSize          = MultU64x32 (FatSectors, BytesPerSector);
+      Volume->RootOffset       = (Volume->FatOffset
+                                   + MultU64x32 (
+                                       Volume->FatSize,
+                                       BootSector->NumberOfFats
+                                       ));
+      Volume->RootSize         = (RootSectors * BytesPerSector);
+      Volume->DataOffset       = MultU64x32 (DataSector, BytesPerSector);
+
+      // The FAT type is determined by the cluster count only.
+      if (Volume->NumberOfClusters < 4085) {
+        Volume->FatBits = 12;
+      } else if (Volume->NumberOfClusters < 65525) {
+        Volume->FatBits = 16;
+      } else {
+        Volume->FatBits     = 32;
+        Volume->RootCluster = BootSector->RootCluster;
+      }
+
+      if (((Volume->FatBits == 32) == (BootSector->RootEntries == 0))
+       && (Volume->NumberOfClusters <= FAT32_MAX_CLUSTERS)
+       && (DivU64x32 (
+             MultU64x32 (Volume->FatSize, 8),
+             Volume->FatBits
+             ) >= (Volume->NumberOfClusters + FAT_FIRST_CLUSTER))) {
+        Volume->FatWindow = AllocatePool (MISC_FAT_WINDOW_SIZE);
+        Status            = EFI_OUT_OF_RESOURCES;
+
+        if (Volume->FatWindow != NULL) {
+          Status = EFI_SUCCESS;
+        }
+      }
+    }
+  }
+
+  return Status;
+}
+
+// InternalFatIsValidCluster
+STATIC
+BOOLEAN
+InternalFatIsValidCluster (
+  IN CONST MISC_FAT_VOLUME  *Volume,
+  IN UINT32                 Cluster
+  )
+{
+  return (BOOLEAN)((Cluster >= FAT_FIRST_CLUSTER)
+                && ((Cluster - FAT_FIRST_CLUSTER) < Volume->NumberOfClusters));
+}
+
+// InternalFatClusterOffset
+STATIC
+UINT64
+InternalFatClusterOffset (
+  IN CONST MISC_FAT_VOLUME  *Volume,
+  IN UINT32                 Cluster
+  )
+{
+  return (Volume->DataOffset
+           + MultU64x32 (
+               (Cluster - FAT_FIRST_CLUSTER),
+               Volume->BytesPerCluster
+               ));
+}
+
+// InternalFatGetNextCluster
+/** Looks up the successor of a cluster in the first FAT.
+
+  @param[in]  Volume   The volume to look up in.
+  @param[in]  Cluster  The cluster to look up.  Must be valid.
+  @param[out] Next     The next cluster, 0 if the chain ends at Cluster.
+
+  @retval EFI_SUCCESS           The successor has been looked up.
+  @retval EFI_VOLUME_CORRUPTED  The chain is not terminated properly.
+  @retval other                 The error returned by the disk.
+**/
+STATIC
+EFI_STATUS
+InternalFatGetNextCluster (
+  IN OUT MISC_FAT_VOLUME  *Volume,
+  IN     UINT32           Cluster,
+  OUT    UINT32           *Next
+  )
+{
+  EFI_STATUS Status;
+
+  UINT64     Offset;
+  UINTN      Size;
+  UINT8      *Entry;
+  UINT32     Value;
+  UINT32     EndOfChain;
+
+  ASSERT (InternalFatIsValidCluster (Volume, Cluster));
+
+  switch (Volume->FatBits) {
+    case 12:
+    {
+      Offset     = (Cluster + (Cluster / 2));
+      Size       = sizeof (UINT16);
+      EndOfChain = 0x0FF8;
+      break;
+    }
+
+    case 16:
+    {
+      Offset     = MultU64x32 (Cluster, sizeof (UINT16));
+      Size       = sizeof (UINT16);
+      EndOfChain = 0xFFF8;
+      break;
+    }
+
+    default:
+    {
+      Offset     = MultU64x32 (Cluster, sizeof (UINT32));
+      Size       = sizeof (UINT32);
+      EndOfChain = 0x0FFFFFF8;
+      break;
+    }
+  }
+
+  Status = EFI_VOLUME_CORRUPTED;
+
+  if ((Offset + Size) <= Volume->FatSize) {
+    Status = EFI_SUCCESS;
+  }
+
+  // FAT12 entries may straddle windows, so a window is placed to start
+  // shortly below the entry rather than at a multiple of its size.
+  if (!EFI_ERROR (Status)
+   && ((Offset < Volume->FatWindowOffset)
+    || ((Offset + Size)
+          > (Volume->FatWindowOffset + Volume->FatWindowSize)))) {
+    Volume->FatWindowOffset = (Offset & ~(UINT64)(SIZE_4KB - 1));
+    Volume->FatWindowSize   = (UINTN)MIN (
+                                         MISC_FAT_WINDOW_SIZE,
+                                         (Volume->FatSize
+                                           - Volume->FatWindowOffset)
+                                         );
+
+    Status = InternalFatReadDisk (
+               Volume,
+               (Volume->FatOffset + Volume->FatWindowOffset),
+               Volume->FatWindowSize,
+               Volume->FatWindow
+               );
+
+    if (EFI_ERROR (Status)) {
+      Volume->FatWindowSize = 0;
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Entry = &Volume->FatWindow[Offset - Volume->FatWindowOffset];
+
+    if (Volume->FatBits == 32) {
+      Value = (ReadUnaligned32 ((UINT32 *)Entry) & 0x0FFFFFFF);
+    } else {
+      Value = ReadUnaligned16 ((UINT16 *)Entry);
+
+      if (Volume->FatBits == 12) {
+        Value = (((Cluster & 1) != 0) ? (Value >> 4) : (Value & 0x0FFF));
+      }
+    }
+
+    if (Value >= EndOfChain) {
+      *Next = 0;
+    } else if (InternalFatIsValidCluster (Volume, Value)) {
+      *Next = Value;
+    } else {
+      Status = EFI_VOLUME_CORRUPTED;
+    }
+  }
+
+  return Status;
+}
+
+// InternalFatMatchEntry
+/** Matches a short entry and the long name preceding it against a name.
+**/
+STATIC
+BOOLEAN
+InternalFatMatchEntry (
+  IN CONST FAT_DIRECTORY_ENTRY  *Entry,
+  IN CONST MISC_FAT_NAME_STATE  *NameState,
+  IN CONST CHAR16               *Name
+  )
+{
+  BOOLEAN Match;
+
+  CHAR16  ShortName[8 + 1 + 3 + 1];
+  UINTN   Length;
+  UINTN   Index;
+  UINT8   Checksum;
+
+  Match = FALSE;
+
+  if (NameState->Ordinal == 0) {
+    Checksum = 0;
+
+    for (Index = 0; Index < sizeof (Entry->Name); ++Index) {
+      Checksum = (UINT8)((((Checksum & 1) << 7) | (Checksum >> 1))
+                          + Entry->Name[Index]);
+    }
+
+    if (Checksum == NameState->Checksum) {
+      Match = (BOOLEAN)(MiscFileStriCmp (NameState->Name, Name) == 0);
+    }
+  }
+
+  if (!Match) {
+    Length = 0;
+
+    for (Index = 0; (Index < 8) && (Entry->Name[Index] != ' '); ++Index) {
+      ShortName[Length] = Entry->Name[Index];
+      ++Length;
+    }
+
+    if ((Length > 0) && (Entry->Name[0] == FAT_ENTRY_KANJI_E5)) {
+      ShortName[0] = FAT_ENTRY_DELETED;
+    }
+
+    if (Entry->Name[8] != ' ') {
+      ShortName[Length] = L'.';
+      ++Length;
+
+      for (Index = 8; (Index < 11) && (Entry->Name[Index] != ' '); ++Index) {
+        ShortName[Length] = Entry->Name[Index];
+        ++Length;
+      }
+    }
+
+    ShortName[Length] = L'\0';
+
+    Match = (BOOLEAN)(MiscFileStriCmp (ShortName, Name) == 0);
+  }
+
+  return Match;
+}
+
+// InternalFatScanEntries
+/** Scans a block of directory entries for a name.
+
+  @param[in]      Entries          The entries to scan.
+  @param[in]      NumberOfEntries  The number of elements in Entries.
+  @param[in, out] NameState        The long name state carried over from the
+                                   previous block.
+  @param[in]      Name             The name to look for.
+  @param[out]     Found            The entry found.
+
+  @retval EFI_SUCCESS    The name has been found.
+  @retval EFI_NOT_READY  The name has not been found in this block.
+  @retval EFI_NOT_FOUND  The end of the directory has been reached.
+**/
+STATIC
+EFI_STATUS
+InternalFatScanEntries (
+  IN     CONST FAT_DIRECTORY_ENTRY  *Entries,
+  IN     UINTN                      NumberOfEntries,
+  IN OUT MISC_FAT_NAME_STATE        *NameState,
+  IN     CONST CHAR16               *Name,
+  OUT    FAT_DIRECTORY_ENTRY        *Found
+  )
+{
+  EFI_STATUS          Status;
+
+  CONST FAT_LFN_ENTRY *LfnEntry;
+  UINTN               Index;
+  UINT8               Ordinal;
+  CHAR16              *Chars;
+
+  Status = EFI_NOT_READY;
+
+  for (Index = 0; Index < NumberOfEntries; ++Index) {
+    if (Entries[Index].Name[0] == FAT_ENTRY_FREE) {
+      Status = EFI_NOT_FOUND;
+      break;
+    }
+
+    if (Entries[Index].Name[0] == FAT_ENTRY_DELETED) {
+      NameState->Ordinal = FAT_LFN_NONE;
+    } else if (Entries[Index].Attributes == FAT_ATTRIBUTE_LFN) {
+      LfnEntry = (CONST FAT_LFN_ENTRY *)&Entries[Index];
+      Ordinal  = (LfnEntry->Ordinal & FAT_LFN_ORDINAL_MASK);
+
+      // The long name is stored backwards, starting with its last part.
+      if ((LfnEntry->Ordinal & FAT_LFN_LAST) != 0) {
+        NameState->Ordinal  = Ordinal;
+        NameState->Checksum = LfnEntry->Checksum;
+
+        if (Ordinal <= FAT_LFN_MAX_ENTRIES) {
+          NameState->Name[Ordinal * FAT_LFN_CHARS] = L'\0';
+        }
+      }
+
+      if ((Ordinal == 0)
+       || (Ordinal > FAT_LFN_MAX_ENTRIES)
+       || (Ordinal != NameState->Ordinal)
+       || (LfnEntry->Checksum != NameState->Checksum)) {
+        NameState->Ordinal = FAT_LFN_NONE;
+      } else {
+        Chars = &NameState->Name[(Ordinal - 1) * FAT_LFN_CHARS];
+
+        CopyMem (Chars, LfnEntry->Name1, sizeof (LfnEntry->Name1));
+        Chars += ARRAY_SIZE (LfnEntry->Name1);
+        CopyMem (Chars, LfnEntry->Name2, sizeof (LfnEntry->Name2));
+        Chars += ARRAY_SIZE (LfnEntry->Name2);
+        CopyMem (Chars, LfnEntry->Name3, sizeof (LfnEntry->Name3));
+
+        --NameState->Ordinal;
+      }
+    } else {
+      if (((Entries[Index].Attributes & FAT_ATTRIBUTE_VOLUME_ID) == 0)
+       && InternalFatMatchEntry (&Entries[Index], NameState, Name)) {
+        CopyMem (
+          (VOID *)Found,
+          (VOID *)&Entries[Index],
+          sizeof (*Found)
+          );
+
+        Status = EFI_SUCCESS;
+        break;
+      }
+
+      NameState->Ordinal = FAT_LFN_NONE;
+    }
+  }
+
+  return Status;
+}
+
+// InternalFatFindEntry
+/** Looks up a name in a directory.
+
+  @param[in, out] Volume     The volume to look up on.
+  @param[in]      Directory  The directory's first cluster, 0 for the fixed
+                             root directory of FAT12 and FAT16 volumes.
+  @param[in]      Name       The name to look up.
+  @param[in]      Buffer     A buffer of at least one cluster's size.
+  @param[out]     Entry      The entry found.
+
+  @retval EFI_SUCCESS           The name has been found.
+  @retval EFI_NOT_FOUND         The name has not been found.
+  @retval EFI_VOLUME_CORRUPTED  The directory's cluster chain is broken.
+  @retval other                 The error returned by the disk.
+**/
+STATIC
+EFI_STATUS
+InternalFatFindEntry (
+  IN OUT MISC_FAT_VOLUME      *Volume,
+  IN     UINT32               Directory,
+  IN     CONST CHAR16         *Name,
+  IN     VOID                 *Buffer,
+  OUT    FAT_DIRECTORY_ENTRY  *Entry
+  )
+{
+  EFI_STATUS          Status;
+
+  MISC_FAT_NAME_STATE NameState;
+  UINT32              Cluster;
+  UINT32              NumberOfClusters;
+
+  NameState.Ordinal = FAT_LFN_NONE;
+
+  if (Directory == 0) {
+    Status = InternalFatReadDisk (
+               Volume,
+               Volume->RootOffset,
+               Volume->RootSize,
+               Buffer
+               );
+
+    if (!EFI_ERROR (Status)) {
+      Status = InternalFatScanEntries (
+                 (CONST FAT_DIRECTORY_ENTRY *)Buffer,
+                 (Volume->RootSize / sizeof (FAT_DIRECTORY_ENTRY)),
+                 &NameState,
+                 Name,
+                 Entry
+                 );
+    }
+  } else {
+    Cluster          = Directory;
+    NumberOfClusters = 0;
+    Status           = EFI_VOLUME_CORRUPTED;
+
+    if (InternalFatIsValidCluster (Volume, Cluster)) {
+      do {
+        Status = InternalFatReadDisk (
+                   Volume,
+                   InternalFatClusterOffset (Volume, Cluster),
+                   Volume->BytesPerCluster,
+                   Buffer
+                   );
+
+        if (!EFI_ERROR (Status)) {
+          Status = InternalFatScanEntries (
+                     (CONST FAT_DIRECTORY_ENTRY *)Buffer,
+                     (Volume->BytesPerCluster
+                       / sizeof (FAT_DIRECTORY_ENTRY)),
+                     &NameState,
+                     Name,
+                     Entry
+                     );
+        }
+
+        if (Status == EFI_NOT_READY) {
+          Status = InternalFatGetNextCluster (Volume, Cluster, &Cluster);
+
+          // Guard against cyclic chains.
+          ++NumberOfClusters;
+
+          if (NumberOfClusters >= Volume->NumberOfClusters) {
+            Status = EFI_VOLUME_CORRUPTED;
+          }
+
+          if (!EFI_ERROR (Status)) {
+            Status = EFI_NOT_READY;
+
+            if (Cluster == 0) {
+              Status = EFI_NOT_FOUND;
+            }
+          }
+        }
+      } while (Status == EFI_NOT_READY);
+    }
+  }
+
+  if (Status == EFI_NOT_READY) {
+    Status = EFI_NOT_FOUND;
+  }
+
+  return Status;
+}
+
+// InternalFatFindFile
+/** Resolves a path to the directory entry of a file.
+
+  Only plain paths are resolved, "." and ".." components are reported as
+  unsupported.
+
+  @retval EFI_SUCCESS           The file has been found.
+  @retval EFI_NOT_FOUND         A path component has not been found.
+  @retval EFI_UNSUPPORTED       The path is not supported.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval other                 The error returned by the disk.
+**/
+STATIC
+EFI_STATUS
+InternalFatFindFile (
+  IN OUT MISC_FAT_VOLUME      *Volume,
+  IN     CONST CHAR16         *FileName,
+  OUT    FAT_DIRECTORY_ENTRY  *Entry
+  )
+{
+  EFI_STATUS Status;
+
+  VOID       *Buffer;
+  CHAR16     Name[(FAT_LFN_MAX_ENTRIES * FAT_LFN_CHARS) + 1];
+  UINT32     Directory;
+  UINTN      Length;
+
+  Buffer = AllocatePool (MAX (Volume->BytesPerCluster, Volume->RootSize));
+  Status = EFI_OUT_OF_RESOURCES;
+
+  if (Buffer != NULL) {
+    Directory = ((Volume->FatBits == 32) ? Volume->RootCluster : 0);
+    Status    = EFI_NOT_FOUND;
+
+    while (*FileName != L'\0') {
+      while (*FileName == L'\\') {
+        ++FileName;
+      }
+
+      for (Length = 0; FileName[Length] != L'\0'; ++Length) {
+        if (FileName[Length] == L'\\') {
+          break;
+        }
+      }
+
+      if (Length == 0) {
+        break;
+      }
+
+      if ((Length >= ARRAY_SIZE (Name))
+       || (*FileName == L'.')
+       || ((Status == EFI_SUCCESS)
+        && ((Entry->Attributes & FAT_ATTRIBUTE_DIRECTORY) == 0))) {
+        Status = EFI_UNSUPPORTED;
+        break;
+      }
+
+      CopyMem ((VOID *)Name, (VOID *)FileName, (Length * sizeof (*Name)));
+      Name[Length] = L'\0';
+      FileName    += Length;
+
+      if (Status == EFI_SUCCESS) {
+        Directory = Entry->FirstClusterLow;
+
+        if (Volume->FatBits == 32) {
+          Directory |= ((UINT32)Entry->FirstClusterHigh << 16);
+        }
+      }
+
+      Status = InternalFatFindEntry (Volume, Directory, Name, Buffer, Entry);
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+    }
+
+    FreePool (Buffer);
+  }
+
+  return Status;
+}
+
+// InternalFatGetExtents
+/** Follows a file's cluster chain and coalesces it into extents.
+**/
+STATIC
+EFI_STATUS
+InternalFatGetExtents (
+  IN OUT MISC_FAT_VOLUME            *Volume,
+  IN     CONST FAT_DIRECTORY_ENTRY  *Entry,
+  OUT    UINTN                      *NumberOfExtents,
+  OUT    MISC_FILE_EXTENT           **Extents
+  )
+{
+  EFI_STATUS       Status;
+
+  MISC_FILE_EXTENT *Buffer;
+  UINTN            BufferSize;
+  UINTN            Count;
+  UINT32           Cluster;
+  UINT32           PreviousCluster;
+  UINT32           Remaining;
+  UINT32           Length;
+
+  Buffer     = NULL;
+  BufferSize = 0;
+  Count      = 0;
+  Status     = EFI_SUCCESS;
+  Remaining  = Entry->FileSize;
+  Cluster    = Entry->FirstClusterLow;
+
+  if (Volume->FatBits == 32) {
+    Cluster |= ((UINT32)Entry->FirstClusterHigh << 16);
+  }
+
+  PreviousCluster = 0;
+
+  // Only the clusters covering the file size are followed, the size is
+  // bounded so cyclic chains terminate as well.
+  while (Remaining > 0) {
+    if (!InternalFatIsValidCluster (Volume, Cluster)) {
+      Status = EFI_VOLUME_CORRUPTED;
+      break;
+    }
+
+    Length = MIN (Remaining, Volume->BytesPerCluster);
+
+    if ((Count > 0) && (Cluster == (PreviousCluster + 1))) {
+      Buffer[Count - 1].Length += Length;
+    } else {
+      Status = InternalGrowBuffer (
+                 (VOID **)&Buffer,
+                 &BufferSize,
+                 ((Count + 1) * sizeof (*Buffer))
+                 );
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+
+      Buffer[Count].Offset = InternalFatClusterOffset (Volume, Cluster);
+      Buffer[Count].Length = Length;
+      ++Count;
+    }
+
+    Remaining      -= Length;
+    PreviousCluster = Cluster;
+
+    if (Remaining > 0) {
+      Status = InternalFatGetNextCluster (Volume, Cluster, &Cluster);
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    *NumberOfExtents = Count;
+    *Extents         = Buffer;
+  } else if (Buffer != NULL) {
+    FreePool ((VOID *)Buffer);
+  }
+
+  return Status;
+}
+
+// MiscGetFileExtents
+/** Resolves a file on a FAT volume into the extents it occupies.
+
+  The volume's FAT is parsed directly from its disk, bypassing the file
+  system driver.  Data written through the driver but not flushed yet is not
+  reflected.
+
+  @param[in]  VolumeHandle     The handle of the volume's file system.  Must
+                               provide Disk I/O and Block I/O.
+  @param[in]  FileName         The path of the file to resolve.
+  @param[out] FileSize         The size, in bytes, of the file.
+  @param[out] NumberOfExtents  The number of elements in Extents.
+  @param[out] Extents          The extents in file order, their offsets
+                               relative to the volume's start.  The lengths
+                               sum up to FileSize.  Free with FreePool().
+
+  @retval EFI_SUCCESS           The file has been resolved.
+  @retval EFI_UNSUPPORTED       The volume is not FAT formatted or the path
+                                or file are not supported.
+  @retval EFI_NOT_FOUND         The file has not been found.
+  @retval EFI_VOLUME_CORRUPTED  A cluster chain is broken.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval other                 The error returned by the disk.
+**/
+EFI_STATUS
+MiscGetFileExtents (
+  IN  EFI_HANDLE        VolumeHandle,
+  IN  CONST CHAR16      *FileName,
+  OUT UINT64            *FileSize,
+  OUT UINTN             *NumberOfExtents,
+  OUT MISC_FILE_EXTENT  **Extents
+  )
+{
+  EFI_STATUS          Status;
+
+  MISC_FAT_VOLUME     Volume;
+  FAT_DIRECTORY_ENTRY Entry;
+
+  ASSERT (VolumeHandle != NULL);
+  ASSERT (FileName != NULL);
+  ASSERT (FileSize != NULL);
+  ASSERT (NumberOfExtents != NULL);
+  ASSERT (Extents != NULL);
+  ASSERT (!EfiAtRuntime ());
+
+  Status = InternalFatOpenVolume (VolumeHandle, &Volume);
+
+  if (!EFI_ERROR (Status)) {
+    Status = InternalFatFindFile (&Volume, FileName, &Entry);
+
+    if (!EFI_ERROR (Status)
+     && ((Entry.Attributes & FAT_ATTRIBUTE_DIRECTORY) != 0)) {
+      Status = EFI_UNSUPPORTED;
+    }
+
+    if (!EFI_ERROR (Status)) {
+      Status = InternalFatGetExtents (
+                 &Volume,
+                 &Entry,
+                 NumberOfExtents,
+                 Extents
+                 );
+    }
+
+    if (!EFI_ERROR (Status)) {
+      *FileSize = Entry.FileSize;
+    }
+
+    FreePool ((VOID *)Volume.FatWindow);
+  }
+
+  return Status;
+}
+
+// InternalReadExtent
+/** Reads an extent, the block-aligned part through Block I/O.
+**/
+STATIC
+EFI_STATUS
+InternalReadExtent (
+  IN  EFI_DISK_IO_PROTOCOL    *DiskIo,
+  IN  EFI_BLOCK_IO_PROTOCOL   *BlockIo,
+  IN  UINT32                  MediaId,
+  IN  CONST MISC_FILE_EXTENT  *Extent,
+  OUT UINT8                   *Buffer
+  )
+{
+  EFI_STATUS Status;
+
+  UINT32     BlockSize;
+  UINT32     IoAlign;
+  UINT32     Remainder;
+  UINT64     Lba;
+  UINTN      Length;
+  UINTN      AlignedLength;
+
+  BlockSize     = BlockIo->Media->BlockSize;
+  IoAlign       = BlockIo->Media->IoAlign;
+  Length        = (UINTN)Extent->Length;
+  AlignedLength = 0;
+  Status        = EFI_SUCCESS;
+
+  // Block I/O avoids the Disk I/O cache and bounce buffers for large reads.
+  Lba = DivU64x32Remainder (Extent->Offset, BlockSize, &Remainder);
+
+  if ((Remainder == 0)
+   && ((IoAlign <= 1) || (((UINTN)Buffer & (IoAlign - 1)) == 0))) {
+    AlignedLength = (Length - (Length % BlockSize));
+  }
+
+  if (AlignedLength > 0) {
+    Status = BlockIo->ReadBlocks (
+                        BlockIo,
+                        MediaId,
+                        Lba,
+                        AlignedLength,
+                        (VOID *)Buffer
+                        );
+  }
+
+  if (!EFI_ERROR (Status) && (AlignedLength < Length)) {
+    Status = DiskIo->ReadDisk (
+                       DiskIo,
+                       MediaId,
+                       (Extent->Offset + AlignedLength),
+                       (Length - AlignedLength),
+                       (VOID *)&Buffer[AlignedLength]
+                       );
+  }
+
+  return Status;
+}
+
+// InternalLoadFileByExtents
+/** Loads a file by its extents, verifying its size with the file system.
+**/
+STATIC
+EFI_STATUS
+InternalLoadFileByExtents (
+  IN  EFI_HANDLE       VolumeHandle,
+  IN  EFI_FILE_HANDLE  Root,
+  IN  CHAR16           *FileName,
+  OUT UINTN            *BufferSize,
+  OUT VOID             **Buffer
+  )
+{
+  EFI_STATUS            Status;
+
+  EFI_DISK_IO_PROTOCOL  *DiskIo;
+  EFI_BLOCK_IO_PROTOCOL *BlockIo;
+  UINT32                MediaId;
+  UINT64                FileSize;
+  UINTN                 NumberOfExtents;
+  MISC_FILE_EXTENT      *Extents;
+  EFI_FILE_HANDLE       FileHandle;
+  EFI_FILE_INFO         *FileInfo;
+  UINT8                 *Data;
+  UINTN                 Offset;
+  UINTN                 Index;
+
+  Status = MiscGetFileExtents (
+             VolumeHandle,
+             FileName,
+             &FileSize,
+             &NumberOfExtents,
+             &Extents
+             );
+
+  if (!EFI_ERROR (Status)) {
+    // The size cross-checks the path resolution against the file system's.
+    Status = Root->Open (Root, &FileHandle, FileName, EFI_FILE_MODE_READ, 0);
+
+    if (!EFI_ERROR (Status)) {
+      FileInfo = FileHandleGetInfo (FileHandle);
+      Status   = EFI_UNSUPPORTED;
+
+      if (FileInfo != NULL) {
+        if ((FileInfo->FileSize == FileSize)
+         && (FileSize > 0)
+         && (FileSize <= MAX_UINTN)) {
+          Status = EFI_SUCCESS;
+        }
+
+        FreePool ((VOID *)FileInfo);
+      }
+
+      FileHandleClose (FileHandle);
+    }
+
+    if (!EFI_ERROR (Status)) {
+      Status = EfiHandleProtocol (
+                 VolumeHandle,
+                 &gEfiDiskIoProtocolGuid,
+                 (VOID **)&DiskIo
+                 );
+    }
+
+    if (!EFI_ERROR (Status)) {
+      Status = EfiHandleProtocol (
+                 VolumeHandle,
+                 &gEfiBlockIoProtocolGuid,
+                 (VOID **)&BlockIo
+                 );
+    }
+
+    if (!EFI_ERROR (Status)) {
+      MediaId = BlockIo->Media->MediaId;
+      Data    = AllocatePool ((UINTN)FileSize);
+      Status  = EFI_OUT_OF_RESOURCES;
+
+      if (Data != NULL) {
+        Status = EFI_SUCCESS;
+        Offset = 0;
+
+        for (Index = 0; Index < NumberOfExtents; ++Index) {
+          Status = InternalReadExtent (
+                     DiskIo,
+                     BlockIo,
+                     MediaId,
+                     &Extents[Index],
+                     &Data[Offset]
+                     );
+
+          if (EFI_ERROR (Status)) {
+            break;
+          }
+
+          Offset += (UINTN)Extents[Index].Length;
+        }
+
+        if (!EFI_ERROR (Status)) {
+          *BufferSize = (UINTN)FileSize;
+          *Buffer     = (VOID *)Data;
+        } else {
+          FreePool ((VOID *)Data);
+        }
+      }
+    }
+
+    FreePool ((VOID *)Extents);
+  }
+
+  return Status;
+}
+
+// MiscLoadFileByExtents
+/** Loads a file from a FAT volume by reading its extents from the disk.
+
+  Large files are read with one Block I/O request per contiguous extent
+  instead of cluster by cluster through the file system driver.  The file is
+  loaded as by LoadFile() if the volume is not FAT formatted, the file cannot
+  be resolved or its size does not match the one reported by the file system,
+  or the disk fails.
+
+  @param[in]  VolumeHandle  The handle of the volume's file system.
+  @param[in]  Root          The volume's opened root.
+  @param[in]  FileName      The path of the file to load.
+  @param[out] BufferSize    The size, in bytes, of the loaded file.
+  @param[out] Buffer        The loaded file.  Free with FreePool().
+
+  @return  Returned is the status of the load.
+**/
+EFI_STATUS
+MiscLoadFileByExtents (
+  IN  EFI_HANDLE       VolumeHandle,
+  IN  EFI_FILE_HANDLE  Root,
+  IN  CHAR16           *FileName,
+  OUT UINTN            *BufferSize,
+  OUT VOID             **Buffer
+  )
+{
+  EFI_STATUS Status;
+
+  UINT16     PathId;
+
+  ASSERT (VolumeHandle != NULL);
+  ASSERT (Root != NULL);
+  ASSERT (FileName != NULL);
+  ASSERT (BufferSize != NULL);
+  ASSERT (Buffer != NULL);
+  ASSERT (!EfiAtRuntime ());
+
+  Status = InternalLoadFileByExtents (
+             VolumeHandle,
+             Root,
+             FileName,
+             BufferSize,
+             Buffer
+             );
+
+  if (!EFI_ERROR (Status)) {
+    PathId = InternalTraceFileOpen (FileName);
+    InternalTraceFileRead (PathId, 0, *BufferSize);
+  } else {
+    Status = LoadFile (Root, FileName, BufferSize, Buffer);
+  }
+
+  return Status;
+}
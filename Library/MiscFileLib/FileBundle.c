@@ -0,0 +1,386 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Guid/FileInfo.h>
+
+#include <IndustryStandard/MiscFileBundle.h>
+
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscFileLib.h>
+#include <Library/MiscRuntimeLib.h>
+
+#include "MiscFileLibInternal.h"
+
+// MISC_FILE_BUNDLE_EMPTY_BUCKET
+#define MISC_FILE_BUNDLE_EMPTY_BUCKET  MAX_UINT32
+
+// MISC_FILE_BUNDLE
+struct MISC_FILE_BUNDLE {
+  VOID                         *Data;      ///< The loaded bundle file.
+  UINTN                        DataSize;
+  CONST MISC_FILE_BUNDLE_ENTRY *Entries;
+  UINTN                        NumberOfEntries;
+  UINTN                        BucketMask;
+  UINT32                       *Buckets;   ///< Entry indices, open addressed.
+};
+
+// InternalHashBundleName
+/** Hashes a name case-insensitively with FNV-1a.
+
+  @param[in] Name  The NUL-terminated name to hash.
+
+  @return  Returned is the hash of Name.
+**/
+STATIC
+UINT32
+InternalHashBundleName (
+  IN CONST CHAR16  *Name
+  )
+{
+  UINT32 Hash;
+  CHAR16 Char;
+
+  Hash = 0x811C9DC5U;
+
+  for (Char = *Name; Char != L'\0'; Char = *(++Name)) {
+    Char = MISC_FILE_CHAR_TO_UPPER (Char);
+    Hash = ((Hash ^ (UINT8)Char) * 0x01000193U);
+    Hash = ((Hash ^ (UINT8)(Char >> 8)) * 0x01000193U);
+  }
+
+  return Hash;
+}
+
+// InternalBundleName
+/** Returns an entry's name if it is contained in the bundle.
+
+  @param[in] Data      The bundle.
+  @param[in] DataSize  The size, in bytes, of Data.
+  @param[in] Entry     The entry whose name to return.
+
+  @return  Returned is the name or NULL if it is malformed.
+**/
+STATIC
+CONST CHAR16 *
+InternalBundleName (
+  IN CONST VOID                    *Data,
+  IN UINTN                         DataSize,
+  IN CONST MISC_FILE_BUNDLE_ENTRY  *Entry
+  )
+{
+  CONST CHAR16 *Name;
+
+  UINTN        Index;
+  UINTN        MaxLength;
+
+  Name = NULL;
+
+  if (((Entry->NameOffset % sizeof (CHAR16)) == 0)
+   && (Entry->NameOffset < DataSize)) {
+    Name      = (CONST CHAR16 *)((CONST UINT8 *)Data + Entry->NameOffset);
+    MaxLength = ((DataSize - Entry->NameOffset) / sizeof (CHAR16));
+
+    for (Index = 0; Index < MaxLength; ++Index) {
+      if (Name[Index] == L'\0') {
+        break;
+      }
+    }
+
+    if ((Index == 0) || (Index == MaxLength)) {
+      Name = NULL;
+    }
+  }
+
+  return Name;
+}
+
+// InternalLookupBundleEntry
+/** Looks up the bucket of a name.
+
+  @param[in] Bundle  The bundle to search.
+  @param[in] Name    The name to look up.
+
+  @return  Returned is the bucket holding Name or the empty bucket it would
+           be inserted at.
+**/
+STATIC
+UINT32 *
+InternalLookupBundleEntry (
+  IN CONST MISC_FILE_BUNDLE  *Bundle,
+  IN CONST CHAR16            *Name
+  )
+{
+  UINT32 *Bucket;
+
+  UINTN  Index;
+
+  Index = (InternalHashBundleName (Name) & Bundle->BucketMask);
+
+  while (TRUE) {
+    Bucket = &Bundle->Buckets[Index];
+
+    if ((*Bucket == MISC_FILE_BUNDLE_EMPTY_BUCKET)
+     || (MiscFileStriCmp (
+           Name,
+           (CONST CHAR16 *)((CONST UINT8 *)Bundle->Data
+                              + Bundle->Entries[*Bucket].NameOffset)
+           ) == 0)) {
+      break;
+    }
+
+    Index = ((Index + 1) & Bundle->BucketMask);
+  }
+
+  return Bucket;
+}
+
+// MiscOpenFileBundle
+/** Loads a file bundle and indexes its entries.
+
+  The bundle is loaded with a single read and its index is hashed once, so
+  every lookup afterwards is served from memory.  Duplicate names resolve to
+  their first entry.
+
+  @param[in]  Root      The volume's opened root.
+  @param[in]  FileName  The path of the bundle file.
+  @param[out] Bundle    The opened bundle.
+
+  @retval EFI_SUCCESS           The bundle has been opened.
+  @retval EFI_VOLUME_CORRUPTED  The bundle is malformed.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval other                 The error returned by the file system.
+**/
+EFI_STATUS
+MiscOpenFileBundle (
+  IN  EFI_FILE_HANDLE   Root,
+  IN  CHAR16            *FileName,
+  OUT MISC_FILE_BUNDLE  **Bundle
+  )
+{
+  EFI_STATUS                    Status;
+
+  VOID                          *Data;
+  UINTN                         DataSize;
+  CONST MISC_FILE_BUNDLE_HEADER *Header;
+  CONST MISC_FILE_BUNDLE_ENTRY  *Entry;
+  MISC_FILE_BUNDLE              *NewBundle;
+  UINTN                         NumberOfBuckets;
+  UINT32                        Index;
+  CONST CHAR16                  *Name;
+  UINT32                        *Bucket;
+
+  ASSERT (Root != NULL);
+  ASSERT (FileName != NULL);
+  ASSERT (Bundle != NULL);
+  ASSERT (!EfiAtRuntime ());
+
+  Status = LoadFile (Root, FileName, &DataSize, &Data);
+
+  if (!EFI_ERROR (Status)) {
+    Header = (CONST MISC_FILE_BUNDLE_HEADER *)Data;
+    Status = EFI_VOLUME_CORRUPTED;
+
+    if ((DataSize >= sizeof (*Header))
+     && (Header->Signature == MISC_FILE_BUNDLE_SIGNATURE)
+     && (Header->Revision == MISC_FILE_BUNDLE_REVISION)
+     && (Header->NumberOfEntries
+           <= ((DataSize - sizeof (*Header)) / sizeof (*Entry)))) {
+      // Keep the buckets less than half full.
+      NumberOfBuckets = (UINTN)GetPowerOfTwo64 (
+                                 ((UINT64)Header->NumberOfEntries * 2) + 1
+                                 );
+
+      NumberOfBuckets *= 2;
+
+      NewBundle = AllocatePool (
+                    sizeof (*NewBundle)
+                      + (NumberOfBuckets * sizeof (*NewBundle->Buckets))
+                    );
+
+      Status = EFI_OUT_OF_RESOURCES;
+
+      if (NewBundle != NULL) {
+        NewBundle->Data            = Data;
+        NewBundle->DataSize        = DataSize;
+        NewBundle->Entries         = (CONST VOID *)(Header + 1);
+        NewBundle->NumberOfEntries = Header->NumberOfEntries;
+        NewBundle->BucketMask      = (NumberOfBuckets - 1);
+        NewBundle->Buckets         = (UINT32 *)(NewBundle + 1);
+
+        SetMem32 (
+          (VOID *)NewBundle->Buckets,
+          (NumberOfBuckets * sizeof (*NewBundle->Buckets)),
+          MISC_FILE_BUNDLE_EMPTY_BUCKET
+          );
+
+        Status = EFI_SUCCESS;
+
+        for (Index = 0; Index < Header->NumberOfEntries; ++Index) {
+          Entry = &NewBundle->Entries[Index];
+          Name  = InternalBundleName (Data, DataSize, Entry);
+
+          if ((Name == NULL)
+           || (Entry->DataOffset > DataSize)
+           || (Entry->DataSize > (DataSize - Entry->DataOffset))) {
+            Status = EFI_VOLUME_CORRUPTED;
+            break;
+          }
+
+          Bucket = InternalLookupBundleEntry (NewBundle, Name);
+
+          if (*Bucket == MISC_FILE_BUNDLE_EMPTY_BUCKET) {
+            *Bucket = Index;
+          }
+        }
+
+        if (!EFI_ERROR (Status)) {
+          *Bundle = NewBundle;
+        } else {
+          FreePool ((VOID *)NewBundle);
+        }
+      }
+    }
+
+    if (EFI_ERROR (Status)) {
+      FreePool (Data);
+    }
+  }
+
+  return Status;
+}
+
+// MiscCloseFileBundle
+/** Frees a bundle opened by MiscOpenFileBundle().
+
+  All pointers returned by MiscFindBundledFile() become invalid.
+
+  @param[in] Bundle  The bundle to close.
+**/
+VOID
+MiscCloseFileBundle (
+  IN MISC_FILE_BUNDLE  *Bundle
+  )
+{
+  ASSERT (Bundle != NULL);
+
+  FreePool (Bundle->Data);
+  FreePool ((VOID *)Bundle);
+}
+
+// MiscFindBundledFile
+/** Looks up a file in a bundle.
+
+  @param[in]  Bundle      The bundle to search.
+  @param[in]  FileName    The file's path within the bundle.
+  @param[out] BufferSize  The size, in bytes, of the file.
+  @param[out] Buffer      The file's data within the bundle.  It remains valid
+                          until the bundle is closed and must not be freed.
+
+  @retval EFI_SUCCESS    The file has been found.
+  @retval EFI_NOT_FOUND  The bundle does not contain FileName.
+**/
+EFI_STATUS
+MiscFindBundledFile (
+  IN  CONST MISC_FILE_BUNDLE  *Bundle,
+  IN  CONST CHAR16            *FileName,
+  OUT UINTN                   *BufferSize,
+  OUT CONST VOID              **Buffer
+  )
+{
+  EFI_STATUS                   Status;
+
+  UINT32                       *Bucket;
+  CONST MISC_FILE_BUNDLE_ENTRY *Entry;
+
+  ASSERT (Bundle != NULL);
+  ASSERT (FileName != NULL);
+  ASSERT (BufferSize != NULL);
+  ASSERT (Buffer != NULL);
+
+  Status = EFI_NOT_FOUND;
+  Bucket = InternalLookupBundleEntry (Bundle, FileName);
+
+  if (*Bucket != MISC_FILE_BUNDLE_EMPTY_BUCKET) {
+    Entry       = &Bundle->Entries[*Bucket];
+    *BufferSize = Entry->DataSize;
+    *Buffer     = (CONST VOID *)((CONST UINT8 *)Bundle->Data
+                                   + Entry->DataOffset);
+
+    Status = EFI_SUCCESS;
+  }
+
+  return Status;
+}
+
+// MiscGetBundledFileCount
+/** Returns the number of entries of a bundle, including duplicates.
+
+  @param[in] Bundle  The bundle to query.
+
+  @return  Returned is the number of entries of Bundle.
+**/
+UINTN
+MiscGetBundledFileCount (
+  IN CONST MISC_FILE_BUNDLE  *Bundle
+  )
+{
+  ASSERT (Bundle != NULL);
+
+  return Bundle->NumberOfEntries;
+}
+
+// MiscGetBundledFile
+/** Returns an entry of a bundle in index order.
+
+  @param[in]  Bundle      The bundle to query.
+  @param[in]  Index       The index of the entry, less than
+                          MiscGetBundledFileCount().
+  @param[out] FileName    The file's path within the bundle.
+  @param[out] BufferSize  The size, in bytes, of the file.
+  @param[out] Buffer      The file's data within the bundle.  It remains valid
+                          until the bundle is closed and must not be freed.
+**/
+VOID
+MiscGetBundledFile (
+  IN  CONST MISC_FILE_BUNDLE  *Bundle,
+  IN  UINTN                   Index,
+  OUT CONST CHAR16            **FileName,
+  OUT UINTN                   *BufferSize,
+  OUT CONST VOID              **Buffer
+  )
+{
+  CONST MISC_FILE_BUNDLE_ENTRY *Entry;
+
+  ASSERT (Bundle != NULL);
+  ASSERT (Index < Bundle->NumberOfEntries);
+  ASSERT (FileName != NULL);
+  ASSERT (BufferSize != NULL);
+  ASSERT (Buffer != NULL);
+
+  Entry       = &Bundle->Entries[Index];
+  *FileName   = (CONST CHAR16 *)((CONST UINT8 *)Bundle->Data
+                                   + Entry->NameOffset);
+  *BufferSize = Entry->DataSize;
+  *Buffer     = (CONST VOID *)((CONST UINT8 *)Bundle->Data
+                                 + Entry->DataOffset);
+}
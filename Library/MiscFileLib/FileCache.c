@@ -0,0 +1,198 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Guid/FileInfo.h>
+
+#include <Protocol/DevicePath.h>
+#include <Protocol/MiscFileCache.h>
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/EfiBootServicesLib.h>
+#include <Library/FileHandleLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscFileLib.h>
+#include <Library/MiscRuntimeLib.h>
+
+#include "MiscFileLibInternal.h"
+
+// InternalLoadAndCacheFile
+/** Loads an opened file and offers its content to the cache.
+
+  @param[in]  FileCache   The cache to insert into.
+  @param[in]  Key         The content's key.
+  @param[in]  FileHandle  The file to load.
+  @param[out] Buffer      The loaded file.
+
+  @return  Returned is the status of the load.  Failing to cache the content
+           does not fail the load.
+**/
+STATIC
+EFI_STATUS
+InternalLoadAndCacheFile (
+  IN  MISC_FILE_CACHE_PROTOCOL   *FileCache,
+  IN  CONST MISC_FILE_CACHE_KEY  *Key,
+  IN  EFI_FILE_HANDLE            FileHandle,
+  OUT VOID                       **Buffer
+  )
+{
+  EFI_STATUS Status;
+
+  UINTN      DataSize;
+  VOID       *Data;
+
+  DataSize = (UINTN)Key->FileSize;
+  Data     = AllocatePool (DataSize);
+  Status   = EFI_OUT_OF_RESOURCES;
+
+  if (Data != NULL) {
+    Status = MiscReadFileChunked (
+               FileHandle,
+               &DataSize,
+               Data,
+               MAX_UINTN,
+               NULL,
+               NULL
+               );
+
+    if (!EFI_ERROR (Status) && (DataSize != Key->FileSize)) {
+      Status = EFI_END_OF_FILE;
+    }
+
+    if (!EFI_ERROR (Status)) {
+      FileCache->Insert (FileCache, Key, Data);
+
+      *Buffer = Data;
+    } else {
+      FreePool (Data);
+    }
+  }
+
+  return Status;
+}
+
+// MiscLoadFileCached
+/** Loads a file through the file cache shared by all images.
+
+  The content is identified by the volume's device path, the file's path and
+  the file's modification time and size, so a hit costs opening the file and
+  querying its information only.  If the volume has no device path or the
+  cache protocol is not installed, the file is loaded as by LoadFile().
+
+  @param[in]  VolumeHandle  The handle of the volume's file system.
+  @param[in]  Root          The volume's opened root.
+  @param[in]  FileName      The path of the file to load.
+  @param[out] BufferSize    The size, in bytes, of the loaded file.
+  @param[out] Buffer        The loaded file.  Free with FreePool().
+
+  @retval EFI_SUCCESS           The file has been loaded.
+  @retval EFI_UNSUPPORTED       The file is too large to be loaded.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval other                 The error returned by the file system.
+**/
+EFI_STATUS
+MiscLoadFileCached (
+  IN  EFI_HANDLE       VolumeHandle,
+  IN  EFI_FILE_HANDLE  Root,
+  IN  CHAR16           *FileName,
+  OUT UINTN            *BufferSize,
+  OUT VOID             **Buffer
+  )
+{
+  EFI_STATUS               Status;
+
+  MISC_FILE_CACHE_PROTOCOL *FileCache;
+  MISC_FILE_CACHE_KEY      Key;
+  EFI_FILE_HANDLE          FileHandle;
+  EFI_FILE_INFO            *FileInfo;
+  CONST VOID               *CachedData;
+  UINT16                   PathId;
+
+  ASSERT (VolumeHandle != NULL);
+  ASSERT (Root != NULL);
+  ASSERT (FileName != NULL);
+  ASSERT (BufferSize != NULL);
+  ASSERT (Buffer != NULL);
+  ASSERT (!EfiAtRuntime ());
+
+  Status = EfiLocateProtocol (
+             &gMiscFileCacheProtocolGuid,
+             NULL,
+             (VOID **)&FileCache
+             );
+
+  if (!EFI_ERROR (Status)) {
+    Status = EfiHandleProtocol (
+               VolumeHandle,
+               &gEfiDevicePathProtocolGuid,
+               (VOID **)&Key.Volume
+               );
+  }
+
+  if (EFI_ERROR (Status)) {
+    Status = LoadFile (Root, FileName, BufferSize, Buffer);
+  } else {
+    Status = Root->Open (Root, &FileHandle, FileName, EFI_FILE_MODE_READ, 0);
+
+    if (!EFI_ERROR (Status)) {
+      FileInfo = FileHandleGetInfo (FileHandle);
+      Status   = EFI_OUT_OF_RESOURCES;
+
+      if (FileInfo != NULL) {
+        Key.FileName         = FileName;
+        Key.ModificationTime = FileInfo->ModificationTime;
+        Key.FileSize         = FileInfo->FileSize;
+
+        FreePool ((VOID *)FileInfo);
+
+        Status = EFI_UNSUPPORTED;
+
+        if (Key.FileSize <= MAX_UINTN) {
+          Status = FileCache->Lookup (FileCache, &Key, &CachedData);
+
+          if (!EFI_ERROR (Status)) {
+            *Buffer = AllocateCopyPool ((UINTN)Key.FileSize, CachedData);
+
+            FileCache->Release (FileCache, CachedData);
+
+            Status = ((*Buffer != NULL) ? EFI_SUCCESS : EFI_OUT_OF_RESOURCES);
+          } else {
+            Status = InternalLoadAndCacheFile (
+                       FileCache,
+                       &Key,
+                       FileHandle,
+                       Buffer
+                       );
+          }
+
+          if (!EFI_ERROR (Status)) {
+            *BufferSize = (UINTN)Key.FileSize;
+
+            PathId = InternalTraceFileOpen (FileName);
+            InternalTraceFileRead (PathId, 0, *BufferSize);
+          }
+        }
+      }
+
+      FileHandleClose (FileHandle);
+    }
+  }
+
+  return Status;
+}
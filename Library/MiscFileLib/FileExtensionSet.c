@@ -0,0 +1,397 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Guid/FileInfo.h>
+
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/FileHandleLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscFileLib.h>
+#include <Library/MiscRuntimeLib.h>
+
+#include "MiscFileLibInternal.h"
+
+// MISC_FILE_EXTENSION_SET_ENTRY
+typedef struct {
+  CONST CHAR16 *Extension;  ///< The upper-cased extension.
+  UINTN        Type;        ///< The index the extension has been passed at.
+} MISC_FILE_EXTENSION_SET_ENTRY;
+
+// MISC_FILE_EXTENSION_SET
+struct MISC_FILE_EXTENSION_SET {
+  BOOLEAN                       PrimaryExtension;
+  UINTN                         NumberOfEntries;
+  MISC_FILE_EXTENSION_SET_ENTRY *Entries;  ///< Sorted by Extension.
+};
+
+// MISC_FILE_SCAN_INITIAL_ENTRIES
+#define MISC_FILE_SCAN_INITIAL_ENTRIES  16
+
+// InternalCompareFoldedExtension
+/** Compares an extension case-insensitively against an upper-cased one.
+
+  @param[in] Extension        The extension to compare.
+  @param[in] FoldedExtension  The upper-cased extension to compare against.
+
+  @return  Returned is the difference of the first mismatching characters.
+**/
+STATIC
+INTN
+InternalCompareFoldedExtension (
+  IN CONST CHAR16  *Extension,
+  IN CONST CHAR16  *FoldedExtension
+  )
+{
+  CHAR16 Char;
+
+  ASSERT (Extension != NULL);
+  ASSERT (FoldedExtension != NULL);
+
+  Char = MISC_FILE_CHAR_TO_UPPER (*Extension);
+
+  while ((Char == *FoldedExtension) && (Char != L'\0')) {
+    ++Extension;
+    ++FoldedExtension;
+
+    Char = MISC_FILE_CHAR_TO_UPPER (*Extension);
+  }
+
+  return ((INTN)Char - (INTN)*FoldedExtension);
+}
+
+// MiscCreateFileExtensionSet
+/** Compiles a list of extensions into a set for case-insensitive lookups.
+
+  Duplicate extensions are dropped, the first occurence determines the Type.
+
+  @param[in] Extensions          The extensions to compile, without a leading
+                                 '.'.
+  @param[in] NumberOfExtensions  The number of elements in Extensions.
+  @param[in] PrimaryExtension    Whether file names shall be matched by their
+                                 primary extension.
+
+  @return  Returned is the compiled set or NULL on allocation failure.
+**/
+MISC_FILE_EXTENSION_SET *
+MiscCreateFileExtensionSet (
+  IN CONST CHAR16  **Extensions,
+  IN UINTN         NumberOfExtensions,
+  IN BOOLEAN       PrimaryExtension
+  )
+{
+  MISC_FILE_EXTENSION_SET       *Set;
+
+  UINTN                         Size;
+  UINTN                         Index;
+  UINTN                         Index2;
+  UINTN                         NumberOfEntries;
+  CHAR16                        *Strings;
+  CHAR16                        *Extension;
+  MISC_FILE_EXTENSION_SET_ENTRY Entry;
+  INTN                          Result;
+
+  ASSERT (Extensions != NULL);
+  ASSERT (NumberOfExtensions > 0);
+
+  Size = 0;
+
+  for (Index = 0; Index < NumberOfExtensions; ++Index) {
+    ASSERT (Extensions[Index] != NULL);
+    ASSERT (Extensions[Index][0] != L'\0');
+
+    Size += StrSize (Extensions[Index]);
+  }
+
+  Set = AllocatePool (
+          sizeof (*Set)
+            + (NumberOfExtensions * sizeof (*Set->Entries))
+            + Size
+          );
+
+  if (Set != NULL) {
+    Set->PrimaryExtension = PrimaryExtension;
+    Set->Entries          = (MISC_FILE_EXTENSION_SET_ENTRY *)(Set + 1);
+
+    Strings         = (CHAR16 *)&Set->Entries[NumberOfExtensions];
+    NumberOfEntries = 0;
+
+    for (Index = 0; Index < NumberOfExtensions; ++Index) {
+      Extension = Strings;
+
+      do {
+        *Strings = MISC_FILE_CHAR_TO_UPPER (
+                     Extensions[Index][Strings - Extension]
+                     );
+
+        ++Strings;
+      } while (Strings[-1] != L'\0');
+
+      Entry.Extension = Extension;
+      Entry.Type      = Index;
+
+      // Insertion sort, the sets are expected to be small.
+
+      Result = 1;
+
+      for (Index2 = NumberOfEntries; Index2 > 0; --Index2) {
+        Result = StrCmp (Set->Entries[Index2 - 1].Extension, Extension);
+
+        if (Result <= 0) {
+          break;
+        }
+      }
+
+      if (Result != 0) {
+        CopyMem (
+          (VOID *)&Set->Entries[Index2 + 1],
+          (VOID *)&Set->Entries[Index2],
+          ((NumberOfEntries - Index2) * sizeof (*Set->Entries))
+          );
+
+        CopyMem (
+          (VOID *)&Set->Entries[Index2],
+          (VOID *)&Entry,
+          sizeof (Entry)
+          );
+
+        ++NumberOfEntries;
+      }
+    }
+
+    Set->NumberOfEntries = NumberOfEntries;
+  }
+
+  return Set;
+}
+
+// MiscFreeFileExtensionSet
+/** Frees a set returned by MiscCreateFileExtensionSet().
+
+  @param[in] Set  The set to free.
+**/
+VOID
+MiscFreeFileExtensionSet (
+  IN MISC_FILE_EXTENSION_SET  *Set
+  )
+{
+  ASSERT (Set != NULL);
+
+  FreePool ((VOID *)Set);
+}
+
+// MiscLookupFileExtension
+/** Classifies a file name by its extension.
+
+  @param[in] Set       The extension set to look the extension up in.
+  @param[in] FileName  The file name to classify.
+
+  @return  Returned is the Type of the matching extension or
+           MISC_FILE_EXTENSION_NOT_FOUND.
+**/
+UINTN
+MiscLookupFileExtension (
+  IN CONST MISC_FILE_EXTENSION_SET  *Set,
+  IN CHAR16                         *FileName
+  )
+{
+  UINTN                     Type;
+
+  MISC_FILE_PATH_COMPONENTS Components;
+  CONST CHAR16              *Extension;
+  UINTN                     Low;
+  UINTN                     High;
+  UINTN                     Middle;
+  INTN                      Result;
+
+  ASSERT (Set != NULL);
+  ASSERT (FileName != NULL);
+  ASSERT (FileName[0] != L'\0');
+
+  Type = MISC_FILE_EXTENSION_NOT_FOUND;
+
+  MiscSplitFilePath (FileName, StrLen (FileName), &Components);
+
+  Extension = (Set->PrimaryExtension
+                ? Components.LastExtension
+                : Components.Extensions);
+
+  if (Extension != NULL) {
+    Low  = 0;
+    High = Set->NumberOfEntries;
+
+    while (Low < High) {
+      Middle = (Low + ((High - Low) / 2));
+      Result = InternalCompareFoldedExtension (
+                 Extension,
+                 Set->Entries[Middle].Extension
+                 );
+
+      if (Result == 0) {
+        Type = Set->Entries[Middle].Type;
+        break;
+      }
+
+      if (Result < 0) {
+        High = Middle;
+      } else {
+        Low = (Middle + 1);
+      }
+    }
+  }
+
+  return Type;
+}
+
+// MiscFreeFileScanEntries
+/** Frees the entries returned by MiscScanDirectoryByExtensionSet().
+
+  @param[in] NumberOfEntries  The number of elements in Entries.
+  @param[in] Entries          The entries to free.
+**/
+VOID
+MiscFreeFileScanEntries (
+  IN UINTN                 NumberOfEntries,
+  IN MISC_FILE_SCAN_ENTRY  *Entries
+  )
+{
+  UINTN Index;
+
+  ASSERT ((NumberOfEntries == 0) || (Entries != NULL));
+
+  for (Index = 0; Index < NumberOfEntries; ++Index) {
+    FreePool ((VOID *)Entries[Index].FileInfo);
+  }
+
+  if (Entries != NULL) {
+    FreePool ((VOID *)Entries);
+  }
+}
+
+// MiscScanDirectoryByExtensionSet
+/** Classifies all entries of a directory in a single pass.
+
+  @param[in]  DirHandle        The directory to scan.
+  @param[in]  Set              The extensions to match.
+  @param[out] NumberOfEntries  The number of matching entries.
+  @param[out] Entries          The matching entries in directory order.  Free
+                               with MiscFreeFileScanEntries().
+
+  @retval EFI_SUCCESS           The directory has been scanned.
+  @retval EFI_NOT_FOUND         No entry matched.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+**/
+EFI_STATUS
+MiscScanDirectoryByExtensionSet (
+  IN  EFI_FILE_HANDLE                DirHandle,
+  IN  CONST MISC_FILE_EXTENSION_SET  *Set,
+  OUT UINTN                          *NumberOfEntries,
+  OUT MISC_FILE_SCAN_ENTRY           **Entries
+  )
+{
+  EFI_STATUS           Status;
+
+  EFI_FILE_INFO        *FileInfo;
+  BOOLEAN              NoFile;
+  UINTN                Type;
+  UINTN                Count;
+  UINTN                Capacity;
+  MISC_FILE_SCAN_ENTRY *Buffer;
+  MISC_FILE_SCAN_ENTRY *NewBuffer;
+  EFI_FILE_INFO        *EntryInfo;
+
+  ASSERT (DirHandle != NULL);
+  ASSERT (Set != NULL);
+  ASSERT (NumberOfEntries != NULL);
+  ASSERT (Entries != NULL);
+  ASSERT (!EfiAtRuntime ());
+
+  Count    = 0;
+  Capacity = 0;
+  Buffer   = NULL;
+  FileInfo = NULL;
+  NoFile   = FALSE;
+
+  Status = FileHandleFindFirstFile (DirHandle, &FileInfo);
+
+  while (!EFI_ERROR (Status) && !NoFile) {
+    Type = MiscLookupFileExtension (Set, FileInfo->FileName);
+
+    if (Type != MISC_FILE_EXTENSION_NOT_FOUND) {
+      if (Count == Capacity) {
+        Capacity  = ((Capacity == 0)
+                      ? MISC_FILE_SCAN_INITIAL_ENTRIES
+                      : (Capacity * 2));
+
+        NewBuffer = ReallocatePool (
+                      (Count * sizeof (*Buffer)),
+                      (Capacity * sizeof (*Buffer)),
+                      (VOID *)Buffer
+                      );
+
+        if (NewBuffer == NULL) {
+          Status = EFI_OUT_OF_RESOURCES;
+          break;
+        }
+
+        Buffer = NewBuffer;
+      }
+
+      EntryInfo = AllocateCopyPool ((UINTN)FileInfo->Size, (VOID *)FileInfo);
+
+      if (EntryInfo == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+        break;
+      }
+
+      Buffer[Count].Type     = Type;
+      Buffer[Count].FileInfo = EntryInfo;
+      ++Count;
+    }
+
+    Status = FileHandleFindNextFile (DirHandle, FileInfo, &NoFile);
+
+    // FileHandleFindNextFile() frees the buffer once the end is reached.
+    if (NoFile) {
+      FileInfo = NULL;
+    }
+  }
+
+  if (FileInfo != NULL) {
+    FreePool ((VOID *)FileInfo);
+  }
+
+  if (!EFI_ERROR (Status) || (Status == EFI_NOT_FOUND)) {
+    Status = ((Count > 0) ? EFI_SUCCESS : EFI_NOT_FOUND);
+  }
+
+  if (EFI_ERROR (Status)) {
+    MiscFreeFileScanEntries (Count, Buffer);
+
+    Count  = 0;
+    Buffer = NULL;
+  }
+
+  *NumberOfEntries = Count;
+  *Entries         = Buffer;
+
+  return Status;
+}
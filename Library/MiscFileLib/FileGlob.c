@@ -0,0 +1,897 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Guid/FileInfo.h>
+
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscFileLib.h>
+#include <Library/MiscRuntimeLib.h>
+
+#include "MiscFileLibInternal.h"
+
+// MISC_FILE_GLOB_MAX_COMPONENTS
+/// The component states are tracked in a UINT64 with the accepting state
+/// taking the last bit.
+#define MISC_FILE_GLOB_MAX_COMPONENTS  63
+
+// MISC_FILE_GLOB_TOKEN_TYPE
+enum {
+  MiscFileGlobTokenChar,          ///< Matches Char.
+  MiscFileGlobTokenAnyChar,       ///< '?'
+  MiscFileGlobTokenAnyString,     ///< '*'
+  MiscFileGlobTokenClass,         ///< '[...]'
+  MiscFileGlobTokenNegatedClass   ///< '[!...]' or '[^...]'
+};
+
+// MISC_FILE_GLOB_TOKEN
+typedef struct {
+  UINT8        Type;
+  CHAR16       Char;
+  UINTN        NumberOfRanges;
+  CONST CHAR16 *Ranges;  ///< Pairs of inclusive, upper-cased bounds.
+} MISC_FILE_GLOB_TOKEN;
+
+// MISC_FILE_GLOB_COMPONENT
+typedef struct {
+  BOOLEAN              AnyDepth;   ///< '**', matches zero or more levels.
+  BOOLEAN              IsLiteral;  ///< Consists of MiscFileGlobTokenChar only.
+  UINTN                NumberOfTokens;
+  MISC_FILE_GLOB_TOKEN *Tokens;
+} MISC_FILE_GLOB_COMPONENT;
+
+// MISC_FILE_GLOB
+struct MISC_FILE_GLOB {
+  CHAR16                   *Prefix;                  ///< Literal leading path.
+  MISC_FILE_GLOB_COMPONENT *PrefixComponents;
+  UINTN                    NumberOfPrefixComponents;
+  UINTN                    NumberOfComponents;       ///< Excluding the prefix.
+  MISC_FILE_GLOB_COMPONENT *Components;
+  BOOLEAN                  HasAnyDepth;
+};
+
+// MISC_FILE_GLOB_WALK_CONTEXT
+typedef struct {
+  CONST MISC_FILE_GLOB *Glob;
+  MISC_FILE_WALK_VISIT Visit;
+  VOID                 *Context;
+  UINT64               *States;      ///< The state of every open directory.
+  UINTN                StatesSize;
+  CHAR16               *Path;        ///< The prefix followed by the path.
+  UINTN                PathSize;
+  EFI_STATUS           Status;       ///< An error the callbacks ran into.
+} MISC_FILE_GLOB_WALK_CONTEXT;
+
+// InternalGlobMatchToken
+STATIC
+BOOLEAN
+InternalGlobMatchToken (
+  IN CONST MISC_FILE_GLOB_TOKEN  *Token,
+  IN CHAR16                      Char
+  )
+{
+  BOOLEAN Match;
+
+  UINTN   Index;
+
+  ASSERT (Token != NULL);
+
+  Char = MISC_FILE_CHAR_TO_UPPER (Char);
+
+  switch (Token->Type) {
+    case MiscFileGlobTokenChar:
+    {
+      Match = (BOOLEAN)(Token->Char == Char);
+      break;
+    }
+
+    case MiscFileGlobTokenAnyChar:
+    {
+      Match = TRUE;
+      break;
+    }
+
+    default:
+    {
+      ASSERT ((Token->Type == MiscFileGlobTokenClass)
+           || (Token->Type == MiscFileGlobTokenNegatedClass));
+
+      Match = FALSE;
+
+      for (Index = 0; Index < Token->NumberOfRanges; ++Index) {
+        if ((Char >= Token->Ranges[(Index * 2)])
+         && (Char <= Token->Ranges[(Index * 2) + 1])) {
+          Match = TRUE;
+          break;
+        }
+      }
+
+      if (Token->Type == MiscFileGlobTokenNegatedClass) {
+        Match = (BOOLEAN)!Match;
+      }
+
+      break;
+    }
+  }
+
+  return Match;
+}
+
+// InternalGlobMatchComponent
+/** Matches a single path component against a compiled component.
+
+  '*' only ever needs to resume at its last occurence, hence matching is
+  linear in the common case and never needs recursion.
+**/
+STATIC
+BOOLEAN
+InternalGlobMatchComponent (
+  IN CONST MISC_FILE_GLOB_COMPONENT  *Component,
+  IN CONST CHAR16                    *Name,
+  IN UINTN                           NameLength
+  )
+{
+  UINTN   TokenIndex;
+  UINTN   NameIndex;
+  UINTN   StarTokenIndex;
+  UINTN   StarNameIndex;
+
+  CONST MISC_FILE_GLOB_TOKEN *Tokens;
+
+  ASSERT (Component != NULL);
+  ASSERT (!Component->AnyDepth);
+  ASSERT (Name != NULL);
+
+  Tokens         = Component->Tokens;
+  TokenIndex     = 0;
+  NameIndex      = 0;
+  StarTokenIndex = MAX_UINTN;
+  StarNameIndex  = 0;
+
+  while (NameIndex < NameLength) {
+    if ((TokenIndex < Component->NumberOfTokens)
+     && (Tokens[TokenIndex].Type == MiscFileGlobTokenAnyString)) {
+      StarTokenIndex = TokenIndex;
+      StarNameIndex  = NameIndex;
+      ++TokenIndex;
+    } else if ((TokenIndex < Component->NumberOfTokens)
+            && InternalGlobMatchToken (&Tokens[TokenIndex], Name[NameIndex])) {
+      ++TokenIndex;
+      ++NameIndex;
+    } else if (StarTokenIndex != MAX_UINTN) {
+      ++StarNameIndex;
+
+      TokenIndex = (StarTokenIndex + 1);
+      NameIndex  = StarNameIndex;
+    } else {
+      return FALSE;
+    }
+  }
+
+  while ((TokenIndex < Component->NumberOfTokens)
+      && (Tokens[TokenIndex].Type == MiscFileGlobTokenAnyString)) {
+    ++TokenIndex;
+  }
+
+  return (BOOLEAN)(TokenIndex == Component->NumberOfTokens);
+}
+
+// InternalGlobClosure
+/** Adds the states reachable by letting '**' match zero levels.
+**/
+STATIC
+UINT64
+InternalGlobClosure (
+  IN CONST MISC_FILE_GLOB  *Glob,
+  IN UINT64                States
+  )
+{
+  UINTN Index;
+
+  ASSERT (Glob != NULL);
+
+  for (Index = 0; Index < Glob->NumberOfComponents; ++Index) {
+    if (((States & LShiftU64 (1, Index)) != 0)
+     && Glob->Components[Index].AnyDepth) {
+      States |= LShiftU64 (1, Index + 1);
+    }
+  }
+
+  return States;
+}
+
+// InternalGlobStep
+/** Advances the component automaton by one path component.
+**/
+STATIC
+UINT64
+InternalGlobStep (
+  IN CONST MISC_FILE_GLOB  *Glob,
+  IN UINT64                States,
+  IN CONST CHAR16          *Name,
+  IN UINTN                 NameLength
+  )
+{
+  UINT64                         NextStates;
+
+  UINTN                          Index;
+  CONST MISC_FILE_GLOB_COMPONENT *Component;
+
+  ASSERT (Glob != NULL);
+  ASSERT (Name != NULL);
+
+  NextStates = 0;
+
+  for (Index = 0; Index < Glob->NumberOfComponents; ++Index) {
+    if ((States & LShiftU64 (1, Index)) != 0) {
+      Component = &Glob->Components[Index];
+
+      if (Component->AnyDepth) {
+        NextStates |= LShiftU64 (1, Index);
+      } else if (InternalGlobMatchComponent (Component, Name, NameLength)) {
+        NextStates |= LShiftU64 (1, Index + 1);
+      }
+    }
+  }
+
+  return InternalGlobClosure (Glob, NextStates);
+}
+
+// InternalGlobInitialStates
+STATIC
+UINT64
+InternalGlobInitialStates (
+  IN CONST MISC_FILE_GLOB  *Glob
+  )
+{
+  return InternalGlobClosure (Glob, 1);
+}
+
+// InternalGlobAccepts
+STATIC
+BOOLEAN
+InternalGlobAccepts (
+  IN CONST MISC_FILE_GLOB  *Glob,
+  IN UINT64                States
+  )
+{
+  return (BOOLEAN)((States & LShiftU64 (1, Glob->NumberOfComponents)) != 0);
+}
+
+// InternalGlobCanDescend
+/** Returns whether any path below the current one can still match.
+**/
+STATIC
+BOOLEAN
+InternalGlobCanDescend (
+  IN CONST MISC_FILE_GLOB  *Glob,
+  IN UINT64                States
+  )
+{
+  return (BOOLEAN)(
+           (States & (LShiftU64 (1, Glob->NumberOfComponents) - 1)) != 0
+           );
+}
+
+// InternalGlobCompileComponent
+/** Compiles a single path component into tokens.
+
+  @retval EFI_SUCCESS            The component has been compiled.
+  @retval EFI_INVALID_PARAMETER  A character class is not terminated.
+**/
+STATIC
+EFI_STATUS
+InternalGlobCompileComponent (
+  IN     CONST CHAR16              *Pattern,
+  IN     UINTN                     Length,
+  OUT    MISC_FILE_GLOB_COMPONENT  *Component,
+  IN OUT MISC_FILE_GLOB_TOKEN      **Tokens,
+  IN OUT CHAR16                    **Ranges
+  )
+{
+  UINTN                Index;
+  MISC_FILE_GLOB_TOKEN *Token;
+  CHAR16               Low;
+  CHAR16               High;
+
+  ASSERT (Pattern != NULL);
+  ASSERT (Length > 0);
+  ASSERT (Component != NULL);
+  ASSERT (Tokens != NULL);
+  ASSERT (Ranges != NULL);
+
+  Component->AnyDepth       = (BOOLEAN)((Length == 2)
+                                     && (Pattern[0] == L'*')
+                                     && (Pattern[1] == L'*'));
+  Component->IsLiteral      = TRUE;
+  Component->NumberOfTokens = 0;
+  Component->Tokens         = *Tokens;
+
+  if (Component->AnyDepth) {
+    Component->IsLiteral = FALSE;
+
+    return EFI_SUCCESS;
+  }
+
+  for (Index = 0; Index < Length; ++Index) {
+    Token = &Component->Tokens[Component->NumberOfTokens];
+
+    if (Pattern[Index] == L'*') {
+      // Consecutive stars are equivalent to a single one.
+      if ((Component->NumberOfTokens > 0)
+       && (Token[-1].Type == MiscFileGlobTokenAnyString)) {
+        continue;
+      }
+
+      Token->Type = MiscFileGlobTokenAnyString;
+    } else if (Pattern[Index] == L'?') {
+      Token->Type = MiscFileGlobTokenAnyChar;
+    } else if (Pattern[Index] == L'[') {
+      ++Index;
+
+      Token->Type           = MiscFileGlobTokenClass;
+      Token->NumberOfRanges = 0;
+      Token->Ranges         = *Ranges;
+
+      if ((Index < Length)
+       && ((Pattern[Index] == L'!') || (Pattern[Index] == L'^'))) {
+        Token->Type = MiscFileGlobTokenNegatedClass;
+        ++Index;
+      }
+
+      // A leading ']' is part of the class.
+      do {
+        if (Index >= Length) {
+          return EFI_INVALID_PARAMETER;
+        }
+
+        Low  = MISC_FILE_CHAR_TO_UPPER (Pattern[Index]);
+        High = Low;
+
+        if (((Index + 2) < Length)
+         && (Pattern[Index + 1] == L'-')
+         && (Pattern[Index + 2] != L']')) {
+          High   = MISC_FILE_CHAR_TO_UPPER (Pattern[Index + 2]);
+          Index += 2;
+        }
+
+        (*Ranges)[0] = MIN (Low, High);
+        (*Ranges)[1] = MAX (Low, High);
+
+        *Ranges += 2;
+        ++Token->NumberOfRanges;
+        ++Index;
+      } while ((Index >= Length) || (Pattern[Index] != L']'));
+    } else {
+      Token->Type = MiscFileGlobTokenChar;
+      Token->Char = MISC_FILE_CHAR_TO_UPPER (Pattern[Index]);
+    }
+
+    if (Token->Type != MiscFileGlobTokenChar) {
+      Component->IsLiteral = FALSE;
+    }
+
+    ++Component->NumberOfTokens;
+  }
+
+  *Tokens += Component->NumberOfTokens;
+
+  return EFI_SUCCESS;
+}
+
+// MiscCompileFileGlob
+/** Compiles a glob pattern for matching paths.
+
+  Path components are separated by FILE_PATH_SEPARATOR.  Within a component,
+  '*' matches any string, '?' matches any character and '[...]' matches any of
+  the listed characters or ranges, where a leading '!' or '^' negates the
+  class.  A component consisting of '**' matches zero or more directory
+  levels.  Matching is case-insensitive.  Leading components without
+  wildcards form a literal prefix that is opened directly when enumerating.
+
+  @param[in]  Pattern  The pattern to compile.
+  @param[out] Glob     The compiled pattern.  Free with MiscFreeFileGlob().
+
+  @retval EFI_SUCCESS            The pattern has been compiled.
+  @retval EFI_INVALID_PARAMETER  The pattern is malformed.
+  @retval EFI_UNSUPPORTED        The pattern has too many components.
+  @retval EFI_OUT_OF_RESOURCES   Memory allocation failed.
+**/
+EFI_STATUS
+MiscCompileFileGlob (
+  IN  CONST CHAR16    *Pattern,
+  OUT MISC_FILE_GLOB  **Glob
+  )
+{
+  EFI_STATUS               Status;
+
+  MISC_FILE_GLOB           *NewGlob;
+  UINTN                    PatternLength;
+  MISC_FILE_GLOB_COMPONENT *Components;
+  MISC_FILE_GLOB_TOKEN     *Tokens;
+  CHAR16                   *Ranges;
+  UINTN                    NumberOfComponents;
+  UINTN                    Index;
+  UINTN                    Start;
+  UINTN                    Count;
+  UINTN                    PrefixLength;
+  CHAR16                   *Prefix;
+
+  ASSERT (Pattern != NULL);
+  ASSERT (Glob != NULL);
+
+  PatternLength = StrLen (Pattern);
+
+  // Every character can at most yield one component, one token and one range.
+  NewGlob = AllocatePool (
+              sizeof (*NewGlob)
+                + (PatternLength * sizeof (*Components))
+                + (PatternLength * sizeof (*Tokens))
+                + (PatternLength * 2 * sizeof (*Ranges))
+                + ((PatternLength + 1) * sizeof (*Prefix))
+              );
+
+  if (NewGlob == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Components = (MISC_FILE_GLOB_COMPONENT *)(NewGlob + 1);
+  Tokens     = (MISC_FILE_GLOB_TOKEN *)&Components[PatternLength];
+  Ranges     = (CHAR16 *)&Tokens[PatternLength];
+  Prefix     = &Ranges[PatternLength * 2];
+
+  Status             = EFI_SUCCESS;
+  NumberOfComponents = 0;
+  Start              = 0;
+
+  for (Index = 0; Index <= PatternLength; ++Index) {
+    if ((Index == PatternLength) || (Pattern[Index] == FILE_PATH_SEPARATOR)) {
+      // Skip empty components caused by leading or repeated separators.
+      if (Index > Start) {
+        Status = InternalGlobCompileComponent (
+                   &Pattern[Start],
+                   (Index - Start),
+                   &Components[NumberOfComponents],
+                   &Tokens,
+                   &Ranges
+                   );
+
+        if (EFI_ERROR (Status)) {
+          break;
+        }
+
+        ++NumberOfComponents;
+      }
+
+      Start = (Index + 1);
+    }
+  }
+
+  if (!EFI_ERROR (Status) && (NumberOfComponents == 0)) {
+    Status = EFI_INVALID_PARAMETER;
+  }
+
+  if (EFI_ERROR (Status)) {
+    FreePool ((VOID *)NewGlob);
+
+    return Status;
+  }
+
+  // The last component is always matched by enumeration so that a match is
+  // reported with its EFI_FILE_INFO.
+
+  NewGlob->NumberOfPrefixComponents = 0;
+
+  while ((NewGlob->NumberOfPrefixComponents < (NumberOfComponents - 1))
+      && Components[NewGlob->NumberOfPrefixComponents].IsLiteral) {
+    ++NewGlob->NumberOfPrefixComponents;
+  }
+
+  // Copy the prefix from the pattern to preserve its case for opening.
+
+  PrefixLength = 0;
+  Count        = 0;
+  Start        = 0;
+
+  for (Index = 0; Count < NewGlob->NumberOfPrefixComponents; ++Index) {
+    if (Pattern[Index] == FILE_PATH_SEPARATOR) {
+      if (Index > Start) {
+        ++Count;
+      }
+
+      Start = (Index + 1);
+    } else {
+      if ((Index == Start) && (PrefixLength > 0)) {
+        Prefix[PrefixLength] = FILE_PATH_SEPARATOR;
+        ++PrefixLength;
+      }
+
+      Prefix[PrefixLength] = Pattern[Index];
+      ++PrefixLength;
+    }
+  }
+
+  Prefix[PrefixLength] = L'\0';
+
+  NewGlob->Prefix             = Prefix;
+  NewGlob->PrefixComponents   = Components;
+  NewGlob->Components         = &Components[NewGlob->NumberOfPrefixComponents];
+  NewGlob->NumberOfComponents = (NumberOfComponents - NewGlob->NumberOfPrefixComponents);
+  NewGlob->HasAnyDepth        = FALSE;
+
+  for (Index = 0; Index < NewGlob->NumberOfComponents; ++Index) {
+    if (NewGlob->Components[Index].AnyDepth) {
+      NewGlob->HasAnyDepth = TRUE;
+    }
+  }
+
+  if (NewGlob->NumberOfComponents > MISC_FILE_GLOB_MAX_COMPONENTS) {
+    FreePool ((VOID *)NewGlob);
+
+    return EFI_UNSUPPORTED;
+  }
+
+  *Glob = NewGlob;
+
+  return EFI_SUCCESS;
+}
+
+// MiscFreeFileGlob
+/** Frees a pattern returned by MiscCompileFileGlob().
+
+  @param[in] Glob  The pattern to free.
+**/
+VOID
+MiscFreeFileGlob (
+  IN MISC_FILE_GLOB  *Glob
+  )
+{
+  ASSERT (Glob != NULL);
+
+  FreePool ((VOID *)Glob);
+}
+
+// MiscMatchFileGlob
+/** Matches a path against a compiled pattern.
+
+  @param[in] Glob  The compiled pattern.
+  @param[in] Path  The path to match.  A leading FILE_PATH_SEPARATOR is
+                   optional.
+
+  @return  Returned is whether Path matches Glob.
+**/
+BOOLEAN
+MiscMatchFileGlob (
+  IN CONST MISC_FILE_GLOB  *Glob,
+  IN CONST CHAR16          *Path
+  )
+{
+  UINTN   Index;
+  UINTN   Start;
+  UINTN   PrefixIndex;
+  UINT64  States;
+  BOOLEAN Match;
+
+  ASSERT (Glob != NULL);
+  ASSERT (Path != NULL);
+
+  States      = InternalGlobInitialStates (Glob);
+  PrefixIndex = 0;
+  Start       = 0;
+
+  for (Index = 0; States != 0; ++Index) {
+    if ((Path[Index] == L'\0') || (Path[Index] == FILE_PATH_SEPARATOR)) {
+      if (Index > Start) {
+        if (PrefixIndex < Glob->NumberOfPrefixComponents) {
+          Match = InternalGlobMatchComponent (
+                    &Glob->PrefixComponents[PrefixIndex],
+                    &Path[Start],
+                    (Index - Start)
+                    );
+
+          if (!Match) {
+            return FALSE;
+          }
+
+          ++PrefixIndex;
+        } else {
+          States = InternalGlobStep (
+                     Glob,
+                     States,
+                     &Path[Start],
+                     (Index - Start)
+                     );
+        }
+      }
+
+      if (Path[Index] == L'\0') {
+        break;
+      }
+
+      Start = (Index + 1);
+    }
+  }
+
+  return (BOOLEAN)((PrefixIndex == Glob->NumberOfPrefixComponents)
+                && InternalGlobAccepts (Glob, States));
+}
+
+// InternalGlobParentStates
+STATIC
+UINT64
+InternalGlobParentStates (
+  IN MISC_FILE_GLOB_WALK_CONTEXT  *Context,
+  IN UINTN                        Depth
+  )
+{
+  ASSERT (Context != NULL);
+
+  return ((Depth == 0)
+           ? InternalGlobInitialStates (Context->Glob)
+           : Context->States[Depth - 1]);
+}
+
+// InternalGlobWalkFilter
+STATIC
+BOOLEAN
+EFIAPI
+InternalGlobWalkFilter (
+  IN VOID                 *Context,
+  IN CONST CHAR16         *Path,
+  IN CONST EFI_FILE_INFO  *FileInfo,
+  IN UINTN                Depth
+  )
+{
+  MISC_FILE_GLOB_WALK_CONTEXT *GlobContext;
+  UINT64                      States;
+
+  ASSERT (Context != NULL);
+  ASSERT (FileInfo != NULL);
+
+  GlobContext = (MISC_FILE_GLOB_WALK_CONTEXT *)Context;
+
+  if (EFI_ERROR (GlobContext->Status)) {
+    return FALSE;
+  }
+
+  States = InternalGlobStep (
+             GlobContext->Glob,
+             InternalGlobParentStates (GlobContext, Depth),
+             FileInfo->FileName,
+             StrLen (FileInfo->FileName)
+             );
+
+  return InternalGlobAccepts (GlobContext->Glob, States);
+}
+
+// InternalGlobWalkPrune
+/** Prunes every directory that no descendant can match in.
+
+  The walk descends into a directory right after this has been called for it,
+  hence the directory's states are stored for its children.  If they cannot
+  be stored, the error is recorded in the context and everything else is
+  pruned and filtered out, so the walk ends without further matches.
+**/
+STATIC
+BOOLEAN
+EFIAPI
+InternalGlobWalkPrune (
+  IN VOID                 *Context,
+  IN CONST CHAR16         *Path,
+  IN CONST EFI_FILE_INFO  *FileInfo,
+  IN UINTN                Depth
+  )
+{
+  MISC_FILE_GLOB_WALK_CONTEXT *GlobContext;
+  UINT64                      States;
+  EFI_STATUS                  Status;
+
+  ASSERT (Context != NULL);
+  ASSERT (FileInfo != NULL);
+
+  GlobContext = (MISC_FILE_GLOB_WALK_CONTEXT *)Context;
+
+  if (EFI_ERROR (GlobContext->Status)) {
+    return TRUE;
+  }
+
+  States = InternalGlobStep (
+             GlobContext->Glob,
+             InternalGlobParentStates (GlobContext, Depth),
+             FileInfo->FileName,
+             StrLen (FileInfo->FileName)
+             );
+
+  if (!InternalGlobCanDescend (GlobContext->Glob, States)) {
+    return TRUE;
+  }
+
+  Status = InternalGrowBuffer (
+             (VOID **)&GlobContext->States,
+             &GlobContext->StatesSize,
+             ((Depth + 1) * sizeof (*GlobContext->States))
+             );
+
+  if (EFI_ERROR (Status)) {
+    GlobContext->Status = Status;
+    return TRUE;
+  }
+
+  GlobContext->States[Depth] = States;
+
+  return FALSE;
+}
+
+// InternalGlobWalkVisit
+STATIC
+EFI_STATUS
+EFIAPI
+InternalGlobWalkVisit (
+  IN VOID                 *Context,
+  IN CONST CHAR16         *Path,
+  IN CONST EFI_FILE_INFO  *FileInfo,
+  IN UINTN                Depth
+  )
+{
+  EFI_STATUS                  Status;
+
+  MISC_FILE_GLOB_WALK_CONTEXT *GlobContext;
+  UINTN                       PrefixLength;
+  UINTN                       PathSize;
+
+  ASSERT (Context != NULL);
+  ASSERT (Path != NULL);
+
+  GlobContext  = (MISC_FILE_GLOB_WALK_CONTEXT *)Context;
+  PrefixLength = StrLen (GlobContext->Glob->Prefix);
+
+  if (PrefixLength == 0) {
+    return GlobContext->Visit (GlobContext->Context, Path, FileInfo, Depth);
+  }
+
+  PathSize = StrSize (Path);
+  Status   = InternalGrowBuffer (
+               (VOID **)&GlobContext->Path,
+               &GlobContext->PathSize,
+               (((PrefixLength + 1) * sizeof (*Path)) + PathSize)
+               );
+
+  if (!EFI_ERROR (Status)) {
+    CopyMem (
+      (VOID *)GlobContext->Path,
+      (VOID *)GlobContext->Glob->Prefix,
+      (PrefixLength * sizeof (*Path))
+      );
+
+    GlobContext->Path[PrefixLength] = FILE_PATH_SEPARATOR;
+
+    CopyMem (
+      (VOID *)&GlobContext->Path[PrefixLength + 1],
+      (VOID *)Path,
+      PathSize
+      );
+
+    Status = GlobContext->Visit (
+                           GlobContext->Context,
+                           GlobContext->Path,
+                           FileInfo,
+                           (GlobContext->Glob->NumberOfPrefixComponents + Depth)
+                           );
+  }
+
+  return Status;
+}
+
+// MiscFindFilesByGlob
+/** Visits all paths below Root that match a compiled pattern.
+
+  The literal prefix of the pattern is opened directly, below it only
+  directories that can still contain a match are descended into.  Visit is
+  called with the path relative to Root, as described for
+  MiscWalkDirectory().
+
+  @param[in] Root     The directory to match the pattern against.
+  @param[in] Glob     The compiled pattern.
+  @param[in] Visit    Called for every matching entry.
+  @param[in] Context  Passed to Visit.
+
+  @retval EFI_SUCCESS           All matches have been visited.
+  @retval EFI_NOT_FOUND         The literal prefix does not exist.
+  @retval EFI_OUT_OF_RESOURCES  The walk state could not be allocated, the
+                                matches visited before are incomplete.
+  @retval other                 An error returned by the file system or by
+                                Visit.
+**/
+EFI_STATUS
+MiscFindFilesByGlob (
+  IN EFI_FILE_HANDLE       Root,
+  IN CONST MISC_FILE_GLOB  *Glob,
+  IN MISC_FILE_WALK_VISIT  Visit,
+  IN VOID                  *Context
+  )
+{
+  EFI_STATUS                  Status;
+
+  EFI_FILE_HANDLE             DirHandle;
+  MISC_FILE_GLOB_WALK_CONTEXT GlobContext;
+  MISC_FILE_WALK_OPTIONS      Options;
+
+  ASSERT (Root != NULL);
+  ASSERT (Glob != NULL);
+  ASSERT (Visit != NULL);
+  ASSERT (!EfiAtRuntime ());
+
+  DirHandle = Root;
+
+  if (Glob->Prefix[0] != L'\0') {
+    Status = Root->Open (
+                     Root,
+                     &DirHandle,
+                     Glob->Prefix,
+                     EFI_FILE_MODE_READ,
+                     0
+                     );
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  GlobContext.Glob       = Glob;
+  GlobContext.Visit      = Visit;
+  GlobContext.Context    = Context;
+  GlobContext.States     = NULL;
+  GlobContext.StatesSize = 0;
+  GlobContext.Path       = NULL;
+  GlobContext.PathSize   = 0;
+  GlobContext.Status     = EFI_SUCCESS;
+
+  Options.Order    = MiscFileWalkDirectoryOrder;
+  Options.MaxDepth = (Glob->HasAnyDepth
+                       ? MISC_FILE_WALK_UNLIMITED_DEPTH
+                       : (Glob->NumberOfComponents - 1));
+
+  Options.Filter  = InternalGlobWalkFilter;
+  Options.Prune   = InternalGlobWalkPrune;
+  Options.Visit   = InternalGlobWalkVisit;
+  Options.Context = (VOID *)&GlobContext;
+
+  Status = MiscWalkDirectory (DirHandle, &Options);
+
+  if (!EFI_ERROR (Status)) {
+    Status = GlobContext.Status;
+  }
+
+  if (GlobContext.States != NULL) {
+    FreePool ((VOID *)GlobContext.States);
+  }
+
+  if (GlobContext.Path != NULL) {
+    FreePool ((VOID *)GlobContext.Path);
+  }
+
+  if (DirHandle != Root) {
+    DirHandle->Close (DirHandle);
+  }
+
+  return Status;
+}
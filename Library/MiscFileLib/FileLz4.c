@@ -0,0 +1,493 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Guid/FileInfo.h>
+
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscFileLib.h>
+#include <Library/MiscRuntimeLib.h>
+
+#include "MiscFileLibInternal.h"
+
+// LZ4_FRAME_MAGIC
+#define LZ4_FRAME_MAGIC  0x184D2204U
+
+// LZ4_FRAME_VERSION
+#define LZ4_FRAME_VERSION  0x40U
+
+// LZ4_FLG_VERSION_MASK
+#define LZ4_FLG_VERSION_MASK  0xC0U
+
+// LZ4_FLG_BLOCK_CHECKSUM
+#define LZ4_FLG_BLOCK_CHECKSUM  BIT4
+
+// LZ4_FLG_CONTENT_SIZE
+#define LZ4_FLG_CONTENT_SIZE  BIT3
+
+// LZ4_FLG_CONTENT_CHECKSUM
+#define LZ4_FLG_CONTENT_CHECKSUM  BIT2
+
+// LZ4_FLG_DICTIONARY_ID
+#define LZ4_FLG_DICTIONARY_ID  BIT0
+
+// LZ4_BD_BLOCK_MAX_SIZE
+#define LZ4_BD_BLOCK_MAX_SIZE(BlockDescriptor)  \
+  (((BlockDescriptor) >> 4) & 0x07U)
+
+// LZ4_BLOCK_UNCOMPRESSED
+#define LZ4_BLOCK_UNCOMPRESSED  BIT31
+
+// LZ4_MIN_MATCH
+#define LZ4_MIN_MATCH  4
+
+// LZ4_LENGTH_MASK
+#define LZ4_LENGTH_MASK  0x0FU
+
+// InternalLz4ReadExact
+/** Reads exactly Size bytes from a file.
+
+  @retval EFI_SUCCESS            Size bytes have been read.
+  @retval EFI_VOLUME_CORRUPTED   The file ended prematurely.
+  @retval other                  The error returned by the file system.
+**/
+STATIC
+EFI_STATUS
+InternalLz4ReadExact (
+  IN  EFI_FILE_HANDLE  FileHandle,
+  IN  UINTN            Size,
+  OUT VOID             *Buffer
+  )
+{
+  EFI_STATUS Status;
+
+  UINTN      ReadSize;
+
+  ReadSize = Size;
+  Status   = MiscReadFileChunked (
+               FileHandle,
+               &ReadSize,
+               Buffer,
+               Size,
+               NULL,
+               NULL
+               );
+
+  if (!EFI_ERROR (Status) && (ReadSize != Size)) {
+    Status = EFI_VOLUME_CORRUPTED;
+  }
+
+  return Status;
+}
+
+// InternalLz4ReadLength
+/** Reads the extension of a literal or match length.
+
+  @param[in, out] Input     The current input position.
+  @param[in]      InputEnd  The end of the input.
+  @param[in, out] Length    The length to extend.
+
+  @return  Returned is whether the length could be read.
+**/
+STATIC
+BOOLEAN
+InternalLz4ReadLength (
+  IN OUT CONST UINT8  **Input,
+  IN     CONST UINT8  *InputEnd,
+  IN OUT UINTN        *Length
+  )
+{
+  UINT8 Byte;
+
+  if (*Length == LZ4_LENGTH_MASK) {
+    do {
+      if (*Input >= InputEnd) {
+        return FALSE;
+      }
+
+      Byte = **Input;
+      ++(*Input);
+
+      *Length += Byte;
+    } while (Byte == MAX_UINT8);
+  }
+
+  return TRUE;
+}
+
+// InternalLz4DecodeBlock
+/** Decodes an LZ4 block to the end of the already decoded data.
+
+  Matches may reach back into previous blocks, hence linked blocks are
+  decoded without keeping a separate dictionary.
+
+  @param[in]  Input        The compressed block.
+  @param[in]  InputSize    The size, in bytes, of Input.
+  @param[in]  OutputStart  The start of all decoded data.
+  @param[in]  OutputSize   The size, in bytes, of the data decoded so far.
+  @param[in]  OutputLimit  The size, in bytes, of the buffer at OutputStart.
+  @param[out] DecodedSize  The size, in bytes, of the decoded block.
+
+  @retval EFI_SUCCESS           The block has been decoded.
+  @retval EFI_VOLUME_CORRUPTED  The block is malformed or does not fit.
+**/
+STATIC
+EFI_STATUS
+InternalLz4DecodeBlock (
+  IN  CONST UINT8  *Input,
+  IN  UINTN        InputSize,
+  IN  UINT8        *OutputStart,
+  IN  UINTN        OutputSize,
+  IN  UINTN        OutputLimit,
+  OUT UINTN        *DecodedSize
+  )
+{
+  CONST UINT8 *InputEnd;
+  UINT8       *Output;
+  UINT8       *OutputEnd;
+  UINT8       Token;
+  UINTN       Length;
+  UINTN       Offset;
+  CONST UINT8 *Match;
+
+  InputEnd  = (Input + InputSize);
+  Output    = (OutputStart + OutputSize);
+  OutputEnd = (OutputStart + OutputLimit);
+
+  while (Input < InputEnd) {
+    Token = *Input;
+    ++Input;
+
+    Length = (Token >> 4);
+
+    if (!InternalLz4ReadLength (&Input, InputEnd, &Length)
+     || (Length > (UINTN)(InputEnd - Input))
+     || (Length > (UINTN)(OutputEnd - Output))) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    CopyMem ((VOID *)Output, (VOID *)Input, Length);
+
+    Input  += Length;
+    Output += Length;
+
+    // The last sequence of a block consists of literals only.
+    if (Input == InputEnd) {
+      break;
+    }
+
+    if ((UINTN)(InputEnd - Input) < sizeof (UINT16)) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    Offset = (Input[0] | ((UINTN)Input[1] << 8));
+    Input += sizeof (UINT16);
+
+    Length = (Token & LZ4_LENGTH_MASK);
+
+    if ((Offset == 0)
+     || (Offset > (UINTN)(Output - OutputStart))
+     || !InternalLz4ReadLength (&Input, InputEnd, &Length)) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    Length += LZ4_MIN_MATCH;
+
+    if (Length > (UINTN)(OutputEnd - Output)) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    Match = (Output - Offset);
+
+    // Matches may overlap their own output, copy byte-wise in that case.
+    if (Offset >= Length) {
+      CopyMem ((VOID *)Output, (VOID *)Match, Length);
+
+      Output += Length;
+    } else {
+      while (Length > 0) {
+        *Output = *Match;
+
+        ++Output;
+        ++Match;
+        --Length;
+      }
+    }
+  }
+
+  *DecodedSize = (UINTN)(Output - (OutputStart + OutputSize));
+
+  return EFI_SUCCESS;
+}
+
+// InternalLz4ReadFrameHeader
+/** Reads and validates an LZ4 frame header.
+
+  @param[in]  FileHandle    The file to read the header from.
+  @param[out] Flags         The frame's FLG byte.
+  @param[out] BlockMaxSize  The maximum size of a block.
+  @param[out] ContentSize   The decoded size if LZ4_FLG_CONTENT_SIZE is set.
+
+  @retval EFI_SUCCESS           The header has been read.
+  @retval EFI_UNSUPPORTED       The frame requires a dictionary.
+  @retval EFI_VOLUME_CORRUPTED  The header is malformed.
+  @retval EFI_OUT_OF_RESOURCES  The content does not fit into memory.
+**/
+STATIC
+EFI_STATUS
+InternalLz4ReadFrameHeader (
+  IN  EFI_FILE_HANDLE  FileHandle,
+  OUT UINT8            *Flags,
+  OUT UINTN            *BlockMaxSize,
+  OUT UINT64           *ContentSize
+  )
+{
+  EFI_STATUS Status;
+
+  UINT8      Header[sizeof (UINT32) + 2];
+  UINT8      Descriptor[sizeof (UINT64) + 1];
+  BOOLEAN    HasContentSize;
+
+  *ContentSize = 0;
+
+  // Magic, FLG and BD.
+  Status = InternalLz4ReadExact (FileHandle, sizeof (Header), Header);
+
+  if (!EFI_ERROR (Status)) {
+    *Flags = Header[4];
+    Status = EFI_VOLUME_CORRUPTED;
+
+    if ((ReadUnaligned32 ((UINT32 *)Header) == LZ4_FRAME_MAGIC)
+     && ((*Flags & LZ4_FLG_VERSION_MASK) == LZ4_FRAME_VERSION)
+     && (LZ4_BD_BLOCK_MAX_SIZE (Header[5]) >= 4)) {
+      // 64 KB, 256 KB, 1 MB or 4 MB.
+      *BlockMaxSize = (UINTN)LShiftU64 (
+                               1,
+                               (8 + (2 * LZ4_BD_BLOCK_MAX_SIZE (Header[5])))
+                               );
+      Status        = EFI_UNSUPPORTED;
+
+      if ((*Flags & LZ4_FLG_DICTIONARY_ID) == 0) {
+        HasContentSize = (BOOLEAN)((*Flags & LZ4_FLG_CONTENT_SIZE) != 0);
+
+        // Content size, if present, and the header checksum.
+        Status = InternalLz4ReadExact (
+                   FileHandle,
+                   ((HasContentSize ? sizeof (UINT64) : 0) + 1),
+                   Descriptor
+                   );
+
+        if (!EFI_ERROR (Status) && HasContentSize) {
+          *ContentSize = ReadUnaligned64 ((UINT64 *)Descriptor);
+
+          if (*ContentSize > MAX_UINTN) {
+            Status = EFI_OUT_OF_RESOURCES;
+          }
+        }
+      }
+    }
+  }
+
+  return Status;
+}
+
+// MiscLz4DecodeFile
+/** Decodes an LZ4 frame while it is being read.
+
+  The frame is read block by block into a single block buffer and every block
+  is decoded straight into the destination buffer, which is sized from the
+  frame's content size if present.  Peak memory usage hence is the decoded
+  size plus one block.  Checksums are skipped, the data is expected to be
+  verified by the caller.
+
+  @param[in]  FileHandle  The file to decode from its current position.
+  @param[out] BufferSize  The size, in bytes, of the decoded data.
+  @param[out] Buffer      The decoded data.  Free with FreePool().
+
+  @retval EFI_SUCCESS           The frame has been decoded.
+  @retval EFI_UNSUPPORTED       The frame requires a dictionary or its
+                                version is unknown.
+  @retval EFI_VOLUME_CORRUPTED  The frame is malformed.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval other                 The error returned by the file system.
+**/
+EFI_STATUS
+EFIAPI
+MiscLz4DecodeFile (
+  IN  EFI_FILE_HANDLE  FileHandle,
+  OUT UINTN            *BufferSize,
+  OUT VOID             **Buffer
+  )
+{
+  EFI_STATUS Status;
+
+  UINT8      Flags;
+  UINTN      BlockMaxSize;
+  UINT64     ContentSize;
+  BOOLEAN    HasContentSize;
+  UINT32     BlockHeader;
+  UINTN      BlockSize;
+  UINT8      *Block;
+  UINT8      *Output;
+  UINTN      OutputSize;
+  UINTN      OutputLimit;
+  UINTN      DecodedSize;
+  UINT32     Checksum;
+
+  ASSERT (FileHandle != NULL);
+  ASSERT (BufferSize != NULL);
+  ASSERT (Buffer != NULL);
+  ASSERT (!EfiAtRuntime ());
+
+  Block  = NULL;
+  Output = NULL;
+
+  Status = InternalLz4ReadFrameHeader (
+             FileHandle,
+             &Flags,
+             &BlockMaxSize,
+             &ContentSize
+             );
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  HasContentSize = (BOOLEAN)((Flags & LZ4_FLG_CONTENT_SIZE) != 0);
+
+  OutputSize  = 0;
+  OutputLimit = (HasContentSize ? (UINTN)ContentSize : BlockMaxSize);
+  Output      = AllocatePool (MAX (OutputLimit, 1));
+  Block       = AllocatePool (BlockMaxSize);
+
+  Status = EFI_OUT_OF_RESOURCES;
+
+  if ((Output != NULL) && (Block != NULL)) {
+    while (TRUE) {
+      Status = InternalLz4ReadExact (
+                 FileHandle,
+                 sizeof (BlockHeader),
+                 &BlockHeader
+                 );
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+
+      if (BlockHeader == 0) {
+        if ((Flags & LZ4_FLG_CONTENT_CHECKSUM) != 0) {
+          Status = InternalLz4ReadExact (
+                     FileHandle,
+                     sizeof (Checksum),
+                     &Checksum
+                     );
+        }
+
+        break;
+      }
+
+      BlockSize = (BlockHeader & ~LZ4_BLOCK_UNCOMPRESSED);
+
+      if (BlockSize > BlockMaxSize) {
+        Status = EFI_VOLUME_CORRUPTED;
+        break;
+      }
+
+      if (!HasContentSize) {
+        Status = InternalGrowBuffer (
+                   (VOID **)&Output,
+                   &OutputLimit,
+                   (OutputSize + BlockMaxSize)
+                   );
+
+        if (EFI_ERROR (Status)) {
+          break;
+        }
+      }
+
+      if ((BlockHeader & LZ4_BLOCK_UNCOMPRESSED) != 0) {
+        // Stored blocks are read straight into the destination.
+        Status = EFI_VOLUME_CORRUPTED;
+
+        if (BlockSize <= (OutputLimit - OutputSize)) {
+          Status = InternalLz4ReadExact (
+                     FileHandle,
+                     BlockSize,
+                     (VOID *)&Output[OutputSize]
+                     );
+        }
+
+        DecodedSize = BlockSize;
+      } else {
+        Status = InternalLz4ReadExact (FileHandle, BlockSize, Block);
+
+        if (!EFI_ERROR (Status)) {
+          Status = InternalLz4DecodeBlock (
+                     Block,
+                     BlockSize,
+                     Output,
+                     OutputSize,
+                     OutputLimit,
+                     &DecodedSize
+                     );
+        }
+      }
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+
+      OutputSize += DecodedSize;
+
+      if ((Flags & LZ4_FLG_BLOCK_CHECKSUM) != 0) {
+        Status = InternalLz4ReadExact (
+                   FileHandle,
+                   sizeof (Checksum),
+                   &Checksum
+                   );
+
+        if (EFI_ERROR (Status)) {
+          break;
+        }
+      }
+    }
+  }
+
+  if (!EFI_ERROR (Status)
+   && HasContentSize
+   && (OutputSize != OutputLimit)) {
+    Status = EFI_VOLUME_CORRUPTED;
+  }
+
+  if (Block != NULL) {
+    FreePool ((VOID *)Block);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    *BufferSize = OutputSize;
+    *Buffer     = (VOID *)Output;
+  } else if (Output != NULL) {
+    FreePool ((VOID *)Output);
+  }
+
+  return Status;
+}
@@ -0,0 +1,175 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Guid/FileInfo.h>
+
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/DebugLib.h>
+#include <Library/MiscFileLib.h>
+
+#include "MiscFileLibInternal.h"
+
+// gMiscFileAsciiUpperCaseMap
+/// Maps every ASCII character to its upper-case variant.
+GLOBAL_REMOVE_IF_UNREFERENCED
+CONST UINT8 gMiscFileAsciiUpperCaseMap[128] = {
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+  0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+  0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+  0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F,
+  0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
+  0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
+  0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
+  0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,
+  0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
+  0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,
+  0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57,
+  0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F,
+  0x60, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,  // 'a' - 'g'
+  0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,  // 'h' - 'o'
+  0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57,  // 'p' - 'w'
+  0x58, 0x59, 0x5A, 0x7B, 0x7C, 0x7D, 0x7E, 0x7F   // 'x' - 'z'
+};
+
+// MiscSplitFilePath
+/** Splits the last component of a path into its base name and extensions.
+
+  The path is scanned once, backwards from its end up to the last
+  FILE_PATH_SEPARATOR, hence long paths cost no more than their last
+  component.  The extensions of "Name.tar.gz" are "tar.gz", its last extension
+  is "gz".
+
+  @param[in]  Path        The path to split.
+  @param[in]  PathLength  The length, in characters, of Path.
+  @param[out] Components  The components of the last path component.  All
+                          pointers point into Path, extensions are NULL if the
+                          name does not contain a '.'.
+**/
+VOID
+MiscSplitFilePath (
+  IN  CONST CHAR16               *Path,
+  IN  UINTN                      PathLength,
+  OUT MISC_FILE_PATH_COMPONENTS  *Components
+  )
+{
+  UINTN  Index;
+  UINTN  FirstDot;
+  UINTN  LastDot;
+  CHAR16 Char;
+
+  ASSERT (Path != NULL);
+  ASSERT (Components != NULL);
+
+  FirstDot = MAX_UINTN;
+  LastDot  = MAX_UINTN;
+
+  for (Index = PathLength; Index > 0; --Index) {
+    Char = Path[Index - 1];
+
+    if (Char == FILE_PATH_SEPARATOR) {
+      break;
+    }
+
+    if (Char == L'.') {
+      if (LastDot == MAX_UINTN) {
+        LastDot = (Index - 1);
+      }
+
+      FirstDot = (Index - 1);
+    }
+  }
+
+  Components->Name       = &Path[Index];
+  Components->NameLength = (PathLength - Index);
+
+  if (FirstDot == MAX_UINTN) {
+    Components->BaseNameLength      = Components->NameLength;
+    Components->Extensions          = NULL;
+    Components->ExtensionsLength    = 0;
+    Components->LastExtension       = NULL;
+    Components->LastExtensionLength = 0;
+  } else {
+    Components->BaseNameLength      = (FirstDot - Index);
+    Components->Extensions          = &Path[FirstDot + 1];
+    Components->ExtensionsLength    = (PathLength - (FirstDot + 1));
+    Components->LastExtension       = &Path[LastDot + 1];
+    Components->LastExtensionLength = (PathLength - (LastDot + 1));
+  }
+}
+
+// MiscFileStrniCmp
+/** Compares two strings of a given length ignoring the case of ASCII
+    characters.
+
+  @param[in] FirstString   The first string to compare.
+  @param[in] SecondString  The second string to compare.
+  @param[in] Length        The maximum number of characters to compare.
+
+  @return  Returned is the difference of the first mismatching upper-cased
+           characters or 0.
+**/
+INTN
+MiscFileStrniCmp (
+  IN CONST CHAR16  *FirstString,
+  IN CONST CHAR16  *SecondString,
+  IN UINTN         Length
+  )
+{
+  CHAR16 FirstChar;
+  CHAR16 SecondChar;
+
+  ASSERT (FirstString != NULL);
+  ASSERT (SecondString != NULL);
+
+  FirstChar  = L'\0';
+  SecondChar = L'\0';
+
+  while (Length > 0) {
+    FirstChar  = MISC_FILE_CHAR_TO_UPPER (*FirstString);
+    SecondChar = MISC_FILE_CHAR_TO_UPPER (*SecondString);
+
+    if ((FirstChar != SecondChar) || (FirstChar == L'\0')) {
+      break;
+    }
+
+    ++FirstString;
+    ++SecondString;
+    --Length;
+  }
+
+  return ((INTN)FirstChar - (INTN)SecondChar);
+}
+
+// MiscFileStriCmp
+/** Compares two strings ignoring the case of ASCII characters.
+
+  @param[in] FirstString   The first string to compare.
+  @param[in] SecondString  The second string to compare.
+
+  @return  Returned is the difference of the first mismatching upper-cased
+           characters or 0.
+**/
+INTN
+MiscFileStriCmp (
+  IN CONST CHAR16  *FirstString,
+  IN CONST CHAR16  *SecondString
+  )
+{
+  return MiscFileStrniCmp (FirstString, SecondString, MAX_UINTN);
+}
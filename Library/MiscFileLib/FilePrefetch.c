@@ -0,0 +1,486 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <IndustryStandard/MiscFileTrace.h>
+
+#include <Guid/FileInfo.h>
+
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/EfiBootServicesLib.h>
+#include <Library/FileHandleLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscFileLib.h>
+#include <Library/MiscRuntimeLib.h>
+#include <Library/UefiLib.h>
+
+#include "MiscFileLibInternal.h"
+
+// MISC_FILE_PREFETCH
+typedef struct {
+  EFI_FILE_HANDLE   Root;        ///< NULL if the entry holds no data.
+  CONST CHAR16      *FileName;   ///< Points into the loaded trace.
+  BOOLEAN           Read;        ///< Whether the trace has recorded a read.
+  EFI_FILE_HANDLE   FileHandle;  ///< Kept open while the read is pending.
+  EFI_FILE_IO_TOKEN Token;
+} MISC_FILE_PREFETCH;
+
+// mMiscFilePrefetchTrace
+STATIC VOID *mMiscFilePrefetchTrace = NULL;
+
+// mMiscFilePrefetches
+/// The prefetched files, indexed by their trace path IDs.
+STATIC MISC_FILE_PREFETCH *mMiscFilePrefetches = NULL;
+
+// mNumberOfMiscFilePrefetches
+STATIC UINTN mNumberOfMiscFilePrefetches = 0;
+
+// mNextMiscFilePrefetch
+/// Where the next lookup starts, files are expected in trace order.
+STATIC UINTN mNextMiscFilePrefetch = 0;
+
+// InternalParseFileTrace
+/** Assigns the recorded paths to the prefetch entries and marks all paths
+    that have been read.
+
+  @param[in] Trace      The trace to parse.
+  @param[in] TraceSize  The size, in bytes, of Trace.
+
+  @retval EFI_SUCCESS           The trace has been parsed.
+  @retval EFI_VOLUME_CORRUPTED  The trace is malformed.
+**/
+STATIC
+EFI_STATUS
+InternalParseFileTrace (
+  IN CONST UINT8  *Trace,
+  IN UINTN        TraceSize
+  )
+{
+  EFI_STATUS                   Status;
+
+  CONST MISC_FILE_TRACE_HEADER *Header;
+  CONST MISC_FILE_TRACE_RECORD *Record;
+  UINTN                        Offset;
+  UINTN                        Index;
+  UINTN                        NumberOfPaths;
+  CONST CHAR16                 *Path;
+
+  Header        = (CONST MISC_FILE_TRACE_HEADER *)Trace;
+  Offset        = sizeof (*Header);
+  NumberOfPaths = 0;
+  Status        = EFI_SUCCESS;
+
+  for (Index = 0; Index < Header->NumberOfRecords; ++Index) {
+    Status = EFI_VOLUME_CORRUPTED;
+
+    if ((TraceSize - Offset) < sizeof (*Record)) {
+      break;
+    }
+
+    Record  = (CONST MISC_FILE_TRACE_RECORD *)&Trace[Offset];
+    Offset += sizeof (*Record);
+
+    if (Record->Type == MISC_FILE_TRACE_OPEN) {
+      if (Record->Size > 0) {
+        // New paths are assigned consecutive IDs and must be terminated.
+        if ((Record->PathId != NumberOfPaths)
+         || (NumberOfPaths >= mNumberOfMiscFilePrefetches)
+         || (Record->Size < sizeof (CHAR16))
+         || ((Record->Size % sizeof (CHAR16)) != 0)
+         || ((TraceSize - Offset) < Record->Size)) {
+          break;
+        }
+
+        Path = (CONST CHAR16 *)&Trace[Offset];
+
+        if (Path[(Record->Size / sizeof (CHAR16)) - 1] != L'\0') {
+          break;
+        }
+
+        mMiscFilePrefetches[NumberOfPaths].FileName = Path;
+
+        ++NumberOfPaths;
+        Offset += Record->Size;
+      } else if (Record->PathId >= NumberOfPaths) {
+        break;
+      }
+    } else if (Record->Type == MISC_FILE_TRACE_READ) {
+      if (Record->PathId >= NumberOfPaths) {
+        break;
+      }
+
+      mMiscFilePrefetches[Record->PathId].Read = TRUE;
+    }
+
+    Status = EFI_SUCCESS;
+  }
+
+  return Status;
+}
+
+// InternalStartPrefetch
+/** Starts reading a file into memory.
+
+  The read is issued asynchronously if the file system supports it.
+
+  @param[in]      Root      The volume's opened root.
+  @param[in, out] Prefetch  The entry to read the file of.
+**/
+STATIC
+VOID
+InternalStartPrefetch (
+  IN     EFI_FILE_HANDLE     Root,
+  IN OUT MISC_FILE_PREFETCH  *Prefetch
+  )
+{
+  EFI_STATUS Status;
+
+  UINT64     FileSize;
+
+  Status = Root->Open (
+                   Root,
+                   &Prefetch->FileHandle,
+                   (CHAR16 *)Prefetch->FileName,
+                   EFI_FILE_MODE_READ,
+                   0
+                   );
+
+  if (!EFI_ERROR (Status)) {
+    Status = FileHandleGetSize (Prefetch->FileHandle, &FileSize);
+
+    if (!EFI_ERROR (Status) && (FileSize > MAX_UINTN)) {
+      Status = EFI_UNSUPPORTED;
+    }
+
+    if (!EFI_ERROR (Status)) {
+      Prefetch->Token.Event      = NULL;
+      Prefetch->Token.BufferSize = (UINTN)FileSize;
+      Prefetch->Token.Buffer     = AllocatePool ((UINTN)FileSize);
+
+      Status = EFI_OUT_OF_RESOURCES;
+
+      if (Prefetch->Token.Buffer != NULL) {
+        Status = EFI_UNSUPPORTED;
+
+        if (Prefetch->FileHandle->Revision >= EFI_FILE_PROTOCOL_REVISION2) {
+          Status = EfiCreateEvent (
+                     0,
+                     TPL_CALLBACK,
+                     NULL,
+                     NULL,
+                     &Prefetch->Token.Event
+                     );
+
+          if (!EFI_ERROR (Status)) {
+            Status = Prefetch->FileHandle->ReadEx (
+                                             Prefetch->FileHandle,
+                                             &Prefetch->Token
+                                             );
+
+            if (EFI_ERROR (Status)) {
+              EfiCloseEvent (Prefetch->Token.Event);
+
+              Prefetch->Token.Event = NULL;
+            }
+          }
+        }
+
+        if (EFI_ERROR (Status)) {
+          Status = Prefetch->FileHandle->Read (
+                                           Prefetch->FileHandle,
+                                           &Prefetch->Token.BufferSize,
+                                           Prefetch->Token.Buffer
+                                           );
+
+          Prefetch->Token.Status = Status;
+        }
+
+        if (EFI_ERROR (Status)) {
+          FreePool (Prefetch->Token.Buffer);
+        }
+      }
+    }
+
+    // The handle must outlive asynchronous reads only.
+    if (EFI_ERROR (Status) || (Prefetch->Token.Event == NULL)) {
+      Prefetch->FileHandle->Close (Prefetch->FileHandle);
+
+      Prefetch->FileHandle = NULL;
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Prefetch->Root = Root;
+  }
+}
+
+// InternalCompletePrefetch
+/** Completes a prefetch.
+
+  Waiting for an event is allowed at TPL_APPLICATION only.  Above it, the
+  read is polled, either once or until it has completed.
+
+  @param[in, out] Prefetch  The entry to complete.
+  @param[in]      Poll      Whether to poll until the read has completed when
+                            waiting is not allowed.
+
+  @retval EFI_NOT_READY  The read is still pending.
+  @retval other          Returned is the status of the read.
+**/
+STATIC
+EFI_STATUS
+InternalCompletePrefetch (
+  IN OUT MISC_FILE_PREFETCH  *Prefetch,
+  IN     BOOLEAN             Poll
+  )
+{
+  EFI_STATUS Status;
+
+  UINTN      Index;
+
+  Status = EFI_SUCCESS;
+
+  if (Prefetch->Token.Event != NULL) {
+    if (EfiGetCurrentTpl () == TPL_APPLICATION) {
+      EfiWaitForEvent (1, &Prefetch->Token.Event, &Index);
+    } else {
+      do {
+        Status = EfiCheckEvent (Prefetch->Token.Event);
+      } while (Poll && (Status == EFI_NOT_READY));
+    }
+
+    if (Status != EFI_NOT_READY) {
+      EfiCloseEvent (Prefetch->Token.Event);
+
+      Prefetch->Token.Event = NULL;
+    }
+  }
+
+  if (Status != EFI_NOT_READY) {
+    if (Prefetch->FileHandle != NULL) {
+      Prefetch->FileHandle->Close (Prefetch->FileHandle);
+
+      Prefetch->FileHandle = NULL;
+    }
+
+    Status = Prefetch->Token.Status;
+  }
+
+  return Status;
+}
+
+// InternalTakePrefetchedFile
+/** Hands out a prefetched file.
+
+  The file's buffer is passed to the caller, so a hit costs no copy.  Above
+  TPL_APPLICATION, a read still pending is reported as not prefetched and is
+  left to MiscReleasePrefetchedFiles(), so the caller reads the file itself.
+
+  @param[in]  Root        The volume's opened root.
+  @param[in]  FileName    The path of the file to load.
+  @param[out] BufferSize  The size, in bytes, of the file.
+  @param[out] Buffer      The file's data.  Free with FreePool().
+
+  @retval EFI_SUCCESS    The file has been prefetched.
+  @retval EFI_NOT_FOUND  The file has not been prefetched.
+**/
+EFI_STATUS
+InternalTakePrefetchedFile (
+  IN  EFI_FILE_HANDLE  Root,
+  IN  CONST CHAR16     *FileName,
+  OUT UINTN            *BufferSize,
+  OUT VOID             **Buffer
+  )
+{
+  EFI_STATUS         Status;
+
+  UINTN              Count;
+  UINTN              Index;
+  MISC_FILE_PREFETCH *Prefetch;
+
+  Status = EFI_NOT_FOUND;
+  Index  = mNextMiscFilePrefetch;
+
+  for (Count = 0; Count < mNumberOfMiscFilePrefetches; ++Count) {
+    if (Index >= mNumberOfMiscFilePrefetches) {
+      Index = 0;
+    }
+
+    Prefetch = &mMiscFilePrefetches[Index];
+
+    if ((Prefetch->Root == Root)
+     && (MiscFileStriCmp (FileName, Prefetch->FileName) == 0)) {
+      Status = InternalCompletePrefetch (Prefetch, FALSE);
+
+      if (Status != EFI_NOT_READY) {
+        if (!EFI_ERROR (Status)) {
+          *BufferSize = Prefetch->Token.BufferSize;
+          *Buffer     = Prefetch->Token.Buffer;
+        } else {
+          FreePool (Prefetch->Token.Buffer);
+        }
+
+        Prefetch->Root = NULL;
+      }
+
+      if (EFI_ERROR (Status)) {
+        Status = EFI_NOT_FOUND;
+      }
+
+      mNextMiscFilePrefetch = (Index + 1);
+
+      break;
+    }
+
+    ++Index;
+  }
+
+  return Status;
+}
+
+// MiscPrefetchFiles
+/** Starts reading all files a trace has recorded reads of into memory.
+
+  The files are read in the order they have been first opened in.  Later
+  loads of these files relative to the same Root handle are served from
+  memory and the data is handed out without copying.  Prefetched data is not
+  revalidated against the media.
+
+  @param[in] Root           The volume's opened root.
+  @param[in] TraceFileName  The path of a trace written by
+                            MiscStopFileTrace().
+
+  @retval EFI_SUCCESS           The prefetch has been started.
+  @retval EFI_ALREADY_STARTED   Files have been prefetched already.
+  @retval EFI_VOLUME_CORRUPTED  The trace is malformed.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval other                 The trace could not be loaded.
+**/
+EFI_STATUS
+MiscPrefetchFiles (
+  IN EFI_FILE_HANDLE  Root,
+  IN CHAR16           *TraceFileName
+  )
+{
+  EFI_STATUS                   Status;
+
+  UINTN                        TraceSize;
+  VOID                         *Trace;
+  CONST MISC_FILE_TRACE_HEADER *Header;
+  UINTN                        Index;
+
+  ASSERT (Root != NULL);
+  ASSERT (TraceFileName != NULL);
+  ASSERT (!EfiAtRuntime ());
+
+  Status = EFI_ALREADY_STARTED;
+
+  if (mMiscFilePrefetchTrace == NULL) {
+    Status = LoadFile (Root, TraceFileName, &TraceSize, &Trace);
+
+    if (!EFI_ERROR (Status)) {
+      Header = (CONST MISC_FILE_TRACE_HEADER *)Trace;
+      Status = EFI_VOLUME_CORRUPTED;
+
+      // Every record must fit, and every path takes an open record and at
+      // least a terminator, before the counts may size anything.
+      if ((TraceSize >= sizeof (*Header))
+       && (Header->Signature == MISC_FILE_TRACE_SIGNATURE)
+       && (Header->Revision == MISC_FILE_TRACE_REVISION)
+       && (Header->NumberOfRecords
+            <= ((TraceSize - sizeof (*Header))
+                  / sizeof (MISC_FILE_TRACE_RECORD)))
+       && (Header->NumberOfPaths <= Header->NumberOfRecords)
+       && (Header->NumberOfPaths <= MISC_FILE_TRACE_MAX_PATHS)
+       && (Header->NumberOfPaths
+            <= ((TraceSize - sizeof (*Header))
+                  / (sizeof (MISC_FILE_TRACE_RECORD) + sizeof (CHAR16))))) {
+        mNumberOfMiscFilePrefetches = Header->NumberOfPaths;
+        mMiscFilePrefetches         = AllocateZeroPool (
+                                        mNumberOfMiscFilePrefetches
+                                          * sizeof (*mMiscFilePrefetches)
+                                        );
+
+        Status = EFI_OUT_OF_RESOURCES;
+
+        if (mMiscFilePrefetches != NULL) {
+          Status = InternalParseFileTrace ((CONST UINT8 *)Trace, TraceSize);
+
+          if (!EFI_ERROR (Status)) {
+            for (Index = 0; Index < mNumberOfMiscFilePrefetches; ++Index) {
+              if (mMiscFilePrefetches[Index].Read) {
+                InternalStartPrefetch (Root, &mMiscFilePrefetches[Index]);
+              }
+            }
+
+            mMiscFilePrefetchTrace = Trace;
+            mNextMiscFilePrefetch  = 0;
+          } else {
+            FreePool ((VOID *)mMiscFilePrefetches);
+
+            mMiscFilePrefetches = NULL;
+          }
+        }
+      }
+
+      if (EFI_ERROR (Status)) {
+        mNumberOfMiscFilePrefetches = 0;
+
+        FreePool (Trace);
+      }
+    }
+  }
+
+  return Status;
+}
+
+// MiscReleasePrefetchedFiles
+/** Waits for all pending prefetches and frees all data not handed out.
+**/
+VOID
+MiscReleasePrefetchedFiles (
+  VOID
+  )
+{
+  UINTN              Index;
+  MISC_FILE_PREFETCH *Prefetch;
+
+  ASSERT (!EfiAtRuntime ());
+
+  if (mMiscFilePrefetchTrace != NULL) {
+    for (Index = 0; Index < mNumberOfMiscFilePrefetches; ++Index) {
+      Prefetch = &mMiscFilePrefetches[Index];
+
+      if (Prefetch->Root != NULL) {
+        InternalCompletePrefetch (Prefetch, TRUE);
+        FreePool (Prefetch->Token.Buffer);
+      }
+    }
+
+    FreePool ((VOID *)mMiscFilePrefetches);
+    FreePool (mMiscFilePrefetchTrace);
+
+    mMiscFilePrefetchTrace      = NULL;
+    mMiscFilePrefetches         = NULL;
+    mNumberOfMiscFilePrefetches = 0;
+    mNextMiscFilePrefetch       = 0;
+  }
+}
@@ -0,0 +1,429 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/EfiBootServicesLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscFileLib.h>
+#include <Library/MiscRuntimeLib.h>
+#include <Library/UefiLib.h>
+
+#include "MiscFileLibInternal.h"
+
+// MISC_FILE_PROBE_CONTEXT
+/// Shared by the caller and all pending requests, freed by the last of them.
+typedef struct {
+  UINTN                References;
+  UINTN                Pending;         ///< Includes the issuing caller.
+  MISC_FILE_PROBE_MODE Mode;
+  BOOLEAN              Synchronous;     ///< Probes must not be waited for.
+  EFI_TPL              Tpl;             ///< Serialises the probes.
+  BOOLEAN              Matched;         ///< Any path has been found.
+  BOOLEAN              Abandoned;       ///< The caller has returned.
+  EFI_EVENT            Done;
+  UINTN                NumberOfVolumes;
+  EFI_FILE_HANDLE      *Roots;
+  UINT64               *Hits;
+} MISC_FILE_PROBE_CONTEXT;
+
+// MISC_FILE_PROBE_REQUEST
+typedef struct {
+  EFI_FILE_IO_TOKEN       Token;
+  EFI_FILE_HANDLE         NewHandle;
+  MISC_FILE_PROBE_CONTEXT *Context;
+  UINTN                   Volume;
+  UINTN                   PathIndex;
+} MISC_FILE_PROBE_REQUEST;
+
+// InternalReleaseProbe
+/** Drops a reference to a probe context and frees it with the last one.
+
+  Must be called at the context's TPL.
+**/
+STATIC
+VOID
+InternalReleaseProbe (
+  IN MISC_FILE_PROBE_CONTEXT  *Context
+  )
+{
+  UINTN Index;
+
+  ASSERT (Context->References > 0);
+
+  --Context->References;
+
+  if (Context->References == 0) {
+    for (Index = 0; Index < Context->NumberOfVolumes; ++Index) {
+      if (Context->Roots[Index] != NULL) {
+        Context->Roots[Index]->Close (Context->Roots[Index]);
+      }
+    }
+
+    FreePool ((VOID *)Context);
+  }
+}
+
+// InternalCompleteProbe
+/** Accounts a completed probe and signals the caller once it may return.
+
+  Must be called at the context's TPL.
+**/
+STATIC
+VOID
+InternalCompleteProbe (
+  IN OUT MISC_FILE_PROBE_CONTEXT  *Context,
+  IN     UINTN                    Volume,
+  IN     UINTN                    PathIndex,
+  IN     BOOLEAN                  Found
+  )
+{
+  ASSERT (Context->Pending > 0);
+
+  --Context->Pending;
+
+  if (!Context->Abandoned) {
+    if (Found) {
+      Context->Hits[Volume] |= LShiftU64 (1, PathIndex);
+      Context->Matched       = TRUE;
+    }
+
+    if ((Context->Pending == 0)
+     || (Found && (Context->Mode == MiscFileProbeFirstMatch))) {
+      EfiSignalEvent (Context->Done);
+    }
+  }
+}
+
+// InternalProbeNotify
+/** Completes an asynchronous probe.
+**/
+STATIC
+VOID
+EFIAPI
+InternalProbeNotify (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  MISC_FILE_PROBE_REQUEST *Request;
+  BOOLEAN                 Found;
+
+  Request = (MISC_FILE_PROBE_REQUEST *)Context;
+  Found   = (BOOLEAN)!EFI_ERROR (Request->Token.Status);
+
+  if (Found) {
+    Request->NewHandle->Close (Request->NewHandle);
+  }
+
+  InternalCompleteProbe (
+    Request->Context,
+    Request->Volume,
+    Request->PathIndex,
+    Found
+    );
+
+  InternalReleaseProbe (Request->Context);
+
+  EfiCloseEvent (Event);
+  FreePool ((VOID *)Request);
+}
+
+// InternalIssueProbe
+/** Probes a path on a volume, asynchronously if the file system supports it
+    and the context is not synchronous.
+**/
+STATIC
+VOID
+InternalIssueProbe (
+  IN OUT MISC_FILE_PROBE_CONTEXT  *Context,
+  IN     UINTN                    Volume,
+  IN     UINTN                    PathIndex,
+  IN     CONST CHAR16             *Path
+  )
+{
+  EFI_FILE_HANDLE         Root;
+  MISC_FILE_PROBE_REQUEST *Request;
+  EFI_FILE_HANDLE         NewHandle;
+  EFI_STATUS              Status;
+  EFI_TPL                 OldTpl;
+
+  Root    = Context->Roots[Volume];
+  Status  = EFI_UNSUPPORTED;
+  Request = NULL;
+
+  if (!Context->Synchronous
+   && (Root->Revision >= EFI_FILE_PROTOCOL_REVISION2)) {
+    Request = AllocatePool (sizeof (*Request));
+
+    if (Request != NULL) {
+      Request->Context   = Context;
+      Request->Volume    = Volume;
+      Request->PathIndex = PathIndex;
+
+      Status = EfiCreateEvent (
+                 EVT_NOTIFY_SIGNAL,
+                 TPL_CALLBACK,
+                 InternalProbeNotify,
+                 (VOID *)Request,
+                 &Request->Token.Event
+                 );
+
+      if (!EFI_ERROR (Status)) {
+        // Account the request first, it may complete before OpenEx returns.
+        OldTpl = EfiRaiseTPL (Context->Tpl);
+
+        ++Context->References;
+        ++Context->Pending;
+
+        EfiRestoreTPL (OldTpl);
+
+        Status = Root->OpenEx (
+                         Root,
+                         &Request->NewHandle,
+                         (CHAR16 *)Path,
+                         EFI_FILE_MODE_READ,
+                         0,
+                         &Request->Token
+                         );
+
+        if (EFI_ERROR (Status)) {
+          // The event is not signalled for requests failing immediately.
+          OldTpl = EfiRaiseTPL (Context->Tpl);
+
+          --Context->References;
+          --Context->Pending;
+
+          EfiRestoreTPL (OldTpl);
+
+          EfiCloseEvent (Request->Token.Event);
+        }
+      }
+
+      if (EFI_ERROR (Status)) {
+        FreePool ((VOID *)Request);
+      }
+    }
+  }
+
+  // Any other error is the definite result of the probe.
+  if ((Status == EFI_UNSUPPORTED) || (Status == EFI_OUT_OF_RESOURCES)) {
+    Status = Root->Open (
+                     Root,
+                     &NewHandle,
+                     (CHAR16 *)Path,
+                     EFI_FILE_MODE_READ,
+                     0
+                     );
+
+    if (!EFI_ERROR (Status)) {
+      NewHandle->Close (NewHandle);
+
+      OldTpl = EfiRaiseTPL (Context->Tpl);
+
+      Context->Hits[Volume] |= LShiftU64 (1, PathIndex);
+      Context->Matched       = TRUE;
+
+      EfiRestoreTPL (OldTpl);
+    }
+  }
+}
+
+// MiscProbeVolumes
+/** Probes paths on all volumes concurrently.
+
+  All volumes are opened first, then every path is probed on every volume.
+  File systems supporting OpenEx() are probed asynchronously, so slow devices
+  do not delay fast ones.  Requests still pending when the function returns
+  complete in the background and clean up after themselves.
+
+  Waiting for the probes is allowed at TPL_APPLICATION only.  Above it, all
+  paths are opened synchronously instead.
+
+  @param[in]  NumberOfPaths    The number of elements in Paths, at most 64.
+  @param[in]  Paths            The paths to probe.
+  @param[in]  Mode             Whether to wait for all probes or for the first
+                               hit only.  In the latter case, only the hits
+                               completed until then are reported.
+  @param[out] NumberOfVolumes  The number of volumes probed.
+  @param[out] Volumes          The handles of the probed volumes.  Free with
+                               FreePool().
+  @param[out] Hits             One bitmap per volume, bit N being set if
+                               Paths[N] exists.  Free with FreePool().
+
+  @retval EFI_SUCCESS            The volumes have been probed.
+  @retval EFI_INVALID_PARAMETER  More than 64 paths have been passed.
+  @retval EFI_NOT_FOUND          No volume has been found.
+  @retval EFI_OUT_OF_RESOURCES   Memory allocation failed.
+**/
+EFI_STATUS
+MiscProbeVolumes (
+  IN  UINTN                 NumberOfPaths,
+  IN  CONST CHAR16          **Paths,
+  IN  MISC_FILE_PROBE_MODE  Mode,
+  OUT UINTN                 *NumberOfVolumes,
+  OUT EFI_HANDLE            **Volumes,
+  OUT UINT64                **Hits
+  )
+{
+  EFI_STATUS                      Status;
+
+  UINTN                           NumberOfHandles;
+  EFI_HANDLE                      *Handles;
+  MISC_FILE_PROBE_CONTEXT         *Context;
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL *FileSystem;
+  UINT64                          *Result;
+  EFI_TPL                         CurrentTpl;
+  UINTN                           Volume;
+  UINTN                           PathIndex;
+  UINTN                           Index;
+  EFI_TPL                         OldTpl;
+
+  ASSERT ((NumberOfPaths == 0) || (Paths != NULL));
+  ASSERT ((Mode == MiscFileProbeAll) || (Mode == MiscFileProbeFirstMatch));
+  ASSERT (NumberOfVolumes != NULL);
+  ASSERT (Volumes != NULL);
+  ASSERT (Hits != NULL);
+  ASSERT (!EfiAtRuntime ());
+
+  Status = EFI_INVALID_PARAMETER;
+
+  if (NumberOfPaths <= 64) {
+    Status = EfiLocateHandleBuffer (
+               ByProtocol,
+               &gEfiSimpleFileSystemProtocolGuid,
+               NULL,
+               &NumberOfHandles,
+               &Handles
+               );
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Result  = AllocateZeroPool (NumberOfHandles * sizeof (*Result));
+    Context = AllocateZeroPool (
+                sizeof (*Context)
+                  + (NumberOfHandles * sizeof (*Context->Roots))
+                  + (NumberOfHandles * sizeof (*Context->Hits))
+                );
+
+    Status = EFI_OUT_OF_RESOURCES;
+
+    if ((Result != NULL) && (Context != NULL)) {
+      Status = EfiCreateEvent (0, TPL_CALLBACK, NULL, NULL, &Context->Done);
+    }
+
+    if (!EFI_ERROR (Status)) {
+      CurrentTpl = EfiGetCurrentTpl ();
+
+      Context->References      = 1;
+      Context->Pending         = 1;
+      Context->Mode            = Mode;
+      Context->Synchronous     = (BOOLEAN)(CurrentTpl > TPL_APPLICATION);
+      Context->Tpl             = MAX (CurrentTpl, TPL_CALLBACK);
+      Context->NumberOfVolumes = NumberOfHandles;
+      Context->Roots           = (EFI_FILE_HANDLE *)(Context + 1);
+      Context->Hits            = (UINT64 *)&Context->Roots[NumberOfHandles];
+
+      // Opening the volumes is synchronous, do it before issuing any probe.
+      for (Volume = 0; Volume < NumberOfHandles; ++Volume) {
+        Status = EfiHandleProtocol (
+                   Handles[Volume],
+                   &gEfiSimpleFileSystemProtocolGuid,
+                   (VOID **)&FileSystem
+                   );
+
+        if (!EFI_ERROR (Status)) {
+          Status = FileSystem->OpenVolume (
+                                 FileSystem,
+                                 &Context->Roots[Volume]
+                                 );
+
+          if (EFI_ERROR (Status)) {
+            Context->Roots[Volume] = NULL;
+          }
+        }
+      }
+
+      // Issue path by path, so the first paths are probed everywhere first.
+      // In first match mode, stop issuing as soon as any probe, including an
+      // asynchronous one, has found its path.
+      for (PathIndex = 0; PathIndex < NumberOfPaths; ++PathIndex) {
+        for (Volume = 0; Volume < NumberOfHandles; ++Volume) {
+          if (Context->Matched && (Mode == MiscFileProbeFirstMatch)) {
+            break;
+          }
+
+          if (Context->Roots[Volume] != NULL) {
+            InternalIssueProbe (
+              Context,
+              Volume,
+              PathIndex,
+              Paths[PathIndex]
+              );
+          }
+        }
+      }
+
+      // Drop the issuer's pending count, which may complete the probe.
+      OldTpl = EfiRaiseTPL (Context->Tpl);
+      InternalCompleteProbe (Context, 0, 0, FALSE);
+      EfiRestoreTPL (OldTpl);
+
+      // Synchronous probes have all completed, a first match needs no wait.
+      if (!Context->Synchronous
+       && !(Context->Matched && (Mode == MiscFileProbeFirstMatch))) {
+        EfiWaitForEvent (1, &Context->Done, &Index);
+      }
+
+      OldTpl = EfiRaiseTPL (Context->Tpl);
+
+      CopyMem (
+        (VOID *)Result,
+        (VOID *)Context->Hits,
+        (NumberOfHandles * sizeof (*Result))
+        );
+
+      Context->Abandoned = TRUE;
+
+      EfiCloseEvent (Context->Done);
+      InternalReleaseProbe (Context);
+
+      EfiRestoreTPL (OldTpl);
+
+      *NumberOfVolumes = NumberOfHandles;
+      *Volumes         = Handles;
+      *Hits            = Result;
+      Status           = EFI_SUCCESS;
+    } else {
+      if (Result != NULL) {
+        FreePool ((VOID *)Result);
+      }
+
+      if (Context != NULL) {
+        FreePool ((VOID *)Context);
+      }
+
+      FreePool ((VOID *)Handles);
+    }
+  }
+
+  return Status;
+}
@@ -0,0 +1,238 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Guid/FileInfo.h>
+
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/FileHandleLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscFileLib.h>
+#include <Library/MiscRuntimeLib.h>
+
+#include "MiscFileLibInternal.h"
+
+// InternalReadRangeAt
+/** Reads a range, seeking only if the file is not positioned at it yet.
+
+  The range is clamped to the end of the file first, a range starting at or
+  beyond it is not read at all, as the file systems reject positioning past
+  the end of a file.
+
+  @param[in]      FileHandle  The file to read from.
+  @param[in]      FileSize    The size of the file.
+  @param[in, out] Position    The file's current position.
+  @param[in]      Offset      The offset of the range.
+  @param[in, out] Size        On input, the size of the range.  On output,
+                              the number of bytes read.
+  @param[out]     Buffer      The buffer to read into.
+
+  @return  Returned is the status of the file system.
+**/
+STATIC
+EFI_STATUS
+InternalReadRangeAt (
+  IN     EFI_FILE_HANDLE  FileHandle,
+  IN     UINT64           FileSize,
+  IN OUT UINT64           *Position,
+  IN     UINT64           Offset,
+  IN OUT UINTN            *Size,
+  OUT    VOID             *Buffer
+  )
+{
+  EFI_STATUS Status;
+
+  Status = EFI_SUCCESS;
+
+  if (Offset >= FileSize) {
+    *Size = 0;
+  } else {
+    if (*Size > (FileSize - Offset)) {
+      *Size = (UINTN)(FileSize - Offset);
+    }
+
+    if (*Position != Offset) {
+      Status = FileHandle->SetPosition (FileHandle, Offset);
+    }
+
+    if (!EFI_ERROR (Status)) {
+      *Position = Offset;
+      Status    = MiscReadFileChunked (
+                    FileHandle,
+                    Size,
+                    Buffer,
+                    MAX_UINTN,
+                    NULL,
+                    NULL
+                    );
+
+      *Position += *Size;
+
+      InternalTraceFileHandleRead (FileHandle, Offset, *Size);
+    }
+  }
+
+  return Status;
+}
+
+// MiscReadFileRange
+/** Reads a range of a file.
+
+  @param[in]      FileHandle  The file to read from.
+  @param[in]      Offset      The offset of the range.
+  @param[in, out] Size        On input, the size of the range.  On output,
+                              the number of bytes read, which is less when
+                              the range exceeds the end of the file and 0
+                              when it starts at or beyond it.
+  @param[out]     Buffer      The buffer to read into.
+
+  @return  Returned is the status of the file system.
+**/
+EFI_STATUS
+MiscReadFileRange (
+  IN     EFI_FILE_HANDLE  FileHandle,
+  IN     UINT64           Offset,
+  IN OUT UINTN            *Size,
+  OUT    VOID             *Buffer
+  )
+{
+  EFI_STATUS Status;
+
+  UINT64     FileSize;
+  UINT64     Position;
+
+  ASSERT (FileHandle != NULL);
+  ASSERT (Size != NULL);
+  ASSERT ((Buffer != NULL) || (*Size == 0));
+  ASSERT (!EfiAtRuntime ());
+
+  Status = FileHandleGetSize (FileHandle, &FileSize);
+
+  if (!EFI_ERROR (Status)) {
+    Status = FileHandle->GetPosition (FileHandle, &Position);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Status = InternalReadRangeAt (
+               FileHandle,
+               FileSize,
+               &Position,
+               Offset,
+               Size,
+               Buffer
+               );
+  }
+
+  return Status;
+}
+
+// MiscReadFileRanges
+/** Reads multiple ranges of a file in ascending offset order.
+
+  The ranges are read sorted by their offsets to keep the seeks short and
+  adjacent ranges are read without seeking at all.  The order of Ranges is
+  not modified.  Ranges are clamped to the end of the file as described for
+  MiscReadFileRange().
+
+  @param[in]      FileHandle      The file to read from.
+  @param[in]      NumberOfRanges  The number of elements in Ranges.
+  @param[in, out] Ranges          The ranges to read.  ReadSize receives the
+                                  number of bytes read into Buffer.
+
+  @retval EFI_SUCCESS           All ranges have been read.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval other                 The error returned by the file system.
+**/
+EFI_STATUS
+MiscReadFileRanges (
+  IN     EFI_FILE_HANDLE  FileHandle,
+  IN     UINTN            NumberOfRanges,
+  IN OUT MISC_FILE_RANGE  *Ranges
+  )
+{
+  EFI_STATUS      Status;
+
+  MISC_FILE_RANGE **Order;
+  MISC_FILE_RANGE *Range;
+  UINTN           Index;
+  UINTN           Index2;
+  UINT64          FileSize;
+  UINT64          Position;
+
+  ASSERT (FileHandle != NULL);
+  ASSERT ((NumberOfRanges == 0) || (Ranges != NULL));
+  ASSERT (!EfiAtRuntime ());
+
+  Status = EFI_SUCCESS;
+
+  if (NumberOfRanges > 0) {
+    Order  = AllocatePool (NumberOfRanges * sizeof (*Order));
+    Status = EFI_OUT_OF_RESOURCES;
+
+    if (Order != NULL) {
+      // Insertion sort, the lists are expected to be short and mostly sorted.
+      for (Index = 0; Index < NumberOfRanges; ++Index) {
+        Range = &Ranges[Index];
+
+        ASSERT ((Range->Buffer != NULL) || (Range->Size == 0));
+
+        Range->ReadSize = 0;
+
+        for (Index2 = Index; Index2 > 0; --Index2) {
+          if (Order[Index2 - 1]->Offset <= Range->Offset) {
+            break;
+          }
+
+          Order[Index2] = Order[Index2 - 1];
+        }
+
+        Order[Index2] = Range;
+      }
+
+      Status = FileHandleGetSize (FileHandle, &FileSize);
+
+      if (!EFI_ERROR (Status)) {
+        Status = FileHandle->GetPosition (FileHandle, &Position);
+      }
+
+      for (Index = 0; Index < NumberOfRanges; ++Index) {
+        if (EFI_ERROR (Status)) {
+          break;
+        }
+
+        Range           = Order[Index];
+        Range->ReadSize = Range->Size;
+
+        Status = InternalReadRangeAt (
+                   FileHandle,
+                   FileSize,
+                   &Position,
+                   Range->Offset,
+                   &Range->ReadSize,
+                   Range->Buffer
+                   );
+      }
+
+      FreePool ((VOID *)Order);
+    }
+  }
+
+  return Status;
+}
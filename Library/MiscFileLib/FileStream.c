@@ -0,0 +1,169 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <IndustryStandard/MiscFileTrace.h>
+
+#include <Guid/FileInfo.h>
+
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/FileHandleLib.h>
+#include <Library/MiscFileLib.h>
+#include <Library/MiscRuntimeLib.h>
+
+#include "MiscFileLibInternal.h"
+
+// MiscReadFileChunked
+/** Reads a file sequentially and passes every chunk to a handler as soon as
+    it has arrived.
+
+  The data is read straight into Buffer.  Handlers hence see every chunk
+  while it is still cache-hot and no second pass over Buffer is required.
+
+  @param[in]      FileHandle  The file to read from its current position.
+  @param[in, out] BufferSize  On input, the size of Buffer.  On output, the
+                              number of bytes read.
+  @param[out]     Buffer      The buffer to read into.
+  @param[in]      ChunkSize   The maximum number of bytes read at once.
+  @param[in]      Handler     Optional, called for every chunk read.
+  @param[in]      Context     Passed to Handler.
+
+  @retval EFI_SUCCESS  The file has been read up to its end or until Buffer
+                       has been filled.
+  @retval other        The error returned by the file system or by Handler,
+                       which stops the read.
+**/
+EFI_STATUS
+MiscReadFileChunked (
+  IN     EFI_FILE_HANDLE          FileHandle,
+  IN OUT UINTN                    *BufferSize,
+  OUT    VOID                     *Buffer,
+  IN     UINTN                    ChunkSize,
+  IN     MISC_FILE_CHUNK_HANDLER  Handler OPTIONAL,
+  IN     VOID                     *Context OPTIONAL
+  )
+{
+  EFI_STATUS Status;
+
+  UINTN      Offset;
+  UINTN      ReadSize;
+
+  ASSERT (FileHandle != NULL);
+  ASSERT (BufferSize != NULL);
+  ASSERT ((Buffer != NULL) || (*BufferSize == 0));
+  ASSERT (ChunkSize > 0);
+  ASSERT (!EfiAtRuntime ());
+
+  Status = EFI_SUCCESS;
+  Offset = 0;
+
+  while (Offset < *BufferSize) {
+    ReadSize = MIN ((*BufferSize - Offset), ChunkSize);
+    Status   = FileHandle->Read (
+                             FileHandle,
+                             &ReadSize,
+                             (VOID *)((UINT8 *)Buffer + Offset)
+                             );
+
+    if (EFI_ERROR (Status) || (ReadSize == 0)) {
+      break;
+    }
+
+    if (Handler != NULL) {
+      Status = Handler (Context, (VOID *)((UINT8 *)Buffer + Offset), ReadSize);
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+    }
+
+    Offset += ReadSize;
+  }
+
+  *BufferSize = Offset;
+
+  return Status;
+}
+
+// LoadCompressedFile
+/** Loads and decodes a compressed file in one pass.
+
+  The decoder reads the compressed data from the file chunk by chunk and
+  decodes it straight into the final buffer, so the compressed file is never
+  held in memory as a whole.
+
+  @param[in]  Root        The volume's opened root.
+  @param[in]  FileName    The path of the file to load.
+  @param[in]  Decode      The decoder of the file's compression format, e.g.
+                          MiscLz4DecodeFile().
+  @param[out] BufferSize  The size, in bytes, of the decoded data.
+  @param[out] Buffer      The decoded data.  Free with FreePool().
+
+  @return  Returned is the status of the file system or of Decode.
+**/
+EFI_STATUS
+LoadCompressedFile (
+  IN  EFI_FILE_HANDLE   Root,
+  IN  CHAR16            *FileName,
+  IN  MISC_FILE_DECODE  Decode,
+  OUT UINTN             *BufferSize,
+  OUT VOID              **Buffer
+  )
+{
+  EFI_STATUS      Status;
+
+  EFI_FILE_HANDLE FileHandle;
+  UINT64          FileSize;
+  UINT16          PathId;
+
+  ASSERT (Root != NULL);
+  ASSERT (FileName != NULL);
+  ASSERT (FileName[0] != L'\0');
+  ASSERT (Decode != NULL);
+  ASSERT (BufferSize != NULL);
+  ASSERT (Buffer != NULL);
+  ASSERT (!EfiAtRuntime ());
+
+  Status = Root->Open (Root, &FileHandle, FileName, EFI_FILE_MODE_READ, 0);
+
+  if ((Status != EFI_NOT_FOUND)
+   && (Status != EFI_NO_MEDIA)
+   && (Status != EFI_MEDIA_CHANGED)) {
+    ASSERT_EFI_ERROR (Status);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Status = Decode (FileHandle, BufferSize, Buffer);
+
+    if (!EFI_ERROR (Status)) {
+      PathId = InternalTraceFileOpen (FileName);
+
+      // The trace records the compressed data read, not the decoded data.
+      if ((PathId != MISC_FILE_TRACE_MAX_PATHS)
+       && !EFI_ERROR (FileHandleGetSize (FileHandle, &FileSize))) {
+        InternalTraceFileRead (PathId, 0, (UINTN)MIN (FileSize, MAX_UINTN));
+      }
+    }
+
+    FileHandleClose (FileHandle);
+  }
+
+  return Status;
+}
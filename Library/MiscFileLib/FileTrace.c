@@ -0,0 +1,496 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <IndustryStandard/MiscFileTrace.h>
+
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscFileLib.h>
+#include <Library/MiscRuntimeLib.h>
+#include <Library/TimerLib.h>
+
+#include "MiscFileLibInternal.h"
+
+// MISC_FILE_TRACE_INITIAL_SIZE
+#define MISC_FILE_TRACE_INITIAL_SIZE  SIZE_4KB
+
+// mMiscFileTrace
+/// The trace being recorded, NULL if recording is inactive.
+STATIC UINT8 *mMiscFileTrace = NULL;
+
+// mMiscFileTraceBufferSize
+STATIC UINTN mMiscFileTraceBufferSize = 0;
+
+// mMiscFileTraceSize
+STATIC UINTN mMiscFileTraceSize = 0;
+
+// mMiscFileTracePaths
+/// The offsets of the recorded paths into mMiscFileTrace, by path ID.
+STATIC UINTN *mMiscFileTracePaths = NULL;
+
+// mMiscFileTracePathsSize
+STATIC UINTN mMiscFileTracePathsSize = 0;
+
+// mMiscFileTraceStartTime
+STATIC UINT64 mMiscFileTraceStartTime = 0;
+
+// MISC_FILE_TRACE_HANDLE
+typedef struct {
+  EFI_FILE_HANDLE FileHandle;
+  UINT16          PathId;
+} MISC_FILE_TRACE_HANDLE;
+
+// mMiscFileTraceHandles
+/// The opened files ranged reads are recorded for.
+STATIC MISC_FILE_TRACE_HANDLE *mMiscFileTraceHandles = NULL;
+
+// mMiscFileTraceHandlesSize
+STATIC UINTN mMiscFileTraceHandlesSize = 0;
+
+// mNumberOfMiscFileTraceHandles
+STATIC UINTN mNumberOfMiscFileTraceHandles = 0;
+
+// InternalAppendTraceRecord
+/** Appends a record and the path following it to the trace.
+
+  @param[in] Type      The record's type.
+  @param[in] PathId    The ID of the path accessed.
+  @param[in] Size      The record's size field.
+  @param[in] Offset    The record's offset field.
+  @param[in] Path      Optional, the path to append after the record.  Its
+                       size must be Size.
+
+  @retval EFI_SUCCESS           The record has been appended.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed, the trace is
+                                unchanged.
+**/
+STATIC
+EFI_STATUS
+InternalAppendTraceRecord (
+  IN UINT8         Type,
+  IN UINT16        PathId,
+  IN UINT32        Size,
+  IN UINT64        Offset,
+  IN CONST CHAR16  *Path OPTIONAL
+  )
+{
+  EFI_STATUS             Status;
+
+  UINTN                  RecordSize;
+  MISC_FILE_TRACE_RECORD *Record;
+  MISC_FILE_TRACE_HEADER *Header;
+  UINT64                 Time;
+
+  RecordSize = sizeof (*Record);
+
+  if (Path != NULL) {
+    RecordSize += Size;
+  }
+
+  Status = InternalGrowBuffer (
+             (VOID **)&mMiscFileTrace,
+             &mMiscFileTraceBufferSize,
+             (mMiscFileTraceSize + RecordSize)
+             );
+
+  if (!EFI_ERROR (Status)) {
+    Time = (GetTimeInNanoSecond (GetPerformanceCounter ())
+              - mMiscFileTraceStartTime);
+
+    Record = (MISC_FILE_TRACE_RECORD *)&mMiscFileTrace[mMiscFileTraceSize];
+
+    Record->Type     = Type;
+    Record->Reserved = 0;
+    Record->PathId   = PathId;
+    Record->Size     = Size;
+    Record->Offset   = Offset;
+    Record->Time     = (UINT32)MIN (DivU64x32 (Time, 1000), MAX_UINT32);
+
+    if (Path != NULL) {
+      CopyMem ((VOID *)(Record + 1), (VOID *)Path, Size);
+    }
+
+    mMiscFileTraceSize += RecordSize;
+
+    Header = (MISC_FILE_TRACE_HEADER *)mMiscFileTrace;
+    ++Header->NumberOfRecords;
+  }
+
+  return Status;
+}
+
+// InternalTraceFileOpen
+/** Records the open of a path if a trace is being recorded.
+
+  @param[in] FileName  The path opened.
+
+  @return  Returned is the path's ID or MISC_FILE_TRACE_MAX_PATHS if the open
+           has not been recorded.
+**/
+UINT16
+InternalTraceFileOpen (
+  IN CONST CHAR16  *FileName
+  )
+{
+  UINTN                  PathId;
+
+  UINTN                  NumberOfPaths;
+  UINTN                  Size;
+  MISC_FILE_TRACE_HEADER *Header;
+  EFI_STATUS             Status;
+
+  ASSERT (FileName != NULL);
+
+  PathId = MISC_FILE_TRACE_MAX_PATHS;
+
+  if (mMiscFileTrace != NULL) {
+    Header        = (MISC_FILE_TRACE_HEADER *)mMiscFileTrace;
+    NumberOfPaths = Header->NumberOfPaths;
+
+    // Boot paths are few, a linear search is cheaper than maintaining a hash.
+    for (PathId = 0; PathId < NumberOfPaths; ++PathId) {
+      if (MiscFileStriCmp (
+            FileName,
+            (CONST CHAR16 *)&mMiscFileTrace[mMiscFileTracePaths[PathId]]
+            ) == 0) {
+        break;
+      }
+    }
+
+    if (PathId < NumberOfPaths) {
+      InternalAppendTraceRecord (
+        MISC_FILE_TRACE_OPEN,
+        (UINT16)PathId,
+        0,
+        0,
+        NULL
+        );
+    } else if (NumberOfPaths < MISC_FILE_TRACE_MAX_PATHS) {
+      Size   = StrSize (FileName);
+      Status = InternalGrowBuffer (
+                 (VOID **)&mMiscFileTracePaths,
+                 &mMiscFileTracePathsSize,
+                 ((NumberOfPaths + 1) * sizeof (*mMiscFileTracePaths))
+                 );
+
+      if (!EFI_ERROR (Status)) {
+        mMiscFileTracePaths[PathId] = (mMiscFileTraceSize
+                                        + sizeof (MISC_FILE_TRACE_RECORD));
+
+        Status = InternalAppendTraceRecord (
+                   MISC_FILE_TRACE_OPEN,
+                   (UINT16)PathId,
+                   (UINT32)Size,
+                   0,
+                   FileName
+                   );
+      }
+
+      if (!EFI_ERROR (Status)) {
+        // The header may have moved while growing the trace.
+        Header = (MISC_FILE_TRACE_HEADER *)mMiscFileTrace;
+        ++Header->NumberOfPaths;
+      } else {
+        PathId = MISC_FILE_TRACE_MAX_PATHS;
+      }
+    } else {
+      PathId = MISC_FILE_TRACE_MAX_PATHS;
+    }
+  }
+
+  return (UINT16)PathId;
+}
+
+// InternalTraceFileRead
+/** Records the read of a range if a trace is being recorded.
+
+  @param[in] PathId  The ID returned for the path by InternalTraceFileOpen().
+  @param[in] Offset  The offset of the range read.
+  @param[in] Size    The number of bytes read.
+**/
+VOID
+InternalTraceFileRead (
+  IN UINT16  PathId,
+  IN UINT64  Offset,
+  IN UINTN   Size
+  )
+{
+  if ((mMiscFileTrace != NULL) && (PathId != MISC_FILE_TRACE_MAX_PATHS)) {
+    InternalAppendTraceRecord (
+      MISC_FILE_TRACE_READ,
+      PathId,
+      (UINT32)MIN (Size, MAX_UINT32),
+      Offset,
+      NULL
+      );
+  }
+}
+
+// InternalFindTraceHandle
+/** Returns the index of an opened file's association.
+
+  @param[in] FileHandle  The opened file to look up.
+
+  @return  Returned is the index or mNumberOfMiscFileTraceHandles if the file
+           is not associated with a path.
+**/
+STATIC
+UINTN
+InternalFindTraceHandle (
+  IN EFI_FILE_HANDLE  FileHandle
+  )
+{
+  UINTN Index;
+
+  for (Index = 0; Index < mNumberOfMiscFileTraceHandles; ++Index) {
+    if (mMiscFileTraceHandles[Index].FileHandle == FileHandle) {
+      break;
+    }
+  }
+
+  return Index;
+}
+
+// InternalTraceFileHandleRead
+/** Records the read of a range of an opened file if a trace is being recorded
+    and the file has been associated with its path.
+
+  @param[in] FileHandle  The file read from.
+  @param[in] Offset      The offset of the range read.
+  @param[in] Size        The number of bytes read.
+**/
+VOID
+InternalTraceFileHandleRead (
+  IN EFI_FILE_HANDLE  FileHandle,
+  IN UINT64           Offset,
+  IN UINTN            Size
+  )
+{
+  UINTN Index;
+
+  if (mMiscFileTrace != NULL) {
+    Index = InternalFindTraceHandle (FileHandle);
+
+    if (Index < mNumberOfMiscFileTraceHandles) {
+      InternalTraceFileRead (
+        mMiscFileTraceHandles[Index].PathId,
+        Offset,
+        Size
+        );
+    }
+  }
+}
+
+// MiscTraceFileHandle
+/** Associates an opened file with its path so its ranged reads are recorded.
+
+  MiscReadFileRange() and MiscReadFileRanges() read through handles, which do
+  not carry their paths, so their reads are recorded for associated files
+  only.  The association records an open of the path and lasts until it is
+  removed or the trace is stopped.  Remove it before closing the file, as the
+  handle may be reused for a different file.
+
+  @param[in] FileHandle  The opened file.
+  @param[in] FileName    Optional, the path FileHandle has been opened by.  If
+                         NULL, the association is removed.
+**/
+VOID
+MiscTraceFileHandle (
+  IN EFI_FILE_HANDLE  FileHandle,
+  IN CONST CHAR16     *FileName OPTIONAL
+  )
+{
+  UINTN      Index;
+  UINT16     PathId;
+  EFI_STATUS Status;
+
+  ASSERT (FileHandle != NULL);
+  ASSERT (!EfiAtRuntime ());
+
+  Index = InternalFindTraceHandle (FileHandle);
+
+  if (FileName == NULL) {
+    if (Index < mNumberOfMiscFileTraceHandles) {
+      --mNumberOfMiscFileTraceHandles;
+
+      mMiscFileTraceHandles[Index] =
+        mMiscFileTraceHandles[mNumberOfMiscFileTraceHandles];
+    }
+  } else if (mMiscFileTrace != NULL) {
+    PathId = InternalTraceFileOpen (FileName);
+
+    if (PathId != MISC_FILE_TRACE_MAX_PATHS) {
+      Status = EFI_SUCCESS;
+
+      if (Index == mNumberOfMiscFileTraceHandles) {
+        Status = InternalGrowBuffer (
+                   (VOID **)&mMiscFileTraceHandles,
+                   &mMiscFileTraceHandlesSize,
+                   ((Index + 1) * sizeof (*mMiscFileTraceHandles))
+                   );
+
+        if (!EFI_ERROR (Status)) {
+          ++mNumberOfMiscFileTraceHandles;
+        }
+      }
+
+      if (!EFI_ERROR (Status)) {
+        mMiscFileTraceHandles[Index].FileHandle = FileHandle;
+        mMiscFileTraceHandles[Index].PathId     = PathId;
+      }
+    }
+  }
+}
+
+// MiscStartFileTrace
+/** Starts recording the files opened and read by this library.
+
+  Every path-based load is recorded with its path, the range read and the
+  time it occurred at.  Ranged reads are recorded for the files associated by
+  MiscTraceFileHandle().  The trace is kept in memory until it is stopped by
+  MiscStopFileTrace().
+
+  The times are taken from TimerLib and are 0 if the platform binds a TimerLib
+  without a performance counter, e.g. BaseTimerLibNullTemplate.
+
+  @retval EFI_SUCCESS           Recording has been started.
+  @retval EFI_ALREADY_STARTED   A trace is being recorded already.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+**/
+EFI_STATUS
+MiscStartFileTrace (
+  VOID
+  )
+{
+  EFI_STATUS             Status;
+
+  MISC_FILE_TRACE_HEADER *Header;
+
+  ASSERT (!EfiAtRuntime ());
+
+  Status = EFI_ALREADY_STARTED;
+
+  if (mMiscFileTrace == NULL) {
+    mMiscFileTrace = AllocatePool (MISC_FILE_TRACE_INITIAL_SIZE);
+    Status         = EFI_OUT_OF_RESOURCES;
+
+    if (mMiscFileTrace != NULL) {
+      Header = (MISC_FILE_TRACE_HEADER *)mMiscFileTrace;
+
+      Header->Signature       = MISC_FILE_TRACE_SIGNATURE;
+      Header->Revision        = MISC_FILE_TRACE_REVISION;
+      Header->NumberOfRecords = 0;
+      Header->NumberOfPaths   = 0;
+
+      mMiscFileTraceBufferSize = MISC_FILE_TRACE_INITIAL_SIZE;
+      mMiscFileTraceSize       = sizeof (*Header);
+      mMiscFileTraceStartTime  = GetTimeInNanoSecond (GetPerformanceCounter ());
+
+      Status = EFI_SUCCESS;
+    }
+  }
+
+  return Status;
+}
+
+// MiscStopFileTrace
+/** Stops recording and saves the trace.
+
+  The trace file is replaced atomically, so an interrupted save keeps the
+  previous trace intact.
+
+  @param[in] Root      Optional, the volume's opened root.  If NULL, the trace
+                       is discarded.
+  @param[in] FileName  The path of the trace file to write.
+
+  @retval EFI_SUCCESS    The trace has been saved or discarded.
+  @retval EFI_NOT_READY  No trace is being recorded.
+  @retval other          The error returned by the file system.
+**/
+EFI_STATUS
+MiscStopFileTrace (
+  IN EFI_FILE_HANDLE  Root OPTIONAL,
+  IN CONST CHAR16     *FileName
+  )
+{
+  EFI_STATUS       Status;
+
+  UINT8            *Trace;
+  UINTN            TraceSize;
+  MISC_FILE_WRITER *Writer;
+
+  ASSERT ((Root == NULL) || (FileName != NULL));
+  ASSERT (!EfiAtRuntime ());
+
+  Status = EFI_NOT_READY;
+
+  if (mMiscFileTrace != NULL) {
+    // Stop first, so the save itself is not recorded.
+    Trace     = mMiscFileTrace;
+    TraceSize = mMiscFileTraceSize;
+
+    mMiscFileTrace           = NULL;
+    mMiscFileTraceBufferSize = 0;
+    mMiscFileTraceSize       = 0;
+
+    if (mMiscFileTracePaths != NULL) {
+      FreePool ((VOID *)mMiscFileTracePaths);
+
+      mMiscFileTracePaths     = NULL;
+      mMiscFileTracePathsSize = 0;
+    }
+
+    if (mMiscFileTraceHandles != NULL) {
+      FreePool ((VOID *)mMiscFileTraceHandles);
+
+      mMiscFileTraceHandles         = NULL;
+      mMiscFileTraceHandlesSize     = 0;
+      mNumberOfMiscFileTraceHandles = 0;
+    }
+
+    Status = EFI_SUCCESS;
+
+    if (Root != NULL) {
+      Status = MiscOpenFileWriter (
+                 Root,
+                 FileName,
+                 MiscFileWriterAtomicReplace,
+                 0,
+                 &Writer
+                 );
+
+      if (!EFI_ERROR (Status)) {
+        Status = MiscFileWriterWrite (Writer, (VOID *)Trace, TraceSize);
+
+        if (!EFI_ERROR (Status)) {
+          Status = MiscCloseFileWriter (Writer);
+        } else {
+          MiscDiscardFileWriter (Writer);
+        }
+      }
+    }
+
+    FreePool ((VOID *)Trace);
+  }
+
+  return Status;
+}
@@ -0,0 +1,377 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Guid/FileInfo.h>
+
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscFileLib.h>
+#include <Library/MiscRuntimeLib.h>
+
+#include "MiscFileLibInternal.h"
+
+// MISC_FILE_WALK_INITIAL_FRAMES
+#define MISC_FILE_WALK_INITIAL_FRAMES  8
+
+// MISC_FILE_WALK_INITIAL_PATH_LENGTH
+#define MISC_FILE_WALK_INITIAL_PATH_LENGTH  256
+
+// MISC_FILE_WALK_INITIAL_INFO_SIZE
+#define MISC_FILE_WALK_INITIAL_INFO_SIZE  \
+  (SIZE_OF_EFI_FILE_INFO + (MISC_FILE_WALK_INITIAL_PATH_LENGTH * sizeof (CHAR16)))
+
+// MISC_FILE_WALK_FRAME
+typedef struct {
+  EFI_FILE_HANDLE Handle;         ///< The directory being enumerated.
+  UINTN           PathLength;     ///< The length of the directory's path.
+  BOOLEAN         ReadComplete;   ///< All entries have been read.
+  UINTN           DeferredStart;  ///< The offset of the deferred entries.
+  UINTN           NextDeferred;   ///< The next deferred entry to handle.
+  UINTN           DeferredEnd;    ///< Valid once ReadComplete is set.
+} MISC_FILE_WALK_FRAME;
+
+// InternalIsDotEntry
+STATIC
+BOOLEAN
+InternalIsDotEntry (
+  IN CONST CHAR16  *FileName
+  )
+{
+  ASSERT (FileName != NULL);
+
+  return (BOOLEAN)((FileName[0] == L'.')
+               && ((FileName[1] == L'\0')
+                || ((FileName[1] == L'.') && (FileName[2] == L'\0'))));
+}
+
+// InternalGrowBuffer
+/** Grows a pool buffer to hold at least RequiredSize bytes.
+
+  @param[in, out] Buffer        The buffer to grow.  The content is preserved.
+  @param[in, out] BufferSize    On input, the current size of Buffer.  On
+                                output, its new size.
+  @param[in]      RequiredSize  The minimum size Buffer must have.
+
+  @retval EFI_SUCCESS           Buffer can hold RequiredSize bytes.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed, Buffer is untouched.
+**/
+EFI_STATUS
+InternalGrowBuffer (
+  IN OUT VOID   **Buffer,
+  IN OUT UINTN  *BufferSize,
+  IN     UINTN  RequiredSize
+  )
+{
+  EFI_STATUS Status;
+
+  UINTN      NewSize;
+  VOID       *NewBuffer;
+
+  ASSERT (Buffer != NULL);
+  ASSERT (BufferSize != NULL);
+
+  Status = EFI_SUCCESS;
+
+  if (RequiredSize > *BufferSize) {
+    NewSize   = MAX (RequiredSize, (*BufferSize * 2));
+    NewBuffer = ReallocatePool (*BufferSize, NewSize, *Buffer);
+
+    Status = EFI_OUT_OF_RESOURCES;
+
+    if (NewBuffer != NULL) {
+      *Buffer     = NewBuffer;
+      *BufferSize = NewSize;
+
+      Status = EFI_SUCCESS;
+    }
+  }
+
+  return Status;
+}
+
+// MiscWalkDirectory
+/** Recursively enumerates a directory tree without recursion.
+
+  The walk keeps one open handle per directory level on an explicit stack and
+  reads all entries into a single, growable EFI_FILE_INFO buffer.  The '.' and
+  '..' entries are skipped.  In the two-pass orders, every directory is read
+  once only.  The entries of the kind handled second are copied to a deferred
+  entry stack shared by all levels and handled once the directory has been
+  read completely.  Paths passed to the callbacks are relative to
+  DirHandle, do not start with FILE_PATH_SEPARATOR and, just as the
+  EFI_FILE_INFO, are only valid for the duration of the call.
+
+  @param[in] DirHandle  The directory to walk.  It is not closed.
+  @param[in] Options    The walk configuration.
+
+  @retval EFI_SUCCESS           The tree has been walked.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval other                 The error returned by the file system or by
+                                Options->Visit, which stops the walk.
+**/
+EFI_STATUS
+MiscWalkDirectory (
+  IN EFI_FILE_HANDLE               DirHandle,
+  IN CONST MISC_FILE_WALK_OPTIONS  *Options
+  )
+{
+  EFI_STATUS           Status;
+
+  MISC_FILE_WALK_FRAME *Frames;
+  UINTN                FramesSize;
+  UINTN                NumberOfFrames;
+  MISC_FILE_WALK_FRAME *Frame;
+  EFI_FILE_INFO        *FileInfo;
+  UINTN                FileInfoSize;
+  UINT8                *Deferred;
+  UINTN                DeferredSize;
+  UINTN                DeferredUsed;
+  UINTN                RecordSize;
+  EFI_FILE_INFO        *Entry;
+  UINTN                ReadSize;
+  CHAR16               *Path;
+  UINTN                PathSize;
+  UINTN                PathLength;
+  UINTN                NameLength;
+  UINTN                Depth;
+  BOOLEAN              IsDirectory;
+  EFI_FILE_HANDLE      ChildHandle;
+
+  ASSERT (DirHandle != NULL);
+  ASSERT (Options != NULL);
+  ASSERT (Options->Visit != NULL);
+  ASSERT ((Options->Order == MiscFileWalkDirectoryOrder)
+       || (Options->Order == MiscFileWalkDirectoriesFirst)
+       || (Options->Order == MiscFileWalkFilesFirst));
+
+  ASSERT (!EfiAtRuntime ());
+
+  FramesSize   = (MISC_FILE_WALK_INITIAL_FRAMES * sizeof (*Frames));
+  FileInfoSize = MISC_FILE_WALK_INITIAL_INFO_SIZE;
+  PathSize     = (MISC_FILE_WALK_INITIAL_PATH_LENGTH * sizeof (*Path));
+
+  Frames   = AllocatePool (FramesSize);
+  FileInfo = AllocatePool (FileInfoSize);
+  Path     = AllocatePool (PathSize);
+
+  Deferred     = NULL;
+  DeferredSize = 0;
+  DeferredUsed = 0;
+
+  Status         = EFI_OUT_OF_RESOURCES;
+  NumberOfFrames = 0;
+
+  if ((Frames != NULL) && (FileInfo != NULL) && (Path != NULL)) {
+    Status = DirHandle->SetPosition (DirHandle, 0);
+
+    if (!EFI_ERROR (Status)) {
+      Frames[0].Handle        = DirHandle;
+      Frames[0].PathLength    = 0;
+      Frames[0].ReadComplete  = FALSE;
+      Frames[0].DeferredStart = 0;
+      Frames[0].NextDeferred  = 0;
+
+      NumberOfFrames = 1;
+    }
+  }
+
+  while (NumberOfFrames > 0) {
+    Frame = &Frames[NumberOfFrames - 1];
+
+    if (Frame->ReadComplete) {
+      if (Frame->NextDeferred == Frame->DeferredEnd) {
+        if (NumberOfFrames > 1) {
+          Frame->Handle->Close (Frame->Handle);
+        }
+
+        DeferredUsed = Frame->DeferredStart;
+
+        --NumberOfFrames;
+
+        continue;
+      }
+
+      Entry                = (EFI_FILE_INFO *)&Deferred[Frame->NextDeferred];
+      Frame->NextDeferred += ALIGN_VALUE ((UINTN)Entry->Size, sizeof (UINT64));
+      IsDirectory          = FILE_INFO_IS_DIRECTORY (Entry);
+    } else {
+      ReadSize = FileInfoSize;
+      Status   = Frame->Handle->Read (Frame->Handle, &ReadSize, FileInfo);
+
+      if (Status == EFI_BUFFER_TOO_SMALL) {
+        // The position is not advanced, grow the buffer and read again.
+        FreePool ((VOID *)FileInfo);
+
+        FileInfo = AllocatePool (ReadSize);
+
+        if (FileInfo == NULL) {
+          Status = EFI_OUT_OF_RESOURCES;
+          break;
+        }
+
+        FileInfoSize = ReadSize;
+
+        continue;
+      }
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+
+      if (ReadSize == 0) {
+        Frame->ReadComplete = TRUE;
+        Frame->DeferredEnd  = DeferredUsed;
+
+        continue;
+      }
+
+      if (InternalIsDotEntry (FileInfo->FileName)) {
+        continue;
+      }
+
+      Entry       = FileInfo;
+      IsDirectory = FILE_INFO_IS_DIRECTORY (Entry);
+
+      // The two-pass orders defer the kind of entries handled second.  The
+      // record's Size is set to the size read to step to the next record.
+
+      if (((Options->Order == MiscFileWalkDirectoriesFirst) && !IsDirectory)
+       || ((Options->Order == MiscFileWalkFilesFirst) && IsDirectory)) {
+        RecordSize = ALIGN_VALUE (ReadSize, sizeof (UINT64));
+        Status     = InternalGrowBuffer (
+                       (VOID **)&Deferred,
+                       &DeferredSize,
+                       (DeferredUsed + RecordSize)
+                       );
+
+        if (EFI_ERROR (Status)) {
+          break;
+        }
+
+        Entry = (EFI_FILE_INFO *)&Deferred[DeferredUsed];
+
+        CopyMem ((VOID *)Entry, (VOID *)FileInfo, ReadSize);
+
+        Entry->Size   = ReadSize;
+        DeferredUsed += RecordSize;
+
+        continue;
+      }
+    }
+
+    PathLength = Frame->PathLength;
+    NameLength = StrLen (Entry->FileName);
+
+    Status = InternalGrowBuffer (
+               (VOID **)&Path,
+               &PathSize,
+               ((PathLength + 1 + NameLength + 1) * sizeof (*Path))
+               );
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    if (PathLength > 0) {
+      Path[PathLength] = FILE_PATH_SEPARATOR;
+      ++PathLength;
+    }
+
+    CopyMem (
+      (VOID *)&Path[PathLength],
+      (VOID *)Entry->FileName,
+      ((NameLength + 1) * sizeof (*Path))
+      );
+
+    PathLength += NameLength;
+    Depth       = (NumberOfFrames - 1);
+
+    if ((Options->Filter == NULL)
+     || Options->Filter (Options->Context, Path, Entry, Depth)) {
+      Status = Options->Visit (Options->Context, Path, Entry, Depth);
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+    }
+
+    if (IsDirectory
+     && (Depth < Options->MaxDepth)
+     && ((Options->Prune == NULL)
+      || !Options->Prune (Options->Context, Path, Entry, Depth))) {
+      Status = InternalGrowBuffer (
+                 (VOID **)&Frames,
+                 &FramesSize,
+                 ((NumberOfFrames + 1) * sizeof (*Frames))
+                 );
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+
+      Frame  = &Frames[NumberOfFrames - 1];
+      Status = Frame->Handle->Open (
+                                Frame->Handle,
+                                &ChildHandle,
+                                Entry->FileName,
+                                EFI_FILE_MODE_READ,
+                                0
+                                );
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+
+      Frames[NumberOfFrames].Handle        = ChildHandle;
+      Frames[NumberOfFrames].PathLength    = PathLength;
+      Frames[NumberOfFrames].ReadComplete  = FALSE;
+      Frames[NumberOfFrames].DeferredStart = DeferredUsed;
+      Frames[NumberOfFrames].NextDeferred  = DeferredUsed;
+
+      ++NumberOfFrames;
+    }
+  }
+
+  // Close all directories that have been left open by an error.
+  while (NumberOfFrames > 1) {
+    --NumberOfFrames;
+    Frames[NumberOfFrames].Handle->Close (Frames[NumberOfFrames].Handle);
+  }
+
+  if (Frames != NULL) {
+    FreePool ((VOID *)Frames);
+  }
+
+  if (FileInfo != NULL) {
+    FreePool ((VOID *)FileInfo);
+  }
+
+  if (Deferred != NULL) {
+    FreePool ((VOID *)Deferred);
+  }
+
+  if (Path != NULL) {
+    FreePool ((VOID *)Path);
+  }
+
+  return Status;
+}
@@ -0,0 +1,534 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Guid/FileInfo.h>
+
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/FileHandleLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscFileLib.h>
+#include <Library/MiscRuntimeLib.h>
+
+#include "MiscFileLibInternal.h"
+
+// MISC_FILE_WRITER_DEFAULT_BUFFER_SIZE
+#define MISC_FILE_WRITER_DEFAULT_BUFFER_SIZE  SIZE_64KB
+
+// MISC_FILE_WRITER_TEMP_SUFFIX
+#define MISC_FILE_WRITER_TEMP_SUFFIX  L".tmp"
+
+// MISC_FILE_WRITER
+struct MISC_FILE_WRITER {
+  EFI_FILE_HANDLE       Root;
+  EFI_FILE_HANDLE       FileHandle;  ///< The file written to.
+  MISC_FILE_WRITER_MODE Mode;
+  UINT64                Position;    ///< The file position of Buffer[0].
+  UINTN                 BufferSize;
+  UINTN                 DataSize;    ///< The number of bytes buffered.
+  UINT8                 *Buffer;
+  CHAR16                *FileName;   ///< The final file's path.
+  CHAR16                *TempName;   ///< The temporary file's path.
+};
+
+// InternalWriterLimit
+/** Returns how many bytes may be buffered before the buffer is written.
+
+  The limit ends the buffer at the next multiple of BufferSize in the file,
+  so all writes but the first and the last are aligned and of equal size.
+**/
+STATIC
+UINTN
+InternalWriterLimit (
+  IN CONST MISC_FILE_WRITER  *Writer
+  )
+{
+  UINT32 Remainder;
+
+  DivU64x32Remainder (Writer->Position, (UINT32)Writer->BufferSize, &Remainder);
+
+  return (Writer->BufferSize - Remainder);
+}
+
+// InternalWriterWrite
+/** Writes data to the file at the writer's position.
+
+  @retval EFI_SUCCESS  All data has been written.
+  @retval other        The error returned by the file system.
+**/
+STATIC
+EFI_STATUS
+InternalWriterWrite (
+  IN OUT MISC_FILE_WRITER  *Writer,
+  IN     CONST VOID        *Data,
+  IN     UINTN             DataSize
+  )
+{
+  EFI_STATUS Status;
+
+  UINTN      WriteSize;
+
+  WriteSize = DataSize;
+  Status    = Writer->FileHandle->Write (
+                                    Writer->FileHandle,
+                                    &WriteSize,
+                                    (VOID *)Data
+                                    );
+
+  if (!EFI_ERROR (Status)) {
+    Writer->Position += WriteSize;
+
+    if (WriteSize != DataSize) {
+      Status = EFI_VOLUME_FULL;
+    }
+  }
+
+  return Status;
+}
+
+// InternalOpenForWrite
+/** Opens or creates a file for writing and truncates it.
+
+  @param[in]  Root        The volume's opened root.
+  @param[in]  FileName    The path of the file to open.
+  @param[in]  Truncate    Whether to truncate the file.
+  @param[out] FileHandle  The opened file.
+
+  @return  Returned is the status of the file system.
+**/
+STATIC
+EFI_STATUS
+InternalOpenForWrite (
+  IN  EFI_FILE_HANDLE  Root,
+  IN  CHAR16           *FileName,
+  IN  BOOLEAN          Truncate,
+  OUT EFI_FILE_HANDLE  *FileHandle
+  )
+{
+  EFI_STATUS Status;
+
+  Status = Root->Open (
+                   Root,
+                   FileHandle,
+                   FileName,
+                   (EFI_FILE_MODE_READ
+                     | EFI_FILE_MODE_WRITE
+                     | EFI_FILE_MODE_CREATE),
+                   0
+                   );
+
+  if (!EFI_ERROR (Status) && Truncate) {
+    Status = FileHandleSetSize (*FileHandle, 0);
+
+    if (EFI_ERROR (Status)) {
+      FileHandleClose (*FileHandle);
+    }
+  }
+
+  return Status;
+}
+
+// MiscOpenFileWriter
+/** Opens a file for buffered writing.
+
+  Small writes are coalesced in a buffer of BufferSize bytes, which is written
+  once it reaches the next multiple of BufferSize in the file.  Hence the file
+  system mostly sees large, aligned writes.
+
+  In MiscFileWriterAtomicReplace mode, the data is written to FileName with
+  MISC_FILE_WRITER_TEMP_SUFFIX appended, which replaces FileName only once
+  MiscCloseFileWriter() succeeds.  FAT cannot rename over an existing file,
+  so FileName is deleted right before the temporary file is renamed.  If this
+  is interrupted, the complete data remains in the temporary file.
+
+  @param[in]  Root        The volume's opened root.
+  @param[in]  FileName    The path of the file to write.
+  @param[in]  Mode        How to treat existing data.
+  @param[in]  BufferSize  The size of the write buffer, 0 for the default.
+  @param[out] Writer      The opened writer.
+
+  @retval EFI_SUCCESS           The file has been opened.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval other                 The error returned by the file system.
+**/
+EFI_STATUS
+MiscOpenFileWriter (
+  IN  EFI_FILE_HANDLE        Root,
+  IN  CONST CHAR16           *FileName,
+  IN  MISC_FILE_WRITER_MODE  Mode,
+  IN  UINTN                  BufferSize,
+  OUT MISC_FILE_WRITER       **Writer
+  )
+{
+  EFI_STATUS       Status;
+
+  MISC_FILE_WRITER *NewWriter;
+  UINTN            NameSize;
+  UINTN            TempNameSize;
+
+  ASSERT (Root != NULL);
+  ASSERT (FileName != NULL);
+  ASSERT (FileName[0] != L'\0');
+  ASSERT ((Mode == MiscFileWriterTruncate)
+       || (Mode == MiscFileWriterAppend)
+       || (Mode == MiscFileWriterAtomicReplace));
+  ASSERT (BufferSize <= MAX_UINT32);
+  ASSERT (Writer != NULL);
+  ASSERT (!EfiAtRuntime ());
+
+  if (BufferSize == 0) {
+    BufferSize = MISC_FILE_WRITER_DEFAULT_BUFFER_SIZE;
+  }
+
+  NameSize     = StrSize (FileName);
+  TempNameSize = 0;
+
+  if (Mode == MiscFileWriterAtomicReplace) {
+    TempNameSize = (NameSize + sizeof (MISC_FILE_WRITER_TEMP_SUFFIX)
+                      - sizeof (CHAR16));
+  }
+
+  NewWriter = AllocateZeroPool (
+                sizeof (*NewWriter) + NameSize + TempNameSize + BufferSize
+                );
+
+  Status = EFI_OUT_OF_RESOURCES;
+
+  if (NewWriter != NULL) {
+    NewWriter->Root       = Root;
+    NewWriter->Mode       = Mode;
+    NewWriter->BufferSize = BufferSize;
+    NewWriter->FileName   = (CHAR16 *)(NewWriter + 1);
+    NewWriter->Buffer     = ((UINT8 *)NewWriter->FileName
+                              + NameSize
+                              + TempNameSize);
+
+    CopyMem ((VOID *)NewWriter->FileName, (VOID *)FileName, NameSize);
+
+    if (Mode == MiscFileWriterAtomicReplace) {
+      NewWriter->TempName = (CHAR16 *)((UINT8 *)NewWriter->FileName + NameSize);
+
+      CopyMem ((VOID *)NewWriter->TempName, (VOID *)FileName, NameSize);
+      StrCatS (
+        NewWriter->TempName,
+        (TempNameSize / sizeof (CHAR16)),
+        MISC_FILE_WRITER_TEMP_SUFFIX
+        );
+    }
+
+    Status = InternalOpenForWrite (
+               Root,
+               ((NewWriter->TempName != NULL)
+                 ? NewWriter->TempName
+                 : NewWriter->FileName),
+               (BOOLEAN)(Mode != MiscFileWriterAppend),
+               &NewWriter->FileHandle
+               );
+
+    if (!EFI_ERROR (Status) && (Mode == MiscFileWriterAppend)) {
+      Status = FileHandleSetPosition (NewWriter->FileHandle, MAX_UINT64);
+
+      if (!EFI_ERROR (Status)) {
+        Status = FileHandleGetPosition (
+                   NewWriter->FileHandle,
+                   &NewWriter->Position
+                   );
+      }
+
+      if (EFI_ERROR (Status)) {
+        FileHandleClose (NewWriter->FileHandle);
+      }
+    }
+
+    if (!EFI_ERROR (Status)) {
+      *Writer = NewWriter;
+    } else {
+      FreePool ((VOID *)NewWriter);
+    }
+  }
+
+  return Status;
+}
+
+// MiscFileWriterWrite
+/** Appends data to a buffered file.
+
+  Data that completes the buffer up to the next aligned file position is
+  written out, whole aligned blocks are written without being copied.
+
+  @param[in, out] Writer    The writer to append to.
+  @param[in]      Data      The data to append.
+  @param[in]      DataSize  The size, in bytes, of Data.
+
+  @retval EFI_SUCCESS  The data has been buffered or written.
+  @retval other        The error returned by the file system.
+**/
+EFI_STATUS
+MiscFileWriterWrite (
+  IN OUT MISC_FILE_WRITER  *Writer,
+  IN     CONST VOID        *Data,
+  IN     UINTN             DataSize
+  )
+{
+  EFI_STATUS  Status;
+
+  CONST UINT8 *Bytes;
+  UINTN       Limit;
+  UINTN       CopySize;
+
+  ASSERT (Writer != NULL);
+  ASSERT ((Data != NULL) || (DataSize == 0));
+  ASSERT (!EfiAtRuntime ());
+
+  Status = EFI_SUCCESS;
+  Bytes  = (CONST UINT8 *)Data;
+
+  while (DataSize > 0) {
+    Limit = InternalWriterLimit (Writer);
+
+    if ((Writer->DataSize == 0) && (DataSize >= Limit)) {
+      // Nothing is buffered, write straight up to the aligned position.
+      CopySize = (DataSize - ((DataSize - Limit) % Writer->BufferSize));
+      Status   = InternalWriterWrite (Writer, Bytes, CopySize);
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+    } else {
+      CopySize = MIN (DataSize, (Limit - Writer->DataSize));
+
+      CopyMem (
+        (VOID *)&Writer->Buffer[Writer->DataSize],
+        (VOID *)Bytes,
+        CopySize
+        );
+
+      Writer->DataSize += CopySize;
+
+      if (Writer->DataSize == Limit) {
+        Status = MiscFileWriterFlush (Writer);
+
+        if (EFI_ERROR (Status)) {
+          break;
+        }
+      }
+    }
+
+    Bytes    += CopySize;
+    DataSize -= CopySize;
+  }
+
+  return Status;
+}
+
+// MiscFileWriterFlush
+/** Writes all buffered data to the file.
+
+  @param[in, out] Writer  The writer to flush.
+
+  @retval EFI_SUCCESS  The buffer has been written.
+  @retval other        The error returned by the file system.
+**/
+EFI_STATUS
+MiscFileWriterFlush (
+  IN OUT MISC_FILE_WRITER  *Writer
+  )
+{
+  EFI_STATUS Status;
+
+  ASSERT (Writer != NULL);
+  ASSERT (!EfiAtRuntime ());
+
+  Status = EFI_SUCCESS;
+
+  if (Writer->DataSize > 0) {
+    Status = InternalWriterWrite (Writer, Writer->Buffer, Writer->DataSize);
+
+    if (!EFI_ERROR (Status)) {
+      Writer->DataSize = 0;
+    }
+  }
+
+  return Status;
+}
+
+// InternalCommitTempFile
+/** Replaces the writer's file by its temporary file.
+
+  The new file information is prepared before the original file is deleted,
+  so that only the rename itself can fail afterwards.
+
+  @param[in, out] Writer           The writer whose temporary file is complete.
+  @param[out]     OriginalDeleted  Whether the original file has been deleted.
+
+  @return  Returned is the status of the file system.
+**/
+STATIC
+EFI_STATUS
+InternalCommitTempFile (
+  IN OUT MISC_FILE_WRITER  *Writer,
+  OUT    BOOLEAN           *OriginalDeleted
+  )
+{
+  EFI_STATUS                Status;
+
+  EFI_FILE_HANDLE           FileHandle;
+  EFI_FILE_INFO             *FileInfo;
+  EFI_FILE_INFO             *NewInfo;
+  MISC_FILE_PATH_COMPONENTS Components;
+  UINTN                     NewInfoSize;
+
+  ASSERT (OriginalDeleted != NULL);
+
+  *OriginalDeleted = FALSE;
+
+  FileInfo = FileHandleGetInfo (Writer->FileHandle);
+  Status   = EFI_OUT_OF_RESOURCES;
+
+  if (FileInfo != NULL) {
+    // Renaming within the same directory only requires the new name.
+    MiscSplitFilePath (
+      Writer->FileName,
+      StrLen (Writer->FileName),
+      &Components
+      );
+
+    NewInfoSize = (SIZE_OF_EFI_FILE_INFO
+                    + ((Components.NameLength + 1) * sizeof (CHAR16)));
+
+    NewInfo = AllocatePool (NewInfoSize);
+
+    if (NewInfo != NULL) {
+      CopyMem ((VOID *)NewInfo, (VOID *)FileInfo, SIZE_OF_EFI_FILE_INFO);
+      CopyMem (
+        (VOID *)NewInfo->FileName,
+        (VOID *)Components.Name,
+        ((Components.NameLength + 1) * sizeof (CHAR16))
+        );
+
+      NewInfo->Size = NewInfoSize;
+
+      Status = Writer->Root->Open (
+                               Writer->Root,
+                               &FileHandle,
+                               Writer->FileName,
+                               (EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE),
+                               0
+                               );
+
+      if (!EFI_ERROR (Status)) {
+        // Delete() closes the handle, even on failure.
+        Status = FileHandleDelete (FileHandle);
+
+        *OriginalDeleted = (BOOLEAN)!EFI_ERROR (Status);
+      } else if (Status == EFI_NOT_FOUND) {
+        Status = EFI_SUCCESS;
+      }
+
+      if (!EFI_ERROR (Status)) {
+        Status = FileHandleSetInfo (Writer->FileHandle, NewInfo);
+      }
+
+      FreePool ((VOID *)NewInfo);
+    }
+
+    FreePool ((VOID *)FileInfo);
+  }
+
+  return Status;
+}
+
+// MiscCloseFileWriter
+/** Flushes and closes a writer.
+
+  In MiscFileWriterAtomicReplace mode, the written file replaces the original
+  one.  If this fails while the original file still exists, the temporary
+  file is deleted, so no partial file is left behind.  If the rename fails
+  after the original file has been deleted, the temporary file is kept, as it
+  then holds the only copy of the data.  The writer is freed even on failure.
+
+  @param[in] Writer  The writer to close.
+
+  @retval EFI_SUCCESS  All data has been written and committed.
+  @retval other        The error returned by the file system.
+**/
+EFI_STATUS
+MiscCloseFileWriter (
+  IN MISC_FILE_WRITER  *Writer
+  )
+{
+  EFI_STATUS Status;
+
+  BOOLEAN    OriginalDeleted;
+
+  ASSERT (Writer != NULL);
+  ASSERT (!EfiAtRuntime ());
+
+  OriginalDeleted = FALSE;
+
+  Status = MiscFileWriterFlush (Writer);
+
+  if (!EFI_ERROR (Status)) {
+    Status = FileHandleFlush (Writer->FileHandle);
+  }
+
+  if (!EFI_ERROR (Status) && (Writer->Mode == MiscFileWriterAtomicReplace)) {
+    Status = InternalCommitTempFile (Writer, &OriginalDeleted);
+  }
+
+  if (EFI_ERROR (Status)
+   && (Writer->Mode == MiscFileWriterAtomicReplace)
+   && !OriginalDeleted) {
+    // Delete() closes the handle, even on failure.
+    FileHandleDelete (Writer->FileHandle);
+  } else {
+    FileHandleClose (Writer->FileHandle);
+  }
+
+  FreePool ((VOID *)Writer);
+
+  return Status;
+}
+
+// MiscDiscardFileWriter
+/** Closes a writer without committing its data.
+
+  In MiscFileWriterAtomicReplace mode, the temporary file is deleted and the
+  original file is left untouched.  Otherwise, buffered data is dropped.
+
+  @param[in] Writer  The writer to discard.
+**/
+VOID
+MiscDiscardFileWriter (
+  IN MISC_FILE_WRITER  *Writer
+  )
+{
+  ASSERT (Writer != NULL);
+  ASSERT (!EfiAtRuntime ());
+
+  if (Writer->Mode == MiscFileWriterAtomicReplace) {
+    FileHandleDelete (Writer->FileHandle);
+  } else {
+    FileHandleClose (Writer->FileHandle);
+  }
+
+  FreePool ((VOID *)Writer);
+}
@@ -27,9 +27,7 @@
 #include <Library/MiscFileLib.h>
 #include <Library/MiscRuntimeLib.h>
 
-// FILE_INFO_IS_DIRECTORY
-#define FILE_INFO_IS_DIRECTORY(DirInfo)  \
-  (((DirInfo)->Attribute & EFI_FILE_DIRECTORY) != 0)
+#include "MiscFileLibInternal.h"
 
 // FileExists
 /** Checks whether the given file exists or not.
@@ -73,6 +71,15 @@ FileExists (
 }
 
 // LoadFile
+/** Loads a file into memory.
+
+  @param[in]  Root        The volume's opened root.
+  @param[in]  FileName    The path of the file to load.
+  @param[out] BufferSize  The size, in bytes, of the loaded file.
+  @param[out] Buffer      The loaded file.  Free with FreePool().
+
+  @return  Returned is the status of the operation.
+**/
 EFI_STATUS
 LoadFile (
   IN  EFI_FILE_HANDLE  Root,
@@ -81,59 +88,7 @@ LoadFile (
   OUT VOID             **Buffer
   )
 {
-  EFI_STATUS      Status;
-
-  EFI_FILE_HANDLE FileHandle;
-  UINT64          ReadSize;
-  UINTN           FileDataSize;
-  VOID            *FileData;
-
-  ASSERT (Root != NULL);
-  ASSERT (FileName != NULL);
-  ASSERT (FileName[0] != L'\0');
-  ASSERT (BufferSize != NULL);
-  ASSERT (Buffer != NULL);
-  ASSERT (!EfiAtRuntime ());
-
-  Status = Root->Open (Root, &FileHandle, FileName, EFI_FILE_MODE_READ, 0);
-
-  if ((Status != EFI_NOT_FOUND)
-   && (Status != EFI_NO_MEDIA)
-   && (Status != EFI_MEDIA_CHANGED)) {
-    ASSERT_EFI_ERROR (Status);
-  }
-
-  if (!EFI_ERROR (Status)) {
-    Status = FileHandleGetSize (FileHandle, &ReadSize);
-
-    if (!EFI_ERROR (Status)) {
-      if (sizeof (FileDataSize) < sizeof (ReadSize)) {
-        FileDataSize = (UINTN)MIN (ReadSize, MAX_UINTN);
-      } else {
-        FileDataSize = (UINTN)ReadSize;
-      }
-
-      FileData = AllocatePool (FileDataSize);
-      Status   = EFI_OUT_OF_RESOURCES;
-
-      if (FileData != NULL) {
-        Status = FileHandleRead (FileHandle, &FileDataSize, FileData);
-
-        if (!EFI_ERROR (Status)) {
-          *BufferSize = FileDataSize;
-          *Buffer     = FileData;
-
-          Status = EFI_SUCCESS;
-        } else {
-          FreePool (FileData);
-        }
-      }
-    }
-
-    FileHandleClose (FileHandle);
-  }
-
-  return Status;
+  return LoadFileWithDigests (Root, FileName, 0, NULL, BufferSize, Buffer);
 }
 
 // GetFileExtension
@@ -142,18 +97,14 @@ GetFileExtension (
   IN CHAR16  *FileName
   )
 {
-  CHAR16 *Extension;
+  MISC_FILE_PATH_COMPONENTS Components;
 
   ASSERT (FileName != NULL);
   ASSERT (FileName[0] != L'\0');
 
-  Extension = StrStr (FileName, L".");
+  MiscSplitFilePath (FileName, StrLen (FileName), &Components);
 
-  if (Extension != NULL) {
-    ++Extension;
-  }
-
-  return Extension;
+  return (CHAR16 *)Components.Extensions;
 }
 
 // GetFilePrimaryExtension
@@ -162,22 +113,14 @@ GetFilePrimaryExtension (
   IN CHAR16  *FileName
   )
 {
-  CHAR16 *Extension;
-
-  CHAR16 *NextExtension;
+  MISC_FILE_PATH_COMPONENTS Components;
 
   ASSERT (FileName != NULL);
   ASSERT (FileName[0] != L'\0');
 
-  Extension     = NULL;
-  NextExtension = GetFileExtension (FileName);
+  MiscSplitFilePath (FileName, StrLen (FileName), &Components);
 
-  while (NextExtension != NULL) {
-    Extension     = NextExtension;
-    NextExtension = GetFileExtension (Extension);
-  }
-
-  return Extension;
+  return (CHAR16 *)Components.LastExtension;
 }
 
 // InternalCompareExtension
@@ -189,18 +132,25 @@ InternalCompareExtension (
   IN BOOLEAN  PrimaryExtension
   )
 {
-  CHAR16 *CurrentExtension;
+  MISC_FILE_PATH_COMPONENTS Components;
+  CONST CHAR16              *CurrentExtension;
 
   ASSERT (FileName != NULL);
   ASSERT (FileName[0] != L'\0');
   ASSERT (Extension != NULL);
   ASSERT (Extension[0] != L'\0');
 
+  MiscSplitFilePath (FileName, StrLen (FileName), &Components);
+
   CurrentExtension = (PrimaryExtension
-                       ? GetFilePrimaryExtension (FileName)
-                       : GetFileExtension (FileName));
+                       ? Components.LastExtension
+                       : Components.Extensions);
 
-  return StrCmp (CurrentExtension, Extension);
+  if (CurrentExtension == NULL) {
+    return -1;
+  }
+
+  return MiscFileStriCmp (CurrentExtension, Extension);
 }
 
 // FindNextFileByExtension
@@ -423,6 +373,147 @@ FindFirstDirectoryByExtension (
   return Status;
 }
 
+// MISC_FILE_INFORMATION_DEFAULT_SIZE
+/// Fits the information of most files without a retry.
+#define MISC_FILE_INFORMATION_DEFAULT_SIZE  \
+  (SIZE_OF_EFI_FILE_INFO + (64 * sizeof (CHAR16)))
+
+// MiscGetFileInformationEx
+/** Retrieves file information into a reusable pool buffer.
+
+  The information is queried once and is only queried again if the buffer
+  has been too small, in which case it is replaced by one of the size
+  reported.  Reusing the buffer across calls avoids both the size probe and
+  the pool traffic of MiscGetFileInformation().
+
+  @param[in]      FileHandle       The file to query.
+  @param[in]      InformationType  The type of information to retrieve.
+  @param[in]      SizeHint         The size to allocate if *Buffer is NULL.
+                                   0 selects a size fitting most file
+                                   information.
+  @param[in, out] Buffer           A pool buffer or NULL.  Receives the
+                                   information.  Free with FreePool().
+  @param[in, out] BufferSize       The size, in bytes, of *Buffer.
+
+  @retval EFI_SUCCESS           The information has been retrieved.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+  @retval other                 The error returned by the file system.
+**/
+EFI_STATUS
+MiscGetFileInformationEx (
+  IN     EFI_FILE_HANDLE  FileHandle,
+  IN     EFI_GUID         *InformationType,
+  IN     UINTN            SizeHint,
+  IN OUT VOID             **Buffer,
+  IN OUT UINTN            *BufferSize
+  )
+{
+  EFI_STATUS Status;
+
+  UINTN      Size;
+
+  ASSERT (FileHandle != NULL);
+  ASSERT (InformationType != NULL);
+  ASSERT (Buffer != NULL);
+  ASSERT (BufferSize != NULL);
+  ASSERT ((*Buffer != NULL) || (*BufferSize == 0));
+  ASSERT (!EfiAtRuntime ());
+
+  Status = EFI_SUCCESS;
+
+  if (*Buffer == NULL) {
+    if (SizeHint == 0) {
+      SizeHint = MISC_FILE_INFORMATION_DEFAULT_SIZE;
+    }
+
+    *Buffer     = AllocatePool (SizeHint);
+    *BufferSize = SizeHint;
+
+    if (*Buffer == NULL) {
+      *BufferSize = 0;
+
+      Status = EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Size   = *BufferSize;
+    Status = FileHandle->GetInfo (FileHandle, InformationType, &Size, *Buffer);
+
+    if (Status == EFI_BUFFER_TOO_SMALL) {
+      // The content need not be preserved, so avoid ReallocatePool's copy.
+      FreePool (*Buffer);
+
+      *Buffer     = AllocatePool (Size);
+      *BufferSize = Size;
+      Status      = EFI_OUT_OF_RESOURCES;
+
+      if (*Buffer != NULL) {
+        Status = FileHandle->GetInfo (
+                               FileHandle,
+                               InformationType,
+                               &Size,
+                               *Buffer
+                               );
+      } else {
+        *BufferSize = 0;
+      }
+    }
+  }
+
+  return Status;
+}
+
+// MiscGetFileInformationBatch
+/** Retrieves multiple types of information of one file, e.g. its FileInfo,
+    FileSystemInfo and VolumeLabel, reusing each request's buffer.
+
+  @param[in]      FileHandle        The file to query.
+  @param[in]      NumberOfRequests  The number of elements in Requests.
+  @param[in, out] Requests          The information to retrieve.  Buffer and
+                                    BufferSize are handled as by
+                                    MiscGetFileInformationEx().  Status
+                                    receives each request's result.
+
+  @retval EFI_SUCCESS  All information has been retrieved.
+  @retval other        The first error returned for a request.  All requests
+                       are processed regardless.
+**/
+EFI_STATUS
+MiscGetFileInformationBatch (
+  IN     EFI_FILE_HANDLE                FileHandle,
+  IN     UINTN                          NumberOfRequests,
+  IN OUT MISC_FILE_INFORMATION_REQUEST  *Requests
+  )
+{
+  EFI_STATUS                    Status;
+
+  UINTN                         Index;
+  MISC_FILE_INFORMATION_REQUEST *Request;
+
+  ASSERT (FileHandle != NULL);
+  ASSERT ((NumberOfRequests == 0) || (Requests != NULL));
+
+  Status = EFI_SUCCESS;
+
+  for (Index = 0; Index < NumberOfRequests; ++Index) {
+    Request         = &Requests[Index];
+    Request->Status = MiscGetFileInformationEx (
+                        FileHandle,
+                        Request->InformationType,
+                        0,
+                        &Request->Buffer,
+                        &Request->BufferSize
+                        );
+
+    if (!EFI_ERROR (Status)) {
+      Status = Request->Status;
+    }
+  }
+
+  return Status;
+}
+
 // MiscGetFileInformation
 VOID *
 MiscGetFileInformation (
@@ -438,28 +529,20 @@ MiscGetFileInformation (
   ASSERT (Root != NULL);
 
   Buffer = NULL;
+  Size   = 0;
 
-  Status = Root->GetInfo (Root, InformationType, &Size, NULL);
-
-  ASSERT (Status == EFI_BUFFER_TOO_SMALL);
-
-  if (Status == EFI_BUFFER_TOO_SMALL) {
-    Buffer = AllocatePool (Size);
+  Status = MiscGetFileInformationEx (
+             Root,
+             InformationType,
+             0,
+             &Buffer,
+             &Size
+             );
 
-    if (Buffer != NULL) {
-      Status = Root->GetInfo (
-                       Root,
-                       InformationType,
-                       &Size,
-                       Buffer
-                       );
+  if (EFI_ERROR (Status) && (Buffer != NULL)) {
+    FreePool (Buffer);
 
-      if (EFI_ERROR (Status)) {
-        FreePool (Buffer);
-
-        Buffer = NULL;
-      }
-    }
+    Buffer = NULL;
   }
 
   return Buffer;
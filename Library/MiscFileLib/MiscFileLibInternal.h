@@ -0,0 +1,73 @@
+/** @file
+  Copyright (C) 2015 - 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#ifndef MISC_FILE_LIB_INTERNAL_H_
+#define MISC_FILE_LIB_INTERNAL_H_
+
+// FILE_INFO_IS_DIRECTORY
+#define FILE_INFO_IS_DIRECTORY(DirInfo)  \
+  (((DirInfo)->Attribute & EFI_FILE_DIRECTORY) != 0)
+
+// gMiscFileAsciiUpperCaseMap
+extern CONST UINT8 gMiscFileAsciiUpperCaseMap[128];
+
+// MISC_FILE_CHAR_TO_UPPER
+/// Upper-cases ASCII characters by table lookup, others are returned as-is.
+#define MISC_FILE_CHAR_TO_UPPER(Char)                      \
+  (((Char) < ARRAY_SIZE (gMiscFileAsciiUpperCaseMap))      \
+    ? (CHAR16)gMiscFileAsciiUpperCaseMap[(Char)]           \
+    : (CHAR16)(Char))
+
+// InternalGrowBuffer
+EFI_STATUS
+InternalGrowBuffer (
+  IN OUT VOID   **Buffer,
+  IN OUT UINTN  *BufferSize,
+  IN     UINTN  RequiredSize
+  );
+
+// InternalTraceFileOpen
+UINT16
+InternalTraceFileOpen (
+  IN CONST CHAR16  *FileName
+  );
+
+// InternalTraceFileRead
+VOID
+InternalTraceFileRead (
+  IN UINT16  PathId,
+  IN UINT64  Offset,
+  IN UINTN   Size
+  );
+
+// InternalTraceFileHandleRead
+VOID
+InternalTraceFileHandleRead (
+  IN EFI_FILE_HANDLE  FileHandle,
+  IN UINT64           Offset,
+  IN UINTN            Size
+  );
+
+// InternalTakePrefetchedFile
+EFI_STATUS
+InternalTakePrefetchedFile (
+  IN  EFI_FILE_HANDLE  Root,
+  IN  CONST CHAR16     *FileName,
+  OUT UINTN            *BufferSize,
+  OUT VOID             **Buffer
+  );
+
+#endif // MISC_FILE_LIB_INTERNAL_H_
@@ -0,0 +1,1125 @@
+/** @file
+  Host-side test of the FAT extent resolver.
+
+  Runs MiscGetFileExtents() and MiscLoadFileByExtents() on a FAT image through
+  mock Disk I/O and Block I/O protocols and compares the results with a host
+  copy of the files stored in the image.  The mock file system serves the host
+  copy, so every fall back to LoadFile() is counted.
+
+  Usage: FatExtentHostTest <Image> <Tree> <Path>...
+
+  Image is the FAT image, Tree the host directory its files have been copied
+  from and every Path a file of the image, with backslash separators.
+
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <ctype.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+
+#include <Uefi.h>
+
+#include <IndustryStandard/MiscFileTrace.h>
+
+#include <Guid/FileInfo.h>
+
+#include <Protocol/BlockIo.h>
+#include <Protocol/DiskIo.h>
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/EfiBootServicesLib.h>
+#include <Library/FileHandleLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscFileLib.h>
+#include <Library/MiscRuntimeLib.h>
+
+#include "../MiscFileLibInternal.h"
+
+// HOST_PATH_SIZE
+#define HOST_PATH_SIZE  1024
+
+// HOST_FILE
+typedef struct {
+  EFI_FILE_PROTOCOL Protocol;
+  char              Path[HOST_PATH_SIZE];
+} HOST_FILE;
+
+// HOST_FAT_GEOMETRY
+typedef struct {
+  UINT64 FatOffset;
+  UINT64 FatSize;
+  UINT32 NumberOfFats;
+  UINT64 DataOffset;
+  UINT32 BytesPerCluster;
+  UINT32 FatBits;
+} HOST_FAT_GEOMETRY;
+
+EFI_GUID gEfiBlockIoProtocolGuid = EFI_BLOCK_IO_PROTOCOL_GUID;
+EFI_GUID gEfiDiskIoProtocolGuid  = EFI_DISK_IO_PROTOCOL_GUID;
+EFI_GUID gEfiFileInfoGuid        = EFI_FILE_INFO_ID;
+
+STATIC UINT8                 *mImage            = NULL;
+STATIC UINT64                mImageSize         = 0;
+STATIC const char            *mTree             = NULL;
+STATIC UINTN                 mNumberOfFallbacks = 0;
+STATIC UINTN                 mNumberOfFailures  = 0;
+STATIC EFI_BLOCK_IO_MEDIA    mMedia;
+STATIC EFI_BLOCK_IO_PROTOCOL mBlockIo;
+STATIC EFI_DISK_IO_PROTOCOL  mDiskIo;
+
+// Library Functions Used by the Code Under Test
+
+VOID *
+EFIAPI
+AllocatePool (
+  IN UINTN  AllocationSize
+  )
+{
+  return malloc ((AllocationSize > 0) ? AllocationSize : 1);
+}
+
+VOID *
+EFIAPI
+AllocateZeroPool (
+  IN UINTN  AllocationSize
+  )
+{
+  return calloc (1, ((AllocationSize > 0) ? AllocationSize : 1));
+}
+
+VOID
+EFIAPI
+FreePool (
+  IN VOID  *Buffer
+  )
+{
+  free (Buffer);
+}
+
+VOID *
+EFIAPI
+CopyMem (
+  OUT VOID       *DestinationBuffer,
+  IN  CONST VOID *SourceBuffer,
+  IN  UINTN      Length
+  )
+{
+  return memmove (DestinationBuffer, SourceBuffer, Length);
+}
+
+VOID *
+EFIAPI
+ZeroMem (
+  OUT VOID  *Buffer,
+  IN  UINTN Length
+  )
+{
+  return memset (Buffer, 0, Length);
+}
+
+UINT64
+EFIAPI
+MultU64x32 (
+  IN UINT64  Multiplicand,
+  IN UINT32  Multiplier
+  )
+{
+  return (Multiplicand * Multiplier);
+}
+
+UINT64
+EFIAPI
+DivU64x32 (
+  IN UINT64  Dividend,
+  IN UINT32  Divisor
+  )
+{
+  return (Dividend / Divisor);
+}
+
+UINT64
+EFIAPI
+DivU64x32Remainder (
+  IN  UINT64  Dividend,
+  IN  UINT32  Divisor,
+  OUT UINT32  *Remainder OPTIONAL
+  )
+{
+  if (Remainder != NULL) {
+    *Remainder = (UINT32)(Dividend % Divisor);
+  }
+
+  return (Dividend / Divisor);
+}
+
+UINT16
+EFIAPI
+ReadUnaligned16 (
+  IN CONST UINT16  *Buffer
+  )
+{
+  UINT16 Value;
+
+  memcpy (&Value, Buffer, sizeof (Value));
+
+  return Value;
+}
+
+UINT32
+EFIAPI
+ReadUnaligned32 (
+  IN CONST UINT32  *Buffer
+  )
+{
+  UINT32 Value;
+
+  memcpy (&Value, Buffer, sizeof (Value));
+
+  return Value;
+}
+
+VOID
+EFIAPI
+DebugAssert (
+  IN CONST CHAR8  *FileName,
+  IN UINTN        LineNumber,
+  IN CONST CHAR8  *Description
+  )
+{
+  fprintf (
+    stderr,
+    "ASSERT %s(%u): %s\n",
+    FileName,
+    (unsigned)LineNumber,
+    Description
+    );
+  abort ();
+}
+
+BOOLEAN
+EFIAPI
+DebugAssertEnabled (
+  VOID
+  )
+{
+  return TRUE;
+}
+
+VOID
+EFIAPI
+DebugPrint (
+  IN UINTN        ErrorLevel,
+  IN CONST CHAR8  *Format,
+  ...
+  )
+{
+}
+
+BOOLEAN
+EFIAPI
+DebugPrintEnabled (
+  VOID
+  )
+{
+  return FALSE;
+}
+
+BOOLEAN
+EFIAPI
+DebugPrintLevelEnabled (
+  IN CONST UINTN  ErrorLevel
+  )
+{
+  return FALSE;
+}
+
+BOOLEAN
+EFIAPI
+DebugCodeEnabled (
+  VOID
+  )
+{
+  return FALSE;
+}
+
+BOOLEAN
+EFIAPI
+DebugClearMemoryEnabled (
+  VOID
+  )
+{
+  return FALSE;
+}
+
+BOOLEAN
+EfiAtRuntime (
+  VOID
+  )
+{
+  return FALSE;
+}
+
+EFI_STATUS
+EfiHandleProtocol (
+  IN  EFI_HANDLE  Handle,
+  IN  EFI_GUID    *Protocol,
+  OUT VOID        **Interface
+  )
+{
+  EFI_STATUS Status;
+
+  Status = EFI_UNSUPPORTED;
+
+  if (memcmp (Protocol, &gEfiDiskIoProtocolGuid, sizeof (*Protocol)) == 0) {
+    *Interface = (VOID *)&mDiskIo;
+    Status     = EFI_SUCCESS;
+  } else if (memcmp (Protocol, &gEfiBlockIoProtocolGuid, sizeof (*Protocol))
+               == 0) {
+    *Interface = (VOID *)&mBlockIo;
+    Status     = EFI_SUCCESS;
+  }
+
+  return Status;
+}
+
+EFI_FILE_INFO *
+EFIAPI
+FileHandleGetInfo (
+  IN EFI_FILE_HANDLE  FileHandle
+  )
+{
+  EFI_FILE_INFO *FileInfo;
+  UINTN         Size;
+
+  Size     = (sizeof (*FileInfo) + HOST_PATH_SIZE);
+  FileInfo = malloc (Size);
+
+  if (FileInfo != NULL) {
+    if (EFI_ERROR (FileHandle->GetInfo (
+                                 FileHandle,
+                                 &gEfiFileInfoGuid,
+                                 &Size,
+                                 (VOID *)FileInfo
+                                 ))) {
+      free (FileInfo);
+
+      FileInfo = NULL;
+    }
+  }
+
+  return FileInfo;
+}
+
+EFI_STATUS
+EFIAPI
+FileHandleClose (
+  IN EFI_FILE_HANDLE  FileHandle
+  )
+{
+  return FileHandle->Close (FileHandle);
+}
+
+EFI_STATUS
+InternalGrowBuffer (
+  IN OUT VOID   **Buffer,
+  IN OUT UINTN  *BufferSize,
+  IN     UINTN  RequiredSize
+  )
+{
+  EFI_STATUS Status;
+
+  VOID       *NewBuffer;
+  UINTN      NewSize;
+
+  Status = EFI_SUCCESS;
+
+  if (RequiredSize > *BufferSize) {
+    NewSize   = MAX (RequiredSize, (*BufferSize * 2));
+    NewBuffer = realloc (*Buffer, NewSize);
+    Status    = EFI_OUT_OF_RESOURCES;
+
+    if (NewBuffer != NULL) {
+      *Buffer     = NewBuffer;
+      *BufferSize = NewSize;
+      Status      = EFI_SUCCESS;
+    }
+  }
+
+  return Status;
+}
+
+UINT16
+InternalTraceFileOpen (
+  IN CONST CHAR16  *FileName
+  )
+{
+  return MISC_FILE_TRACE_MAX_PATHS;
+}
+
+VOID
+InternalTraceFileRead (
+  IN UINT16  PathId,
+  IN UINT64  Offset,
+  IN UINTN   Size
+  )
+{
+}
+
+// Mock Protocols
+
+// HostResolvePath
+/** Resolves a backslash-separated path case-insensitively below mTree.
+
+  @return  Returned is whether the path exists.
+**/
+STATIC
+BOOLEAN
+HostResolvePath (
+  IN  CONST CHAR16  *FileName,
+  OUT char          *HostPath
+  )
+{
+  BOOLEAN       Found;
+
+  char          Component[HOST_PATH_SIZE];
+  UINTN         Length;
+  DIR           *Directory;
+  struct dirent *Entry;
+
+  Found = TRUE;
+
+  snprintf (HostPath, HOST_PATH_SIZE, "%s", mTree);
+
+  while (Found && (*FileName != L'\0')) {
+    for (Length = 0;
+         (FileName[Length] != L'\0') && (FileName[Length] != L'\\');
+         ++Length) {
+      Component[Length] = (char)FileName[Length];
+    }
+
+    Component[Length] = '\0';
+    FileName         += Length;
+
+    if (*FileName == L'\\') {
+      ++FileName;
+    }
+
+    if (Length > 0) {
+      Directory = opendir (HostPath);
+      Found     = FALSE;
+
+      if (Directory != NULL) {
+        while ((Entry = readdir (Directory)) != NULL) {
+          if (strcasecmp (Entry->d_name, Component) == 0) {
+            Length = strlen (HostPath);
+
+            snprintf (
+              &HostPath[Length],
+              (HOST_PATH_SIZE - Length),
+              "/%s",
+              Entry->d_name
+              );
+
+            Found = TRUE;
+            break;
+          }
+        }
+
+        closedir (Directory);
+      }
+    }
+  }
+
+  return Found;
+}
+
+// HostReadFile
+STATIC
+UINT8 *
+HostReadFile (
+  IN  const char  *HostPath,
+  OUT UINT64      *Size
+  )
+{
+  UINT8 *Data;
+  FILE  *File;
+  long  FileSize;
+
+  Data = NULL;
+  File = fopen (HostPath, "rb");
+
+  if (File != NULL) {
+    fseek (File, 0, SEEK_END);
+    FileSize = ftell (File);
+    rewind (File);
+
+    Data = malloc ((FileSize > 0) ? (size_t)FileSize : 1);
+
+    if ((Data != NULL)
+     && (fread (Data, 1, (size_t)FileSize, File) != (size_t)FileSize)) {
+      free (Data);
+
+      Data = NULL;
+    }
+
+    *Size = (UINT64)FileSize;
+
+    fclose (File);
+  }
+
+  return Data;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+HostFileClose (
+  IN EFI_FILE_PROTOCOL  *This
+  )
+{
+  free (BASE_CR (This, HOST_FILE, Protocol));
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+HostFileGetInfo (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN     EFI_GUID           *InformationType,
+  IN OUT UINTN              *BufferSize,
+  OUT    VOID               *Buffer
+  )
+{
+  EFI_STATUS    Status;
+
+  HOST_FILE     *File;
+  EFI_FILE_INFO *FileInfo;
+  struct stat   Stat;
+
+  File   = BASE_CR (This, HOST_FILE, Protocol);
+  Status = EFI_BUFFER_TOO_SMALL;
+
+  if (*BufferSize >= (sizeof (*FileInfo) + sizeof (CHAR16))) {
+    Status = EFI_DEVICE_ERROR;
+
+    if (stat (File->Path, &Stat) == 0) {
+      FileInfo = (EFI_FILE_INFO *)Buffer;
+
+      ZeroMem (FileInfo, sizeof (*FileInfo));
+
+      FileInfo->Size         = (sizeof (*FileInfo) + sizeof (CHAR16));
+      FileInfo->FileSize     = (UINT64)Stat.st_size;
+      FileInfo->PhysicalSize = (UINT64)Stat.st_size;
+      FileInfo->Attribute    = (S_ISDIR (Stat.st_mode)
+                                  ? EFI_FILE_DIRECTORY
+                                  : 0);
+      FileInfo->FileName[0]  = L'\0';
+
+      Status = EFI_SUCCESS;
+    }
+  }
+
+  return Status;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+HostFileOpen (
+  IN  EFI_FILE_PROTOCOL  *This,
+  OUT EFI_FILE_PROTOCOL  **NewHandle,
+  IN  CHAR16             *FileName,
+  IN  UINT64             OpenMode,
+  IN  UINT64             Attributes
+  )
+{
+  EFI_STATUS Status;
+
+  HOST_FILE  *File;
+
+  Status = EFI_NOT_FOUND;
+  File   = calloc (1, sizeof (*File));
+
+  if ((File != NULL) && HostResolvePath (FileName, File->Path)) {
+    File->Protocol.Revision = EFI_FILE_PROTOCOL_REVISION;
+    File->Protocol.Open     = HostFileOpen;
+    File->Protocol.Close    = HostFileClose;
+    File->Protocol.GetInfo  = HostFileGetInfo;
+
+    *NewHandle = &File->Protocol;
+    Status     = EFI_SUCCESS;
+  } else {
+    free (File);
+  }
+
+  return Status;
+}
+
+EFI_STATUS
+LoadFile (
+  IN  EFI_FILE_HANDLE  Root,
+  IN  CHAR16           *FileName,
+  OUT UINTN            *BufferSize,
+  OUT VOID             **Buffer
+  )
+{
+  EFI_STATUS Status;
+
+  char       HostPath[HOST_PATH_SIZE];
+  UINT64     Size;
+
+  ++mNumberOfFallbacks;
+
+  Status = EFI_NOT_FOUND;
+
+  if (HostResolvePath (FileName, HostPath)) {
+    *Buffer = HostReadFile (HostPath, &Size);
+
+    if (*Buffer != NULL) {
+      *BufferSize = (UINTN)Size;
+      Status      = EFI_SUCCESS;
+    }
+  }
+
+  return Status;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+HostReadDisk (
+  IN  EFI_DISK_IO_PROTOCOL  *This,
+  IN  UINT32                MediaId,
+  IN  UINT64                Offset,
+  IN  UINTN                 BufferSize,
+  OUT VOID                  *Buffer
+  )
+{
+  EFI_STATUS Status;
+
+  Status = EFI_DEVICE_ERROR;
+
+  if ((MediaId == mMedia.MediaId)
+   && (Offset <= mImageSize)
+   && (BufferSize <= (mImageSize - Offset))) {
+    memcpy (Buffer, &mImage[Offset], BufferSize);
+
+    Status = EFI_SUCCESS;
+  }
+
+  return Status;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+HostReadBlocks (
+  IN  EFI_BLOCK_IO_PROTOCOL  *This,
+  IN  UINT32                 MediaId,
+  IN  EFI_LBA                Lba,
+  IN  UINTN                  BufferSize,
+  OUT VOID                   *Buffer
+  )
+{
+  EFI_STATUS Status;
+
+  Status = EFI_BAD_BUFFER_SIZE;
+
+  if ((BufferSize % mMedia.BlockSize) == 0) {
+    Status = HostReadDisk (
+               &mDiskIo,
+               MediaId,
+               MultU64x32 (Lba, mMedia.BlockSize),
+               BufferSize,
+               Buffer
+               );
+  }
+
+  return Status;
+}
+
+// Test Cases
+
+// HostCheck
+STATIC
+VOID
+HostCheck (
+  IN BOOLEAN     Condition,
+  IN const char  *Name,
+  IN const char  *Path
+  )
+{
+  if (!Condition) {
+    ++mNumberOfFailures;
+  }
+
+  printf ("%s: %s %s\n", (Condition ? "PASS" : "FAIL"), Name, Path);
+}
+
+// HostToUnicode
+STATIC
+VOID
+HostToUnicode (
+  IN  const char  *String,
+  OUT CHAR16      *UnicodeString
+  )
+{
+  do {
+    *UnicodeString++ = (CHAR16)(UINT8)*String;
+  } while (*String++ != '\0');
+}
+
+// HostParseGeometry
+/** Derives the FAT layout from the image's boot sector as by the FAT
+    specification, independently of the code under test.
+**/
+STATIC
+VOID
+HostParseGeometry (
+  OUT HOST_FAT_GEOMETRY  *Geometry
+  )
+{
+  UINT32 BytesPerSector;
+  UINT32 SectorsPerCluster;
+  UINT32 ReservedSectors;
+  UINT32 RootDirSectors;
+  UINT32 TotalSectors;
+  UINT32 FatSectors;
+  UINT32 NumberOfClusters;
+
+  BytesPerSector    = ReadUnaligned16 ((UINT16 *)&mImage[11]);
+  SectorsPerCluster = mImage[13];
+  ReservedSectors   = ReadUnaligned16 ((UINT16 *)&mImage[14]);
+  RootDirSectors    = (((ReadUnaligned16 ((UINT16 *)&mImage[17]) * 32)
+                          + BytesPerSector - 1) / BytesPerSector);
+  TotalSectors      = ReadUnaligned16 ((UINT16 *)&mImage[19]);
+  FatSectors        = ReadUnaligned16 ((UINT16 *)&mImage[22]);
+
+  if (TotalSectors == 0) {
+    TotalSectors = ReadUnaligned32 ((UINT32 *)&mImage[32]);
+  }
+
+  if (FatSectors == 0) {
+    FatSectors = ReadUnaligned32 ((UINT32 *)&mImage[36]);
+  }
+
+  Geometry->NumberOfFats    = mImage[16];
+  Geometry->FatOffset       = ((UINT64)ReservedSectors * BytesPerSector);
+  Geometry->FatSize         = ((UINT64)FatSectors * BytesPerSector);
+  Geometry->BytesPerCluster = (BytesPerSector * SectorsPerCluster);
+  Geometry->DataOffset      = (Geometry->FatOffset
+                                + (Geometry->FatSize * Geometry->NumberOfFats)
+                                + ((UINT64)RootDirSectors * BytesPerSector));
+
+  NumberOfClusters = ((TotalSectors
+                         - (UINT32)(Geometry->DataOffset / BytesPerSector))
+                         / SectorsPerCluster);
+
+  Geometry->FatBits = ((NumberOfClusters < 4085)
+                         ? 12
+                         : ((NumberOfClusters < 65525) ? 16 : 32));
+}
+
+// HostFreeCluster
+/** Marks a cluster free in all FATs, breaking the chain running through it.
+**/
+STATIC
+VOID
+HostFreeCluster (
+  IN CONST HOST_FAT_GEOMETRY  *Geometry,
+  IN UINT32                   Cluster
+  )
+{
+  UINT32 Index;
+  UINT8  *Fat;
+  UINT8  *Entry;
+
+  for (Index = 0; Index < Geometry->NumberOfFats; ++Index) {
+    Fat = &mImage[Geometry->FatOffset + (Geometry->FatSize * Index)];
+
+    if (Geometry->FatBits == 32) {
+      Entry = &Fat[Cluster * 4];
+
+      Entry[0] = 0;
+      Entry[1] = 0;
+      Entry[2] = 0;
+      Entry[3] = (Entry[3] & 0xF0);
+    } else if (Geometry->FatBits == 16) {
+      Entry = &Fat[Cluster * 2];
+
+      Entry[0] = 0;
+      Entry[1] = 0;
+    } else {
+      Entry = &Fat[Cluster + (Cluster / 2)];
+
+      if ((Cluster & 1) != 0) {
+        Entry[0] = (Entry[0] & 0x0F);
+        Entry[1] = 0;
+      } else {
+        Entry[0] = 0;
+        Entry[1] = (Entry[1] & 0xF0);
+      }
+    }
+  }
+}
+
+// HostTestFile
+/** Resolves and loads a file and compares it with its host copy.
+
+  @return  Returned are the file's extents if it spans more than one.
+**/
+STATIC
+MISC_FILE_EXTENT *
+HostTestFile (
+  IN  EFI_FILE_HANDLE  Root,
+  IN  const char       *Path,
+  OUT UINTN            *NumberOfExtents
+  )
+{
+  MISC_FILE_EXTENT *Result;
+
+  CHAR16           FileName[HOST_PATH_SIZE];
+  char             UpperPath[HOST_PATH_SIZE];
+  char             HostPath[HOST_PATH_SIZE];
+  UINT8            *HostData;
+  UINT64           HostSize;
+  EFI_STATUS       Status;
+  UINT64           FileSize;
+  MISC_FILE_EXTENT *Extents;
+  UINT64           Length;
+  BOOLEAN          InImage;
+  UINTN            Index;
+  UINTN            BufferSize;
+  VOID             *Buffer;
+  UINTN            Fallbacks;
+
+  Result = NULL;
+
+  HostToUnicode (Path, FileName);
+
+  HostData = NULL;
+
+  if (HostResolvePath (FileName, HostPath)) {
+    HostData = HostReadFile (HostPath, &HostSize);
+  }
+
+  HostCheck ((HostData != NULL), "host copy", Path);
+
+  if (HostData != NULL) {
+    Status = MiscGetFileExtents (
+               (EFI_HANDLE)&mDiskIo,
+               FileName,
+               &FileSize,
+               NumberOfExtents,
+               &Extents
+               );
+
+    HostCheck (!EFI_ERROR (Status), "resolve", Path);
+
+    if (!EFI_ERROR (Status)) {
+      Length  = 0;
+      InImage = TRUE;
+
+      for (Index = 0; Index < *NumberOfExtents; ++Index) {
+        Length += Extents[Index].Length;
+
+        if ((Extents[Index].Offset > mImageSize)
+         || (Extents[Index].Length > (mImageSize - Extents[Index].Offset))) {
+          InImage = FALSE;
+        }
+      }
+
+      HostCheck ((FileSize == HostSize), "size", Path);
+      HostCheck ((Length == FileSize), "extent lengths", Path);
+      HostCheck (InImage, "extents inside image", Path);
+
+      if (*NumberOfExtents > 1) {
+        Result = Extents;
+      } else {
+        FreePool (Extents);
+      }
+    }
+
+    // FAT names compare case-insensitively.
+    for (Index = 0; Path[Index] != '\0'; ++Index) {
+      UpperPath[Index] = (char)toupper ((unsigned char)Path[Index]);
+    }
+
+    UpperPath[Index] = '\0';
+
+    HostToUnicode (UpperPath, FileName);
+
+    Status = MiscGetFileExtents (
+               (EFI_HANDLE)&mDiskIo,
+               FileName,
+               &FileSize,
+               &Index,
+               &Extents
+               );
+
+    HostCheck (
+      (!EFI_ERROR (Status) && (FileSize == HostSize)),
+      "resolve upper case",
+      Path
+      );
+
+    if (!EFI_ERROR (Status)) {
+      FreePool (Extents);
+    }
+
+    // Empty files are left to the file system.
+    HostToUnicode (Path, FileName);
+
+    Fallbacks = mNumberOfFallbacks;
+    Status    = MiscLoadFileByExtents (
+                  (EFI_HANDLE)&mDiskIo,
+                  Root,
+                  FileName,
+                  &BufferSize,
+                  &Buffer
+                  );
+
+    HostCheck (
+      (!EFI_ERROR (Status)
+        && (BufferSize == HostSize)
+        && (memcmp (Buffer, HostData, BufferSize) == 0)),
+      "load",
+      Path
+      );
+
+    HostCheck (
+      ((mNumberOfFallbacks == Fallbacks) == (HostSize > 0)),
+      "load by extents",
+      Path
+      );
+
+    if (!EFI_ERROR (Status)) {
+      FreePool (Buffer);
+    }
+
+    free (HostData);
+  }
+
+  return Result;
+}
+
+// HostTestCorruptChain
+/** Breaks a fragmented file's cluster chain and checks that resolving it
+    fails and loading it falls back to the file system.
+**/
+STATIC
+VOID
+HostTestCorruptChain (
+  IN EFI_FILE_HANDLE         Root,
+  IN const char              *Path,
+  IN CONST MISC_FILE_EXTENT  *Extents
+  )
+{
+  HOST_FAT_GEOMETRY Geometry;
+  UINT8             *Image;
+  CHAR16            FileName[HOST_PATH_SIZE];
+  EFI_STATUS        Status;
+  UINT64            FileSize;
+  UINTN             NumberOfExtents;
+  MISC_FILE_EXTENT  *NewExtents;
+  UINTN             BufferSize;
+  VOID              *Buffer;
+  UINTN             Fallbacks;
+
+  Image = malloc ((size_t)mImageSize);
+
+  if (Image != NULL) {
+    memcpy (Image, mImage, (size_t)mImageSize);
+
+    HostParseGeometry (&Geometry);
+    HostFreeCluster (
+      &Geometry,
+      (UINT32)(((Extents[0].Offset + Extents[0].Length - 1
+                   - Geometry.DataOffset) / Geometry.BytesPerCluster) + 2)
+      );
+
+    HostToUnicode (Path, FileName);
+
+    Status = MiscGetFileExtents (
+               (EFI_HANDLE)&mDiskIo,
+               FileName,
+               &FileSize,
+               &NumberOfExtents,
+               &NewExtents
+               );
+
+    HostCheck (
+      (Status == EFI_VOLUME_CORRUPTED),
+      "reject broken chain",
+      Path
+      );
+
+    if (!EFI_ERROR (Status)) {
+      FreePool (NewExtents);
+    }
+
+    Fallbacks = mNumberOfFallbacks;
+    Status    = MiscLoadFileByExtents (
+                  (EFI_HANDLE)&mDiskIo,
+                  Root,
+                  FileName,
+                  &BufferSize,
+                  &Buffer
+                  );
+
+    HostCheck (
+      (!EFI_ERROR (Status) && (mNumberOfFallbacks == (Fallbacks + 1))),
+      "fall back on broken chain",
+      Path
+      );
+
+    if (!EFI_ERROR (Status)) {
+      FreePool (Buffer);
+    }
+
+    memcpy (mImage, Image, (size_t)mImageSize);
+    free (Image);
+  }
+}
+
+int
+main (
+  int   argc,
+  char  **argv
+  )
+{
+  HOST_FILE        Root;
+  CHAR16           FileName[HOST_PATH_SIZE];
+  char             *DirectoryPath;
+  char             *Separator;
+  EFI_STATUS       Status;
+  UINT64           FileSize;
+  UINTN            NumberOfExtents;
+  MISC_FILE_EXTENT *Extents;
+  MISC_FILE_EXTENT *Fragmented;
+  const char       *FragmentedPath;
+  int              Index;
+
+  if (argc < 4) {
+    fprintf (stderr, "usage: %s <Image> <Tree> <Path>...\n", argv[0]);
+    return 2;
+  }
+
+  mImage = HostReadFile (argv[1], &mImageSize);
+  mTree  = argv[2];
+
+  if (mImage == NULL) {
+    fprintf (stderr, "cannot read %s\n", argv[1]);
+    return 2;
+  }
+
+  ZeroMem (&Root, sizeof (Root));
+
+  Root.Protocol.Revision = EFI_FILE_PROTOCOL_REVISION;
+  Root.Protocol.Open     = HostFileOpen;
+  Root.Protocol.GetInfo  = HostFileGetInfo;
+
+  snprintf (Root.Path, sizeof (Root.Path), "%s", mTree);
+
+  ZeroMem (&mMedia, sizeof (mMedia));
+  ZeroMem (&mBlockIo, sizeof (mBlockIo));
+  ZeroMem (&mDiskIo, sizeof (mDiskIo));
+
+  mMedia.MediaId          = 1;
+  mMedia.MediaPresent     = TRUE;
+  mMedia.LogicalPartition = TRUE;
+  mMedia.ReadOnly         = TRUE;
+  mMedia.BlockSize        = 512;
+  mMedia.LastBlock        = ((mImageSize / 512) - 1);
+  mBlockIo.Media          = &mMedia;
+  mBlockIo.ReadBlocks     = HostReadBlocks;
+  mDiskIo.ReadDisk        = HostReadDisk;
+
+  Fragmented     = NULL;
+  FragmentedPath = NULL;
+
+  for (Index = 3; Index < argc; ++Index) {
+    Extents = HostTestFile (&Root.Protocol, argv[Index], &NumberOfExtents);
+
+    if (Extents != NULL) {
+      if (Fragmented == NULL) {
+        Fragmented     = Extents;
+        FragmentedPath = argv[Index];
+      } else {
+        FreePool (Extents);
+      }
+    }
+  }
+
+  HostCheck ((Fragmented != NULL), "fragmented file present", argv[1]);
+
+  if (Fragmented != NULL) {
+    HostTestCorruptChain (&Root.Protocol, FragmentedPath, Fragmented);
+    FreePool (Fragmented);
+  }
+
+  HostToUnicode ("NoSuchDirectory\\NoSuchFile.bin", FileName);
+
+  Status = MiscGetFileExtents (
+             (EFI_HANDLE)&mDiskIo,
+             FileName,
+             &FileSize,
+             &NumberOfExtents,
+             &Extents
+             );
+
+  HostCheck ((Status == EFI_NOT_FOUND), "reject missing file", argv[1]);
+
+  // The parent directory of the first path must not resolve as a file.
+  DirectoryPath = strdup (argv[3]);
+  Separator     = strrchr (DirectoryPath, '\\');
+
+  if (Separator != NULL) {
+    *Separator = '\0';
+
+    HostToUnicode (DirectoryPath, FileName);
+
+    Status = MiscGetFileExtents (
+               (EFI_HANDLE)&mDiskIo,
+               FileName,
+               &FileSize,
+               &NumberOfExtents,
+               &Extents
+               );
+
+    HostCheck (EFI_ERROR (Status), "reject directory", DirectoryPath);
+
+    if (!EFI_ERROR (Status)) {
+      FreePool (Extents);
+    }
+  }
+
+  free (DirectoryPath);
+  free (mImage);
+
+  printf ("%u failure(s)\n", (unsigned)mNumberOfFailures);
+
+  return ((mNumberOfFailures == 0) ? 0 : 1);
+}
@@ -0,0 +1,75 @@
+#!/bin/sh
+#
+# Builds FAT12, FAT16 and FAT32 images with mkfs.fat and mtools, fragments
+# the files copied to them and runs FatExtentHostTest on every image.
+#
+# Usage: RunFatExtentTests.sh <FatExtentHostTest>
+#
+# Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+set -eu
+
+Test=${1:-./FatExtentHostTest}
+Work=$(mktemp -d)
+trap 'rm -rf "$Work"' EXIT INT TERM
+
+export MTOOLS_SKIP_CHECK=1
+
+Tree=$Work/tree
+LongDir="EFI/Misc Long Directory Name"
+
+mkdir -p "$Tree/EFI/BOOT" "$Tree/$LongDir"
+head -c 70000 /dev/urandom > "$Tree/EFI/BOOT/BOOTX64.EFI"
+head -c 300000 /dev/urandom > "$Tree/$LongDir/a very long file name.image"
+printf 'hello' > "$Tree/SMALL.TXT"
+: > "$Tree/empty.bin"
+printf '# FAT extent test volume\n' > "$Tree/Readme.md"
+
+Result=0
+
+# FAT type, size in KiB, sectors per cluster.
+for Config in "12 2000 4" "16 35000 2" "32 70000 1"; do
+  set -- $Config
+  Image=$Work/fat$1.img
+
+  mkfs.fat -C -F "$1" -S 512 -s "$3" "$Image" "$2" > /dev/null
+
+  #
+  # Fill the volume, then free every other filler file so that the files
+  # copied afterwards are spread over several extents.
+  #
+  head -c $((64 * 512 * $3)) /dev/urandom > "$Work/filler"
+  mmd -i "$Image" ::/FILL
+  Count=0
+  while mcopy -i "$Image" "$Work/filler" "::/FILL/F$Count" 2> /dev/null; do
+    Count=$((Count + 1))
+  done
+  Index=0
+  while [ "$Index" -lt "$Count" ]; do
+    mdel -i "$Image" "::/FILL/F$Index"
+    Index=$((Index + 2))
+  done
+
+  mcopy -s -i "$Image" "$Tree"/* ::/
+
+  echo "FAT$1:"
+  "$Test" "$Image" "$Tree"                                          \
+    'EFI\BOOT\BOOTX64.EFI'                                          \
+    'EFI\Misc Long Directory Name\a very long file name.image'      \
+    'SMALL.TXT' 'Readme.md' 'empty.bin' || Result=1
+done
+
+exit $Result
@@ -0,0 +1,679 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <IndustryStandard/UsbHid.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MiscUsbHidLib.h>
+
+// HID_MAX_GLOBAL_STACK
+#define HID_MAX_GLOBAL_STACK  4
+
+// HID_MAX_USAGES
+#define HID_MAX_USAGES  64
+
+// HID_MAX_REPORTS
+#define HID_MAX_REPORTS  32
+
+// HID_MAX_REPORT_BITS
+#define HID_MAX_REPORT_BITS  (MAX_UINT16 * 8)
+
+// HID_GLOBAL_STATE
+typedef struct {
+  USB_HID_PAGE_ID UsagePage;
+  INT32           LogicalMinimum;
+  UINT32          LogicalMaximum;      ///< Unresolved, see
+                                       ///< InternalResolveMaximum().
+  UINT8           LogicalMaximumSize;
+  UINT8           ReportId;
+  UINT32          ReportSize;
+  UINT32          ReportCount;
+} HID_GLOBAL_STATE;
+
+// HID_LOCAL_STATE
+typedef struct {
+  USB_HID_USAGE Usages[HID_MAX_USAGES];
+  UINTN         NumberOfUsages;
+  USB_HID_USAGE UsageMinimum;
+  USB_HID_USAGE UsageMaximum;
+} HID_LOCAL_STATE;
+
+// HID_REPORT
+/// The running bit offset of a report.
+typedef struct {
+  UINT8  ReportId;
+  UINT8  Type;
+  UINT32 BitOffset;
+} HID_REPORT;
+
+// HID_PARSER
+typedef struct {
+  HID_GLOBAL_STATE Global;
+  HID_GLOBAL_STATE Stack[HID_MAX_GLOBAL_STACK];
+  UINTN            StackDepth;
+  HID_LOCAL_STATE  Local;
+  HID_REPORT       Reports[HID_MAX_REPORTS];
+  UINTN            NumberOfReports;
+  UINTN            CollectionDepth;
+  USB_HID_USAGE    Application;
+  UINTN            NumberOfFields;
+  UINTN            MaxNumberOfFields;
+  MISC_HID_FIELD   *Fields;
+} HID_PARSER;
+
+// InternalSignExtend
+STATIC
+INT32
+InternalSignExtend (
+  IN UINT32  Value,
+  IN UINTN   Bits
+  )
+{
+  UINT32 SignBit;
+
+  if ((Bits > 0) && (Bits < 32)) {
+    SignBit = (1U << (Bits - 1));
+    Value   = ((Value ^ SignBit) - SignBit);
+  }
+
+  return (INT32)Value;
+}
+
+// InternalResolveMaximum
+/** Resolves the logical maximum against the logical minimum.
+
+  Many devices encode e.g. a maximum of 255 in a single byte, which would be
+  -1 if read signed.  The maximum is thus only sign-extended when the
+  minimum is negative.
+**/
+STATIC
+INT32
+InternalResolveMaximum (
+  IN CONST HID_GLOBAL_STATE  *Global
+  )
+{
+  INT32 Maximum;
+
+  Maximum = (INT32)Global->LogicalMaximum;
+
+  if (Global->LogicalMinimum < 0) {
+    Maximum = InternalSignExtend (
+                Global->LogicalMaximum,
+                (Global->LogicalMaximumSize * 8)
+                );
+  }
+
+  return Maximum;
+}
+
+// InternalGetReport
+/** Returns the running bit offset of a report, creating it if needed.
+
+  @return  Returned is the report or NULL if too many reports are used.
+**/
+STATIC
+HID_REPORT *
+InternalGetReport (
+  IN OUT HID_PARSER  *Parser,
+  IN     UINT8       Type
+  )
+{
+  HID_REPORT *Report;
+
+  UINTN      Index;
+
+  Report = NULL;
+
+  for (Index = 0; Index < Parser->NumberOfReports; ++Index) {
+    if ((Parser->Reports[Index].ReportId == Parser->Global.ReportId)
+     && (Parser->Reports[Index].Type == Type)) {
+      Report = &Parser->Reports[Index];
+      break;
+    }
+  }
+
+  if ((Report == NULL) && (Parser->NumberOfReports < HID_MAX_REPORTS)) {
+    Report            = &Parser->Reports[Parser->NumberOfReports];
+    Report->ReportId  = Parser->Global.ReportId;
+    Report->Type      = Type;
+    Report->BitOffset = ((Parser->Global.ReportId != 0) ? 8 : 0);
+
+    ++Parser->NumberOfReports;
+  }
+
+  return Report;
+}
+
+// InternalGetFieldUsage
+STATIC
+USB_HID_USAGE
+InternalGetFieldUsage (
+  IN CONST HID_LOCAL_STATE  *Local,
+  IN UINT32                 Index
+  )
+{
+  USB_HID_USAGE Usage;
+
+  Usage = 0;
+
+  if (Local->NumberOfUsages > 0) {
+    // The last usage applies to all remaining fields.
+    Usage = Local->Usages[MIN (Index, (Local->NumberOfUsages - 1))];
+  } else if (Local->UsageMaximum >= Local->UsageMinimum) {
+    Usage = Local->UsageMinimum;
+
+    if (Index <= (Local->UsageMaximum - Local->UsageMinimum)) {
+      Usage += Index;
+    } else {
+      Usage = Local->UsageMaximum;
+    }
+  }
+
+  return Usage;
+}
+
+// InternalParseMainField
+/** Compiles an Input, Output or Feature item into fields.
+
+  Constant items only pad the report.  Fields wider than 32 bits are
+  skipped.
+**/
+STATIC
+EFI_STATUS
+InternalParseMainField (
+  IN OUT HID_PARSER  *Parser,
+  IN     UINT8       Type,
+  IN     UINT32      Data
+  )
+{
+  EFI_STATUS     Status;
+
+  HID_REPORT     *Report;
+  UINT64         Bits;
+  UINT32         Index;
+  MISC_HID_FIELD *Field;
+
+  Status = EFI_UNSUPPORTED;
+  Report = InternalGetReport (Parser, Type);
+
+  if (Report != NULL) {
+    Status = EFI_INVALID_PARAMETER;
+    Bits   = MultU64x32 (Parser->Global.ReportSize, Parser->Global.ReportCount);
+
+    if (Bits <= (HID_MAX_REPORT_BITS - Report->BitOffset)) {
+      if (((Data & USB_HID_MAIN_ITEM_CONSTANT) == 0)
+       && (Parser->Global.ReportSize > 0)
+       && (Parser->Global.ReportSize <= 32)) {
+        for (Index = 0; Index < Parser->Global.ReportCount; ++Index) {
+          if (Parser->NumberOfFields < Parser->MaxNumberOfFields) {
+            Field = &Parser->Fields[Parser->NumberOfFields];
+
+            Field->Application    = Parser->Application;
+            Field->LogicalMinimum = Parser->Global.LogicalMinimum;
+            Field->LogicalMaximum = InternalResolveMaximum (&Parser->Global);
+            Field->BitOffset      = (Report->BitOffset
+                                      + (Index * Parser->Global.ReportSize));
+            Field->BitSize        = (UINT8)Parser->Global.ReportSize;
+            Field->ReportId       = Parser->Global.ReportId;
+            Field->Type           = Type;
+            Field->Reserved       = 0;
+            Field->Flags          = (UINT16)Data;
+
+            if ((Data & USB_HID_MAIN_ITEM_VARIABLE) != 0) {
+              Field->Usage        = InternalGetFieldUsage (
+                                      &Parser->Local,
+                                      Index
+                                      );
+              Field->UsageMaximum = Field->Usage;
+            } else if (Parser->Local.NumberOfUsages > 0) {
+              Field->Usage        = Parser->Local.Usages[0];
+              Field->UsageMaximum = Parser->Local.Usages[
+                                      Parser->Local.NumberOfUsages - 1
+                                      ];
+            } else {
+              Field->Usage        = Parser->Local.UsageMinimum;
+              Field->UsageMaximum = Parser->Local.UsageMaximum;
+            }
+          }
+
+          ++Parser->NumberOfFields;
+        }
+      }
+
+      Report->BitOffset += (UINT32)Bits;
+      Status             = EFI_SUCCESS;
+    }
+  }
+
+  return Status;
+}
+
+// InternalParseMainItem
+STATIC
+EFI_STATUS
+InternalParseMainItem (
+  IN OUT HID_PARSER  *Parser,
+  IN     UINT8       Tag,
+  IN     UINT32      Data
+  )
+{
+  EFI_STATUS Status;
+
+  Status = EFI_SUCCESS;
+
+  switch (Tag) {
+    case UsbHidMainItemTagInput:
+    case UsbHidMainItemTagOutput:
+    case UsbHidMainItemTagFeature:
+    {
+      Status = InternalParseMainField (Parser, Tag, Data);
+      break;
+    }
+
+    case UsbHidMainItemTagCollection:
+    {
+      if ((Parser->CollectionDepth == 0)
+       && (Data == UsbHidCollectionApplication)) {
+        Parser->Application = InternalGetFieldUsage (&Parser->Local, 0);
+      }
+
+      ++Parser->CollectionDepth;
+      break;
+    }
+
+    case UsbHidMainItemTagEndCollection:
+    {
+      if (Parser->CollectionDepth == 0) {
+        Status = EFI_INVALID_PARAMETER;
+      } else {
+        --Parser->CollectionDepth;
+
+        if (Parser->CollectionDepth == 0) {
+          Parser->Application = 0;
+        }
+      }
+
+      break;
+    }
+
+    default:
+    {
+      break;
+    }
+  }
+
+  // Local items only apply to the next main item.
+  ZeroMem ((VOID *)&Parser->Local, sizeof (Parser->Local));
+
+  return Status;
+}
+
+// InternalParseGlobalItem
+STATIC
+EFI_STATUS
+InternalParseGlobalItem (
+  IN OUT HID_PARSER  *Parser,
+  IN     UINT8       Tag,
+  IN     UINT32      Data,
+  IN     UINTN       Size
+  )
+{
+  EFI_STATUS Status;
+
+  Status = EFI_SUCCESS;
+
+  switch (Tag) {
+    case UsbHidGlobalItemTagUsagePage:
+    {
+      Parser->Global.UsagePage = (USB_HID_PAGE_ID)Data;
+      break;
+    }
+
+    case UsbHidGlobalItemTagLogicalMinimum:
+    {
+      Parser->Global.LogicalMinimum = InternalSignExtend (Data, (Size * 8));
+      break;
+    }
+
+    case UsbHidGlobalItemTagLogicalMaximum:
+    {
+      Parser->Global.LogicalMaximum     = Data;
+      Parser->Global.LogicalMaximumSize = (UINT8)Size;
+      break;
+    }
+
+    case UsbHidGlobalItemTagReportSize:
+    {
+      Parser->Global.ReportSize = Data;
+      break;
+    }
+
+    case UsbHidGlobalItemTagReportId:
+    {
+      if ((Data == 0) || (Data > MAX_UINT8)) {
+        Status = EFI_INVALID_PARAMETER;
+      } else {
+        Parser->Global.ReportId = (UINT8)Data;
+      }
+
+      break;
+    }
+
+    case UsbHidGlobalItemTagReportCount:
+    {
+      Parser->Global.ReportCount = Data;
+      break;
+    }
+
+    case UsbHidGlobalItemTagPush:
+    {
+      if (Parser->StackDepth == HID_MAX_GLOBAL_STACK) {
+        Status = EFI_UNSUPPORTED;
+      } else {
+        CopyMem (
+          (VOID *)&Parser->Stack[Parser->StackDepth],
+          (VOID *)&Parser->Global,
+          sizeof (Parser->Global)
+          );
+
+        ++Parser->StackDepth;
+      }
+
+      break;
+    }
+
+    case UsbHidGlobalItemTagPop:
+    {
+      if (Parser->StackDepth == 0) {
+        Status = EFI_INVALID_PARAMETER;
+      } else {
+        --Parser->StackDepth;
+
+        CopyMem (
+          (VOID *)&Parser->Global,
+          (VOID *)&Parser->Stack[Parser->StackDepth],
+          sizeof (Parser->Global)
+          );
+      }
+
+      break;
+    }
+
+    default:
+    {
+      break;
+    }
+  }
+
+  return Status;
+}
+
+// InternalParseLocalItem
+STATIC
+EFI_STATUS
+InternalParseLocalItem (
+  IN OUT HID_PARSER  *Parser,
+  IN     UINT8       Tag,
+  IN     UINT32      Data,
+  IN     UINTN       Size
+  )
+{
+  EFI_STATUS    Status;
+
+  USB_HID_USAGE Usage;
+
+  Status = EFI_SUCCESS;
+  Usage  = Data;
+
+  // 4-byte usages carry their own page.
+  if (Size < sizeof (Data)) {
+    Usage = USB_HID_USAGE (Data, (USB_HID_USAGE)Parser->Global.UsagePage);
+  }
+
+  switch (Tag) {
+    case UsbHidLocalItemTagUsage:
+    {
+      if (Parser->Local.NumberOfUsages == HID_MAX_USAGES) {
+        Status = EFI_UNSUPPORTED;
+      } else {
+        Parser->Local.Usages[Parser->Local.NumberOfUsages] = Usage;
+        ++Parser->Local.NumberOfUsages;
+      }
+
+      break;
+    }
+
+    case UsbHidLocalItemTagUsageMinimum:
+    {
+      Parser->Local.UsageMinimum = Usage;
+      break;
+    }
+
+    case UsbHidLocalItemTagUsageMaximum:
+    {
+      Parser->Local.UsageMaximum = Usage;
+      break;
+    }
+
+    default:
+    {
+      break;
+    }
+  }
+
+  return Status;
+}
+
+// MiscHidParseReportDescriptor
+/** Compiles a HID report descriptor into a flat table of fields.
+
+  Each field can then be read from a report with MiscHidGetFieldValue().
+  The descriptor is parsed once and the fields are written directly into the
+  caller's table, so a table of the size returned by a first call with
+  NumberOfFields = 0 is filled by a second call.
+
+  @param[in]      Descriptor      The report descriptor to parse.
+  @param[in]      DescriptorSize  The size, in bytes, of Descriptor.
+  @param[in, out] NumberOfFields  On input, the number of entries in Fields.
+                                  On output, the number of fields described.
+  @param[out]     Fields          The table to write the fields into.
+
+  @retval EFI_SUCCESS            The fields have been written.
+  @retval EFI_BUFFER_TOO_SMALL   Fields is too small, NumberOfFields has been
+                                 updated with the number of entries needed.
+  @retval EFI_INVALID_PARAMETER  Descriptor is malformed.
+  @retval EFI_UNSUPPORTED        Descriptor exceeds the parser's limits.
+**/
+EFI_STATUS
+MiscHidParseReportDescriptor (
+  IN     CONST VOID      *Descriptor,
+  IN     UINTN           DescriptorSize,
+  IN OUT UINTN           *NumberOfFields,
+  OUT    MISC_HID_FIELD  *Fields OPTIONAL
+  )
+{
+  EFI_STATUS  Status;
+
+  HID_PARSER  Parser;
+  CONST UINT8 *Item;
+  CONST UINT8 *End;
+  UINT8       Prefix;
+  UINTN       Size;
+  UINT32      Data;
+  UINTN       Index;
+
+  ASSERT (Descriptor != NULL);
+  ASSERT (NumberOfFields != NULL);
+  ASSERT ((Fields != NULL) || (*NumberOfFields == 0));
+
+  ZeroMem ((VOID *)&Parser, sizeof (Parser));
+
+  Parser.MaxNumberOfFields = *NumberOfFields;
+  Parser.Fields            = Fields;
+
+  Item   = (CONST UINT8 *)Descriptor;
+  End    = (Item + DescriptorSize);
+  Status = EFI_SUCCESS;
+
+  while (!EFI_ERROR (Status) && (Item < End)) {
+    Prefix = *Item;
+    ++Item;
+
+    // Long items are reserved and carry no fields, skip their data.
+    Size = USB_HID_ITEM_SIZE (Prefix);
+
+    if (Prefix == USB_HID_ITEM_LONG) {
+      Size = MAX_UINTN;
+
+      if ((UINTN)(End - Item) >= 2) {
+        Size = (2 + (UINTN)Item[0]);
+      }
+    }
+
+    if (Size > (UINTN)(End - Item)) {
+      Status = EFI_INVALID_PARAMETER;
+    } else if (Prefix != USB_HID_ITEM_LONG) {
+      Data = 0;
+
+      for (Index = Size; Index > 0; --Index) {
+        Data = ((Data << 8) | Item[Index - 1]);
+      }
+
+      switch (USB_HID_ITEM_TYPE (Prefix)) {
+        case UsbHidItemTypeMain:
+        {
+          Status = InternalParseMainItem (
+                     &Parser,
+                     USB_HID_ITEM_TAG (Prefix),
+                     Data
+                     );
+
+          break;
+        }
+
+        case UsbHidItemTypeGlobal:
+        {
+          Status = InternalParseGlobalItem (
+                     &Parser,
+                     USB_HID_ITEM_TAG (Prefix),
+                     Data,
+                     Size
+                     );
+
+          break;
+        }
+
+        case UsbHidItemTypeLocal:
+        {
+          Status = InternalParseLocalItem (
+                     &Parser,
+                     USB_HID_ITEM_TAG (Prefix),
+                     Data,
+                     Size
+                     );
+
+          break;
+        }
+
+        default:
+        {
+          Status = EFI_INVALID_PARAMETER;
+          break;
+        }
+      }
+    }
+
+    Item += MIN (Size, (UINTN)(End - Item));
+  }
+
+  if (!EFI_ERROR (Status)) {
+    if (Parser.NumberOfFields > *NumberOfFields) {
+      Status = EFI_BUFFER_TOO_SMALL;
+    }
+
+    *NumberOfFields = Parser.NumberOfFields;
+  }
+
+  return Status;
+}
+
+// MiscHidGetFieldValue
+/** Reads a field from a report.
+
+  For array fields, the value is an index into the field's usages, the usage
+  pressed is Usage + (Value - LogicalMinimum).
+
+  @param[in]  Field       The field to read.
+  @param[in]  Report      The report to read the field from, starting with
+                          the Report ID if the device uses Report IDs.
+  @param[in]  ReportSize  The size, in bytes, of Report.
+  @param[out] Value       The field's value, sign-extended if the field's
+                          logical minimum is negative.
+
+  @return  Returned is whether Report holds the field.
+**/
+BOOLEAN
+MiscHidGetFieldValue (
+  IN  CONST MISC_HID_FIELD  *Field,
+  IN  CONST VOID            *Report,
+  IN  UINTN                 ReportSize,
+  OUT INT32                 *Value
+  )
+{
+  BOOLEAN     Found;
+
+  CONST UINT8 *Bytes;
+  UINTN       First;
+  UINTN       Last;
+  UINTN       Index;
+  UINT64      Raw;
+  UINT32      Mask;
+
+  ASSERT (Field != NULL);
+  ASSERT ((Field->BitSize > 0) && (Field->BitSize <= 32));
+  ASSERT ((Report != NULL) || (ReportSize == 0));
+  ASSERT (Value != NULL);
+
+  Found = FALSE;
+  Bytes = (CONST UINT8 *)Report;
+  First = (Field->BitOffset / 8);
+  Last  = ((Field->BitOffset + Field->BitSize - 1) / 8);
+
+  if ((Last < ReportSize)
+   && ((Field->ReportId == 0) || (Bytes[0] == Field->ReportId))) {
+    Raw = 0;
+
+    // A field spans at most five bytes.
+    for (Index = (Last + 1); Index > First; --Index) {
+      Raw = (LShiftU64 (Raw, 8) | Bytes[Index - 1]);
+    }
+
+    Mask   = (MAX_UINT32 >> (32 - Field->BitSize));
+    *Value = (INT32)((UINT32)RShiftU64 (Raw, (Field->BitOffset % 8)) & Mask);
+
+    if (Field->LogicalMinimum < 0) {
+      *Value = InternalSignExtend ((UINT32)*Value, Field->BitSize);
+    }
+
+    Found = TRUE;
+  }
+
+  return Found;
+}
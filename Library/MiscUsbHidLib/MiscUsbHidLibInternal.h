@@ -0,0 +1,134 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#ifndef MISC_USB_HID_LIB_INTERNAL_H_
+#define MISC_USB_HID_LIB_INTERNAL_H_
+
+// MISC_EFI_KEY_USB_KEY_CODES
+/// Expands Entry (Context, Key, KeyCode, Alternate) for every EFI_KEY in
+/// ascending order.  KeyCode names the USB Keycode of Key without its
+/// UsbHidUsageIdKbKp prefix.  Alternate is TRUE for the keys sharing their
+/// Keycode with a key of the alphanumeric block.
+/// Both conversion tables are derived from this list, it is the only place
+/// the mapping is written down.
+#define MISC_EFI_KEY_USB_KEY_CODES(Entry, Context)                            \
+  Entry (Context, EfiKeyLCtrl,      ModifierKeyLeftControl,  FALSE)           \
+  Entry (Context, EfiKeyA0,         ModifierKeyLeftGui,      FALSE)           \
+  Entry (Context, EfiKeyLAlt,       ModifierKeyLeftAlt,      FALSE)           \
+  Entry (Context, EfiKeySpaceBar,   KeySpaceBar,             FALSE)           \
+  Entry (Context, EfiKeyA2,         ModifierKeyRightAlt,     FALSE)           \
+  Entry (Context, EfiKeyA3,         ModifierKeyRightGui,     FALSE)           \
+  Entry (Context, EfiKeyA4,         PadKeyApplication,       FALSE)           \
+  Entry (Context, EfiKeyRCtrl,      ModifierKeyRightControl, FALSE)           \
+  Entry (Context, EfiKeyLeftArrow,  KeyLeftArrow,            FALSE)           \
+  Entry (Context, EfiKeyDownArrow,  KeyDownArrow,            FALSE)           \
+  Entry (Context, EfiKeyRightArrow, KeyRightArrow,           FALSE)           \
+  Entry (Context, EfiKeyZero,       KeyZero,                 TRUE)            \
+  Entry (Context, EfiKeyPeriod,     KeyPeriod,               TRUE)            \
+  Entry (Context, EfiKeyEnter,      KeyEnter,                FALSE)           \
+  Entry (Context, EfiKeyLShift,     ModifierKeyLeftShift,    FALSE)           \
+  Entry (Context, EfiKeyB0,         PadKeyNonUsBackslash,    FALSE)           \
+  Entry (Context, EfiKeyB1,         KeyZ,                    FALSE)           \
+  Entry (Context, EfiKeyB2,         KeyX,                    FALSE)           \
+  Entry (Context, EfiKeyB3,         KeyC,                    FALSE)           \
+  Entry (Context, EfiKeyB4,         KeyV,                    FALSE)           \
+  Entry (Context, EfiKeyB5,         KeyB,                    FALSE)           \
+  Entry (Context, EfiKeyB6,         KeyN,                    FALSE)           \
+  Entry (Context, EfiKeyB7,         KeyM,                    FALSE)           \
+  Entry (Context, EfiKeyB8,         KeyComma,                FALSE)           \
+  Entry (Context, EfiKeyB9,         KeyPeriod,               FALSE)           \
+  Entry (Context, EfiKeyB10,        KeySlash,                FALSE)           \
+  Entry (Context, EfiKeyRShift,     ModifierKeyRightShift,   FALSE)           \
+  Entry (Context, EfiKeyUpArrow,    KeyUpArrow,              FALSE)           \
+  Entry (Context, EfiKeyOne,        KeyOne,                  TRUE)            \
+  Entry (Context, EfiKeyTwo,        KeyTwo,                  TRUE)            \
+  Entry (Context, EfiKeyThree,      KeyThree,                TRUE)            \
+  Entry (Context, EfiKeyCapsLock,   KeyCLock,                FALSE)           \
+  Entry (Context, EfiKeyC1,         KeyA,                    FALSE)           \
+  Entry (Context, EfiKeyC2,         KeyS,                    FALSE)           \
+  Entry (Context, EfiKeyC3,         KeyD,                    FALSE)           \
+  Entry (Context, EfiKeyC4,         KeyF,                    FALSE)           \
+  Entry (Context, EfiKeyC5,         KeyG,                    FALSE)           \
+  Entry (Context, EfiKeyC6,         KeyH,                    FALSE)           \
+  Entry (Context, EfiKeyC7,         KeyJ,                    FALSE)           \
+  Entry (Context, EfiKeyC8,         KeyK,                    FALSE)           \
+  Entry (Context, EfiKeyC9,         KeyL,                    FALSE)           \
+  Entry (Context, EfiKeyC10,        KeySemicolon,            FALSE)           \
+  Entry (Context, EfiKeyC11,        KeyQuotation,            FALSE)           \
+  Entry (Context, EfiKeyC12,        KeyNonUsHash,            FALSE)           \
+  Entry (Context, EfiKeyFour,       KeyFour,                 TRUE)            \
+  Entry (Context, EfiKeyFive,       KeyFive,                 TRUE)            \
+  Entry (Context, EfiKeySix,        KeySix,                  TRUE)            \
+  Entry (Context, EfiKeyPlus,       PadKeyPlus,              FALSE)           \
+  Entry (Context, EfiKeyTab,        KeyTab,                  FALSE)           \
+  Entry (Context, EfiKeyD1,         KeyQ,                    FALSE)           \
+  Entry (Context, EfiKeyD2,         KeyW,                    FALSE)           \
+  Entry (Context, EfiKeyD3,         KeyE,                    FALSE)           \
+  Entry (Context, EfiKeyD4,         KeyR,                    FALSE)           \
+  Entry (Context, EfiKeyD5,         KeyT,                    FALSE)           \
+  Entry (Context, EfiKeyD6,         KeyY,                    FALSE)           \
+  Entry (Context, EfiKeyD7,         KeyU,                    FALSE)           \
+  Entry (Context, EfiKeyD8,         KeyI,                    FALSE)           \
+  Entry (Context, EfiKeyD9,         KeyO,                    FALSE)           \
+  Entry (Context, EfiKeyD10,        KeyP,                    FALSE)           \
+  Entry (Context, EfiKeyD11,        KeyLeftBracket,          FALSE)           \
+  Entry (Context, EfiKeyD12,        KeyRightBracket,         FALSE)           \
+  Entry (Context, EfiKeyD13,        KeyBackslash,            FALSE)           \
+  Entry (Context, EfiKeyDel,        KeyDel,                  FALSE)           \
+  Entry (Context, EfiKeyEnd,        KeyEnd,                  FALSE)           \
+  Entry (Context, EfiKeyPgDn,       KeyPgDn,                 FALSE)           \
+  Entry (Context, EfiKeySeven,      KeySeven,                TRUE)            \
+  Entry (Context, EfiKeyEight,      KeyEight,                TRUE)            \
+  Entry (Context, EfiKeyNine,       KeyNine,                 TRUE)            \
+  Entry (Context, EfiKeyE0,         KeyAcute,                FALSE)           \
+  Entry (Context, EfiKeyE1,         KeyOne,                  FALSE)           \
+  Entry (Context, EfiKeyE2,         KeyTwo,                  FALSE)           \
+  Entry (Context, EfiKeyE3,         KeyThree,                FALSE)           \
+  Entry (Context, EfiKeyE4,         KeyFour,                 FALSE)           \
+  Entry (Context, EfiKeyE5,         KeyFive,                 FALSE)           \
+  Entry (Context, EfiKeyE6,         KeySix,                  FALSE)           \
+  Entry (Context, EfiKeyE7,         KeySeven,                FALSE)           \
+  Entry (Context, EfiKeyE8,         KeyEight,                FALSE)           \
+  Entry (Context, EfiKeyE9,         KeyNine,                 FALSE)           \
+  Entry (Context, EfiKeyE10,        KeyZero,                 FALSE)           \
+  Entry (Context, EfiKeyE11,        KeyMinus,                FALSE)           \
+  Entry (Context, EfiKeyE12,        KeyEquals,               FALSE)           \
+  Entry (Context, EfiKeyBackSpace,  KeyBackSpace,            FALSE)           \
+  Entry (Context, EfiKeyIns,        KeyIns,                  FALSE)           \
+  Entry (Context, EfiKeyHome,       KeyHome,                 FALSE)           \
+  Entry (Context, EfiKeyPgUp,       KeyPgUp,                 FALSE)           \
+  Entry (Context, EfiKeyNLck,       PadKeyNLck,              FALSE)           \
+  Entry (Context, EfiKeySlash,      KeySlash,                TRUE)            \
+  Entry (Context, EfiKeyAsterisk,   PadKeyAsterisk,          FALSE)           \
+  Entry (Context, EfiKeyMinus,      PadKeyMinus,             FALSE)           \
+  Entry (Context, EfiKeyEsc,        KeyEsc,                  FALSE)           \
+  Entry (Context, EfiKeyF1,         KeyF1,                   FALSE)           \
+  Entry (Context, EfiKeyF2,         KeyF2,                   FALSE)           \
+  Entry (Context, EfiKeyF3,         KeyF3,                   FALSE)           \
+  Entry (Context, EfiKeyF4,         KeyF4,                   FALSE)           \
+  Entry (Context, EfiKeyF5,         KeyF5,                   FALSE)           \
+  Entry (Context, EfiKeyF6,         KeyF6,                   FALSE)           \
+  Entry (Context, EfiKeyF7,         KeyF7,                   FALSE)           \
+  Entry (Context, EfiKeyF8,         KeyF8,                   FALSE)           \
+  Entry (Context, EfiKeyF9,         KeyF9,                   FALSE)           \
+  Entry (Context, EfiKeyF10,        KeyF10,                  FALSE)           \
+  Entry (Context, EfiKeyF11,        KeyF11,                  FALSE)           \
+  Entry (Context, EfiKeyF12,        KeyF12,                  FALSE)           \
+  Entry (Context, EfiKeyPrint,      KeyPrint,                FALSE)           \
+  Entry (Context, EfiKeySLck,       KeySLock,                FALSE)           \
+  Entry (Context, EfiKeyPause,      KeyPause,                FALSE)
+
+#endif // MISC_USB_HID_LIB_INTERNAL_H_
@@ -0,0 +1,81 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <IndustryStandard/UsbHid.h>
+
+#include <Uefi/UefiInternalFormRepresentation.h>
+
+#include <Library/MiscUsbHidLib.h>
+
+#include "MiscUsbHidLibInternal.h"
+
+// INTERNAL_PRIMARY_EFI_KEY
+#define INTERNAL_PRIMARY_EFI_KEY(KeyCode, Key, EntryKeyCode, Alternate)  \
+  (!(Alternate) && ((KeyCode) == UsbHidUsageIdKbKp##EntryKeyCode))       \
+    ? (Key) :
+
+// INTERNAL_ALTERNATE_EFI_KEY
+#define INTERNAL_ALTERNATE_EFI_KEY(KeyCode, Key, EntryKeyCode, Alternate)  \
+  ((Alternate) && ((KeyCode) == UsbHidUsageIdKbKp##EntryKeyCode))          \
+    ? (Key) :
+
+// INTERNAL_EFI_KEYS
+/// Searches MISC_EFI_KEY_USB_KEY_CODES for the keys of KeyCode.  All
+/// operands are constant, so the compiler folds the search.
+#define INTERNAL_EFI_KEYS(KeyCode)                                    \
+  {                                                                   \
+    MISC_EFI_KEY_USB_KEY_CODES (INTERNAL_PRIMARY_EFI_KEY, KeyCode)    \
+      MISC_NO_EFI_KEY,                                                \
+    MISC_EFI_KEY_USB_KEY_CODES (INTERNAL_ALTERNATE_EFI_KEY, KeyCode)  \
+      MISC_NO_EFI_KEY                                                 \
+  }
+
+// INTERNAL_EFI_KEYS_4
+#define INTERNAL_EFI_KEYS_4(KeyCode)                                     \
+  INTERNAL_EFI_KEYS (KeyCode),       INTERNAL_EFI_KEYS ((KeyCode) + 1),  \
+  INTERNAL_EFI_KEYS ((KeyCode) + 2), INTERNAL_EFI_KEYS ((KeyCode) + 3)
+
+// INTERNAL_EFI_KEYS_16
+#define INTERNAL_EFI_KEYS_16(KeyCode)                                        \
+  INTERNAL_EFI_KEYS_4 (KeyCode),       INTERNAL_EFI_KEYS_4 ((KeyCode) + 4),  \
+  INTERNAL_EFI_KEYS_4 ((KeyCode) + 8), INTERNAL_EFI_KEYS_4 ((KeyCode) + 12)
+
+// gUsbKeyCodeToEfiKeyConvertionTable
+/// USB Keycode to EFI_KEY conversion table, the reverse of
+/// gEfiKeyToUsbKeyCodeConvertionTable.  Where two keys map to the same
+/// USB Keycode, the key of the alphanumeric block is the primary one.
+GLOBAL_REMOVE_IF_UNREFERENCED
+CONST MISC_USB_KEY_CODE_TO_EFI_KEY
+gUsbKeyCodeToEfiKeyConvertionTable[MISC_USB_KB_KP_NUMBER_OF_USAGES] = {
+  INTERNAL_EFI_KEYS_16 (0x00),
+  INTERNAL_EFI_KEYS_16 (0x10),
+  INTERNAL_EFI_KEYS_16 (0x20),
+  INTERNAL_EFI_KEYS_16 (0x30),
+  INTERNAL_EFI_KEYS_16 (0x40),
+  INTERNAL_EFI_KEYS_16 (0x50),
+  INTERNAL_EFI_KEYS_16 (0x60),
+  INTERNAL_EFI_KEYS_16 (0x70),
+  INTERNAL_EFI_KEYS_16 (0x80),
+  INTERNAL_EFI_KEYS_16 (0x90),
+  INTERNAL_EFI_KEYS_16 (0xA0),
+  INTERNAL_EFI_KEYS_16 (0xB0),
+  INTERNAL_EFI_KEYS_16 (0xC0),
+  INTERNAL_EFI_KEYS_16 (0xD0),
+  INTERNAL_EFI_KEYS_4 (0xE0),
+  INTERNAL_EFI_KEYS_4 (0xE4)
+};
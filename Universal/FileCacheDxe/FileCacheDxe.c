@@ -0,0 +1,438 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Protocol/DevicePath.h>
+#include <Protocol/MiscFileCache.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/EfiBootServicesLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscFileLib.h>
+#include <Library/PcdLib.h>
+
+// FILE_CACHE_NUMBER_OF_BUCKETS
+#define FILE_CACHE_NUMBER_OF_BUCKETS  256
+
+// FILE_CACHE_ENTRY_SIGNATURE
+#define FILE_CACHE_ENTRY_SIGNATURE  SIGNATURE_32 ('F', 'C', 'E', 'N')
+
+// FILE_CACHE_ENTRY
+/// Followed by the content, the file name and the volume's device path.
+typedef struct {
+  UINT32                   Signature;
+  UINT32                   Hash;
+  LIST_ENTRY               BucketLink;
+  LIST_ENTRY               LruLink;           ///< Most recent use first.
+  UINTN                    References;
+  UINTN                    AllocationSize;
+  EFI_TIME                 ModificationTime;
+  UINT64                   FileSize;
+  CONST CHAR16             *FileName;
+  EFI_DEVICE_PATH_PROTOCOL *Volume;
+  UINTN                    VolumeSize;
+} FILE_CACHE_ENTRY;
+
+// FILE_CACHE_ENTRY_FROM_BUFFER
+#define FILE_CACHE_ENTRY_FROM_BUFFER(Buffer)  \
+  (((FILE_CACHE_ENTRY *)(Buffer)) - 1)
+
+// mFileCacheBuckets
+STATIC LIST_ENTRY mFileCacheBuckets[FILE_CACHE_NUMBER_OF_BUCKETS];
+
+// mFileCacheLru
+STATIC LIST_ENTRY mFileCacheLru;
+
+// mFileCacheSize
+/// The size, in bytes, of all cache entries.
+STATIC UINTN mFileCacheSize = 0;
+
+// InternalHashBytes
+STATIC
+UINT32
+InternalHashBytes (
+  IN UINT32      Hash,
+  IN CONST VOID  *Data,
+  IN UINTN       DataSize
+  )
+{
+  CONST UINT8 *Bytes;
+  UINTN       Index;
+
+  Bytes = (CONST UINT8 *)Data;
+
+  for (Index = 0; Index < DataSize; ++Index) {
+    Hash = ((Hash ^ Bytes[Index]) * 0x01000193);
+  }
+
+  return Hash;
+}
+
+// InternalHashKey
+/** Hashes a cache key.  The file name is hashed case-insensitively.
+**/
+STATIC
+UINT32
+InternalHashKey (
+  IN CONST MISC_FILE_CACHE_KEY  *Key,
+  IN UINTN                      VolumeSize
+  )
+{
+  UINT32       Hash;
+
+  CONST CHAR16 *FileName;
+  CHAR16       Char;
+
+  Hash = InternalHashBytes (0x811C9DC5, (VOID *)Key->Volume, VolumeSize);
+
+  for (FileName = Key->FileName; *FileName != L'\0'; ++FileName) {
+    Char = CharToUpper (*FileName);
+    Hash = InternalHashBytes (Hash, (VOID *)&Char, sizeof (Char));
+  }
+
+  Hash = InternalHashBytes (
+           Hash,
+           (VOID *)&Key->ModificationTime,
+           sizeof (Key->ModificationTime)
+           );
+
+  return InternalHashBytes (
+           Hash,
+           (VOID *)&Key->FileSize,
+           sizeof (Key->FileSize)
+           );
+}
+
+// InternalFindEntry
+/** Finds the entry of a key.
+
+  @return  Returned is the entry or NULL if the key is not cached.
+**/
+STATIC
+FILE_CACHE_ENTRY *
+InternalFindEntry (
+  IN CONST MISC_FILE_CACHE_KEY  *Key,
+  IN UINT32                     Hash,
+  IN UINTN                      VolumeSize
+  )
+{
+  FILE_CACHE_ENTRY *Entry;
+
+  LIST_ENTRY       *Bucket;
+  LIST_ENTRY       *Link;
+  FILE_CACHE_ENTRY *Candidate;
+
+  Entry  = NULL;
+  Bucket = &mFileCacheBuckets[Hash % FILE_CACHE_NUMBER_OF_BUCKETS];
+
+  for (
+    Link = GetFirstNode (Bucket);
+    !IsNull (Bucket, Link);
+    Link = GetNextNode (Bucket, Link)
+    ) {
+    Candidate = BASE_CR (Link, FILE_CACHE_ENTRY, BucketLink);
+
+    if ((Candidate->Hash == Hash)
+     && (Candidate->FileSize == Key->FileSize)
+     && (Candidate->VolumeSize == VolumeSize)
+     && (CompareMem (
+           (VOID *)&Candidate->ModificationTime,
+           (VOID *)&Key->ModificationTime,
+           sizeof (Key->ModificationTime)
+           ) == 0)
+     && (CompareMem (
+           (VOID *)Candidate->Volume,
+           (VOID *)Key->Volume,
+           VolumeSize
+           ) == 0)
+     && (MiscFileStriCmp (Candidate->FileName, Key->FileName) == 0)) {
+      Entry = Candidate;
+
+      break;
+    }
+  }
+
+  return Entry;
+}
+
+// InternalRemoveEntry
+STATIC
+VOID
+InternalRemoveEntry (
+  IN FILE_CACHE_ENTRY  *Entry
+  )
+{
+  ASSERT (Entry->References == 0);
+
+  RemoveEntryList (&Entry->BucketLink);
+  RemoveEntryList (&Entry->LruLink);
+
+  mFileCacheSize -= Entry->AllocationSize;
+
+  FreePool ((VOID *)Entry);
+}
+
+// InternalEvict
+/** Evicts least recently used, unreferenced entries until Size more bytes
+    fit the budget.
+
+  @retval TRUE   Size more bytes fit the budget.
+  @retval FALSE  Referenced entries occupy the budget.
+**/
+STATIC
+BOOLEAN
+InternalEvict (
+  IN UINTN  Size
+  )
+{
+  UINTN            Budget;
+
+  LIST_ENTRY       *Link;
+  LIST_ENTRY       *PreviousLink;
+  FILE_CACHE_ENTRY *Entry;
+
+  Budget = PcdGet32 (PcdFileCacheBudget);
+
+  for (
+    Link = GetPreviousNode (&mFileCacheLru, &mFileCacheLru);
+    !IsNull (&mFileCacheLru, Link) && ((mFileCacheSize + Size) > Budget);
+    Link = PreviousLink
+    ) {
+    PreviousLink = GetPreviousNode (&mFileCacheLru, Link);
+    Entry        = BASE_CR (Link, FILE_CACHE_ENTRY, LruLink);
+
+    if (Entry->References == 0) {
+      InternalRemoveEntry (Entry);
+    }
+  }
+
+  return (BOOLEAN)((mFileCacheSize + Size) <= Budget);
+}
+
+// FileCacheLookup
+STATIC
+EFI_STATUS
+EFIAPI
+FileCacheLookup (
+  IN  MISC_FILE_CACHE_PROTOCOL   *This,
+  IN  CONST MISC_FILE_CACHE_KEY  *Key,
+  OUT CONST VOID                 **Buffer
+  )
+{
+  EFI_STATUS       Status;
+
+  UINTN            VolumeSize;
+  FILE_CACHE_ENTRY *Entry;
+  EFI_TPL          OldTpl;
+
+  ASSERT (Key != NULL);
+  ASSERT (Key->Volume != NULL);
+  ASSERT (Key->FileName != NULL);
+  ASSERT (Buffer != NULL);
+
+  VolumeSize = GetDevicePathSize (Key->Volume);
+  OldTpl     = EfiRaiseTPL (TPL_NOTIFY);
+  Entry      = InternalFindEntry (
+                 Key,
+                 InternalHashKey (Key, VolumeSize),
+                 VolumeSize
+                 );
+
+  Status = EFI_NOT_FOUND;
+
+  if (Entry != NULL) {
+    ++Entry->References;
+
+    RemoveEntryList (&Entry->LruLink);
+    InsertHeadList (&mFileCacheLru, &Entry->LruLink);
+
+    *Buffer = (CONST VOID *)(Entry + 1);
+    Status  = EFI_SUCCESS;
+  }
+
+  EfiRestoreTPL (OldTpl);
+
+  return Status;
+}
+
+// FileCacheInsert
+STATIC
+EFI_STATUS
+EFIAPI
+FileCacheInsert (
+  IN MISC_FILE_CACHE_PROTOCOL   *This,
+  IN CONST MISC_FILE_CACHE_KEY  *Key,
+  IN CONST VOID                 *Buffer
+  )
+{
+  EFI_STATUS       Status;
+
+  UINTN            VolumeSize;
+  UINTN            NameSize;
+  UINTN            NameOffset;
+  UINTN            AllocationSize;
+  UINTN            Budget;
+  UINT32           Hash;
+  FILE_CACHE_ENTRY *Entry;
+  EFI_TPL          OldTpl;
+
+  ASSERT (Key != NULL);
+  ASSERT (Key->Volume != NULL);
+  ASSERT (Key->FileName != NULL);
+  ASSERT ((Buffer != NULL) || (Key->FileSize == 0));
+
+  Status = EFI_BUFFER_TOO_SMALL;
+  Budget = PcdGet32 (PcdFileCacheBudget);
+
+  if (Key->FileSize <= Budget) {
+    VolumeSize     = GetDevicePathSize (Key->Volume);
+    NameSize       = StrSize (Key->FileName);
+    NameOffset     = ALIGN_VALUE (
+                       (sizeof (*Entry) + (UINTN)Key->FileSize),
+                       sizeof (CHAR16)
+                       );
+
+    AllocationSize = (NameOffset + NameSize + VolumeSize);
+
+    // The entry's header, name and volume path count against the budget as
+    // well, an entry larger than the whole budget could never be inserted.
+
+    if (AllocationSize <= Budget) {
+      Hash   = InternalHashKey (Key, VolumeSize);
+      OldTpl = EfiRaiseTPL (TPL_NOTIFY);
+      Status = EFI_ALREADY_STARTED;
+
+      if (InternalFindEntry (Key, Hash, VolumeSize) == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+
+        if (InternalEvict (AllocationSize)) {
+          Entry = AllocatePool (AllocationSize);
+
+          if (Entry != NULL) {
+            Entry->Signature      = FILE_CACHE_ENTRY_SIGNATURE;
+            Entry->Hash           = Hash;
+            Entry->References     = 0;
+            Entry->AllocationSize = AllocationSize;
+            Entry->FileSize       = Key->FileSize;
+            Entry->FileName       = (CHAR16 *)((UINT8 *)Entry + NameOffset);
+            Entry->Volume         = (EFI_DEVICE_PATH_PROTOCOL *)(
+                                      (UINT8 *)Entry + NameOffset + NameSize
+                                      );
+
+            Entry->VolumeSize     = VolumeSize;
+
+            CopyMem (
+              (VOID *)&Entry->ModificationTime,
+              (VOID *)&Key->ModificationTime,
+              sizeof (Entry->ModificationTime)
+              );
+
+            CopyMem ((VOID *)(Entry + 1), Buffer, (UINTN)Key->FileSize);
+            CopyMem ((VOID *)Entry->FileName, (VOID *)Key->FileName, NameSize);
+            CopyMem ((VOID *)Entry->Volume, (VOID *)Key->Volume, VolumeSize);
+
+            InsertHeadList (
+              &mFileCacheBuckets[Hash % FILE_CACHE_NUMBER_OF_BUCKETS],
+              &Entry->BucketLink
+              );
+
+            InsertHeadList (&mFileCacheLru, &Entry->LruLink);
+
+            mFileCacheSize += AllocationSize;
+
+            Status = EFI_SUCCESS;
+          }
+        }
+      }
+
+      EfiRestoreTPL (OldTpl);
+    }
+  }
+
+  return Status;
+}
+
+// FileCacheRelease
+STATIC
+VOID
+EFIAPI
+FileCacheRelease (
+  IN MISC_FILE_CACHE_PROTOCOL  *This,
+  IN CONST VOID                *Buffer
+  )
+{
+  FILE_CACHE_ENTRY *Entry;
+  EFI_TPL          OldTpl;
+
+  ASSERT (Buffer != NULL);
+
+  Entry = FILE_CACHE_ENTRY_FROM_BUFFER (Buffer);
+
+  ASSERT (Entry->Signature == FILE_CACHE_ENTRY_SIGNATURE);
+  ASSERT (Entry->References > 0);
+
+  OldTpl = EfiRaiseTPL (TPL_NOTIFY);
+
+  --Entry->References;
+
+  EfiRestoreTPL (OldTpl);
+}
+
+// mFileCache
+STATIC MISC_FILE_CACHE_PROTOCOL mFileCache = {
+  MISC_FILE_CACHE_PROTOCOL_REVISION,
+  FileCacheLookup,
+  FileCacheInsert,
+  FileCacheRelease
+};
+
+// FileCacheEntryPoint
+/** Installs the file cache protocol.
+
+  @param[in] ImageHandle  The firmware allocated handle for the EFI image.
+  @param[in] SystemTable  A pointer to the EFI System Table.
+
+  @return  Returned is the status of the protocol installation.
+**/
+EFI_STATUS
+EFIAPI
+FileCacheEntryPoint (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_HANDLE Handle;
+  UINTN      Index;
+
+  for (Index = 0; Index < ARRAY_SIZE (mFileCacheBuckets); ++Index) {
+    InitializeListHead (&mFileCacheBuckets[Index]);
+  }
+
+  InitializeListHead (&mFileCacheLru);
+
+  Handle = NULL;
+
+  return EfiInstallProtocolInterface (
+           &Handle,
+           &gMiscFileCacheProtocolGuid,
+           EFI_NATIVE_INTERFACE,
+           (VOID *)&mFileCache
+           );
+}
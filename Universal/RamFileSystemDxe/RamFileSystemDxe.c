@@ -0,0 +1,303 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Guid/FileInfo.h>
+#include <Guid/MiscRamFileSystem.h>
+
+#include <Protocol/DevicePath.h>
+#include <Protocol/LoadedImage.h>
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/EfiBootServicesLib.h>
+#include <Library/FileHandleLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscFileLib.h>
+#include <Library/PcdLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#include "RamFileSystemInternal.h"
+
+// RAM_FS_DEVICE_PATH
+#pragma pack (1)
+typedef struct {
+  VENDOR_DEVICE_PATH       Vendor;
+  EFI_DEVICE_PATH_PROTOCOL End;
+} RAM_FS_DEVICE_PATH;
+#pragma pack ()
+
+// RAM_FS_LOAD_CONTEXT
+typedef struct {
+  RAM_FS_VOLUME   *Volume;
+  EFI_FILE_HANDLE DirHandle;
+} RAM_FS_LOAD_CONTEXT;
+
+// mRamFsDevicePath
+STATIC RAM_FS_DEVICE_PATH mRamFsDevicePath = {
+  {
+    {
+      HARDWARE_DEVICE_PATH,
+      HW_VENDOR_DP,
+      {
+        (UINT8)sizeof (VENDOR_DEVICE_PATH),
+        (UINT8)(sizeof (VENDOR_DEVICE_PATH) >> 8)
+      }
+    },
+    MISC_RAM_FILE_SYSTEM_GUID
+  },
+  {
+    END_DEVICE_PATH_TYPE,
+    END_ENTIRE_DEVICE_PATH_SUBTYPE,
+    {
+      (UINT8)sizeof (EFI_DEVICE_PATH_PROTOCOL),
+      (UINT8)(sizeof (EFI_DEVICE_PATH_PROTOCOL) >> 8)
+    }
+  }
+};
+
+// RamFsOpenVolume
+STATIC
+EFI_STATUS
+EFIAPI
+RamFsOpenVolume (
+  IN  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *This,
+  OUT EFI_FILE_PROTOCOL                **Root
+  )
+{
+  return RamFsOpenFile (
+           RAM_FS_VOLUME_FROM_FILE_SYSTEM (This),
+           RAM_FS_ROOT_NODE,
+           Root
+           );
+}
+
+// InternalLoadWalkedFile
+/** Loads a file met while walking the source directory into the volume.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+InternalLoadWalkedFile (
+  IN VOID                 *Context,
+  IN CONST CHAR16         *Path,
+  IN CONST EFI_FILE_INFO  *FileInfo,
+  IN UINTN                Depth
+  )
+{
+  EFI_STATUS          Status;
+
+  RAM_FS_LOAD_CONTEXT *LoadContext;
+  UINTN               DataSize;
+  VOID                *Data;
+
+  LoadContext = (RAM_FS_LOAD_CONTEXT *)Context;
+  Status      = EFI_SUCCESS;
+
+  if ((FileInfo->Attribute & EFI_FILE_DIRECTORY) == 0) {
+    Status = LoadFile (
+               LoadContext->DirHandle,
+               (CHAR16 *)Path,
+               &DataSize,
+               &Data
+               );
+
+    if (!EFI_ERROR (Status)) {
+      // The data is owned by the volume from here on, unless it is rejected.
+      Status = RamFsAddFile (LoadContext->Volume, Path, Data, DataSize);
+
+      if (EFI_ERROR (Status)) {
+        FreePool (Data);
+
+        // The first copy of a file is kept.
+        if (Status == EFI_ALREADY_STARTED) {
+          Status = EFI_SUCCESS;
+        }
+      }
+    }
+  }
+
+  return Status;
+}
+
+// InternalLoadSource
+/** Loads the source configured by PcdRamFileSystemPath into a volume.
+
+  A directory is loaded recursively, any other file is opened as a bundle
+  whose entries are referenced in place.
+
+  @param[in] Root    The root of the file system holding the source.
+  @param[in] Volume  The volume to populate.  On error, it may have been
+                     populated partially and is to be destroyed.
+
+  @return  Returned is the status of the load.
+**/
+STATIC
+EFI_STATUS
+InternalLoadSource (
+  IN EFI_FILE_HANDLE  Root,
+  IN RAM_FS_VOLUME    *Volume
+  )
+{
+  EFI_STATUS             Status;
+
+  CHAR16                 *SourcePath;
+  EFI_FILE_HANDLE        SourceHandle;
+  EFI_FILE_INFO          *FileInfo;
+  RAM_FS_LOAD_CONTEXT    LoadContext;
+  MISC_FILE_WALK_OPTIONS Options;
+  MISC_FILE_BUNDLE       *Bundle;
+  UINTN                  NumberOfFiles;
+  UINTN                  Index;
+  CONST CHAR16           *FileName;
+  UINTN                  DataSize;
+  CONST VOID             *Data;
+
+  SourcePath = (CHAR16 *)PcdGetPtr (PcdRamFileSystemPath);
+  Status     = Root->Open (
+                       Root,
+                       &SourceHandle,
+                       SourcePath,
+                       EFI_FILE_MODE_READ,
+                       0
+                       );
+
+  if (!EFI_ERROR (Status)) {
+    FileInfo = FileHandleGetInfo (SourceHandle);
+    Status   = EFI_OUT_OF_RESOURCES;
+
+    if (FileInfo != NULL) {
+      if ((FileInfo->Attribute & EFI_FILE_DIRECTORY) != 0) {
+        LoadContext.Volume    = Volume;
+        LoadContext.DirHandle = SourceHandle;
+
+        Options.Order    = MiscFileWalkDirectoryOrder;
+        Options.MaxDepth = MISC_FILE_WALK_UNLIMITED_DEPTH;
+        Options.Filter   = NULL;
+        Options.Prune    = NULL;
+        Options.Visit    = InternalLoadWalkedFile;
+        Options.Context  = (VOID *)&LoadContext;
+
+        Status = MiscWalkDirectory (SourceHandle, &Options);
+      } else {
+        Status = MiscOpenFileBundle (Root, SourcePath, &Bundle);
+
+        if (!EFI_ERROR (Status)) {
+          // The bundle is kept open as the volume references its data.
+          Volume->Bundle = Bundle;
+          NumberOfFiles  = MiscGetBundledFileCount (Bundle);
+
+          for (Index = 0; Index < NumberOfFiles; ++Index) {
+            MiscGetBundledFile (Bundle, Index, &FileName, &DataSize, &Data);
+
+            Status = RamFsAddFile (Volume, FileName, Data, DataSize);
+
+            if (Status == EFI_ALREADY_STARTED) {
+              Status = EFI_SUCCESS;
+            } else if (EFI_ERROR (Status)) {
+              break;
+            }
+          }
+        }
+      }
+
+      FreePool ((VOID *)FileInfo);
+    }
+
+    SourceHandle->Close (SourceHandle);
+  }
+
+  return Status;
+}
+
+// RamFileSystemEntryPoint
+/** Loads the configured source into memory and installs a read-only
+    EFI_SIMPLE_FILE_SYSTEM_PROTOCOL serving it.
+
+  @param[in] ImageHandle  The firmware allocated handle for the EFI image.
+  @param[in] SystemTable  A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS  The file system has been installed.
+  @retval other        The source could not be loaded.
+**/
+EFI_STATUS
+EFIAPI
+RamFileSystemEntryPoint (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS                      Status;
+
+  EFI_LOADED_IMAGE_PROTOCOL       *LoadedImage;
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL *FileSystem;
+  EFI_FILE_HANDLE                 Root;
+  RAM_FS_VOLUME                   *Volume;
+  EFI_HANDLE                      Handle;
+
+  Status = EfiHandleProtocol (
+             ImageHandle,
+             &gEfiLoadedImageProtocolGuid,
+             (VOID **)&LoadedImage
+             );
+
+  if (!EFI_ERROR (Status)) {
+    Status = EfiHandleProtocol (
+               LoadedImage->DeviceHandle,
+               &gEfiSimpleFileSystemProtocolGuid,
+               (VOID **)&FileSystem
+               );
+
+    if (!EFI_ERROR (Status)) {
+      Status = FileSystem->OpenVolume (FileSystem, &Root);
+
+      if (!EFI_ERROR (Status)) {
+        Volume = RamFsCreateVolume ();
+        Status = EFI_OUT_OF_RESOURCES;
+
+        if (Volume != NULL) {
+          Volume->FileSystem.Revision   =
+            EFI_SIMPLE_FILE_SYSTEM_PROTOCOL_REVISION;
+          Volume->FileSystem.OpenVolume = RamFsOpenVolume;
+
+          Status = InternalLoadSource (Root, Volume);
+
+          if (!EFI_ERROR (Status)) {
+            Handle = NULL;
+            Status = EfiInstallMultipleProtocolInterfaces (
+                       &Handle,
+                       &gEfiDevicePathProtocolGuid,
+                       (VOID *)&mRamFsDevicePath,
+                       &gEfiSimpleFileSystemProtocolGuid,
+                       (VOID *)&Volume->FileSystem,
+                       NULL
+                       );
+          }
+
+          if (EFI_ERROR (Status)) {
+            RamFsDestroyVolume (Volume);
+          }
+        }
+
+        Root->Close (Root);
+      }
+    }
+  }
+
+  return Status;
+}
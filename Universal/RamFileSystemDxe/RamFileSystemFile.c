@@ -0,0 +1,588 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Guid/FileInfo.h>
+#include <Guid/FileSystemInfo.h>
+#include <Guid/FileSystemVolumeLabelInfo.h>
+
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/EfiBootServicesLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscFileLib.h>
+
+#include "RamFileSystemInternal.h"
+
+// RAM_FS_VOLUME_LABEL
+#define RAM_FS_VOLUME_LABEL  L"RamFs"
+
+// RAM_FS_BLOCK_SIZE
+#define RAM_FS_BLOCK_SIZE  1
+
+// InternalFillFileInfo
+/** Describes a node as EFI_FILE_INFO.
+
+  @param[in]      Volume      The volume holding Node.
+  @param[in]      Node        The node to describe.
+  @param[in, out] BufferSize  On input, the size of Buffer.  On output, the
+                              size of the information.
+  @param[out]     Buffer      Receives the information.
+
+  @retval EFI_SUCCESS           The information has been returned.
+  @retval EFI_BUFFER_TOO_SMALL  Buffer is too small.
+**/
+STATIC
+EFI_STATUS
+InternalFillFileInfo (
+  IN     CONST RAM_FS_VOLUME  *Volume,
+  IN     UINT32               Node,
+  IN OUT UINTN                *BufferSize,
+  OUT    VOID                 *Buffer
+  )
+{
+  EFI_STATUS        Status;
+
+  CONST RAM_FS_NODE *FsNode;
+  EFI_FILE_INFO     *FileInfo;
+  UINTN             Size;
+
+  FsNode = &Volume->Nodes[Node];
+  Size   = (SIZE_OF_EFI_FILE_INFO
+              + ((FsNode->NameLength + 1) * sizeof (CHAR16)));
+
+  Status = EFI_BUFFER_TOO_SMALL;
+
+  if (*BufferSize >= Size) {
+    FileInfo = (EFI_FILE_INFO *)Buffer;
+
+    ZeroMem ((VOID *)FileInfo, SIZE_OF_EFI_FILE_INFO);
+
+    FileInfo->Size         = Size;
+    FileInfo->FileSize     = FsNode->DataSize;
+    FileInfo->PhysicalSize = FsNode->DataSize;
+    FileInfo->Attribute    = (EFI_FILE_READ_ONLY
+                               | (FsNode->IsDirectory
+                                   ? EFI_FILE_DIRECTORY
+                                   : 0));
+
+    CopyMem (
+      (VOID *)FileInfo->FileName,
+      (VOID *)FsNode->Name,
+      ((FsNode->NameLength + 1) * sizeof (CHAR16))
+      );
+
+    Status = EFI_SUCCESS;
+  }
+
+  *BufferSize = Size;
+
+  return Status;
+}
+
+// InternalResolvePath
+/** Resolves a path relative to a node.
+
+  Leading separators start at the root, '.' and '..' components are honoured.
+
+  @param[in] Volume    The volume to search.
+  @param[in] Node      The node to start at.
+  @param[in] FileName  The path to resolve.
+
+  @return  Returned is the node FileName refers to or RAM_FS_NO_NODE.
+**/
+STATIC
+UINT32
+InternalResolvePath (
+  IN CONST RAM_FS_VOLUME  *Volume,
+  IN UINT32               Node,
+  IN CONST CHAR16         *FileName
+  )
+{
+  UINTN Length;
+
+  if (*FileName == FILE_PATH_SEPARATOR) {
+    Node = RAM_FS_ROOT_NODE;
+  }
+
+  while ((*FileName != L'\0') && (Node != RAM_FS_NO_NODE)) {
+    for (Length = 0; FileName[Length] != L'\0'; ++Length) {
+      if (FileName[Length] == FILE_PATH_SEPARATOR) {
+        break;
+      }
+    }
+
+    if ((Length == 0) || ((Length == 1) && (FileName[0] == L'.'))) {
+      // Empty and '.' components stay at the current node.
+    } else if (!Volume->Nodes[Node].IsDirectory) {
+      Node = RAM_FS_NO_NODE;
+    } else if ((Length == 2)
+            && (FileName[0] == L'.')
+            && (FileName[1] == L'.')) {
+      Node = Volume->Nodes[Node].Parent;
+    } else {
+      Node = RamFsLookupChild (Volume, Node, FileName, Length);
+    }
+
+    FileName += Length;
+
+    if (*FileName == FILE_PATH_SEPARATOR) {
+      ++FileName;
+    }
+  }
+
+  return Node;
+}
+
+// RamFsFileOpen
+STATIC
+EFI_STATUS
+EFIAPI
+RamFsFileOpen (
+  IN  EFI_FILE_PROTOCOL  *This,
+  OUT EFI_FILE_PROTOCOL  **NewHandle,
+  IN  CHAR16             *FileName,
+  IN  UINT64             OpenMode,
+  IN  UINT64             Attributes
+  )
+{
+  EFI_STATUS  Status;
+
+  RAM_FS_FILE *File;
+  UINT32      Node;
+
+  if ((This == NULL) || (NewHandle == NULL) || (FileName == NULL)) {
+    Status = EFI_INVALID_PARAMETER;
+  } else if (OpenMode != EFI_FILE_MODE_READ) {
+    Status = EFI_WRITE_PROTECTED;
+  } else {
+    File   = RAM_FS_FILE_FROM_PROTOCOL (This);
+    Node   = InternalResolvePath (File->Volume, File->Node, FileName);
+    Status = EFI_NOT_FOUND;
+
+    if (Node != RAM_FS_NO_NODE) {
+      Status = RamFsOpenFile (File->Volume, Node, NewHandle);
+    }
+  }
+
+  return Status;
+}
+
+// RamFsFileClose
+STATIC
+EFI_STATUS
+EFIAPI
+RamFsFileClose (
+  IN EFI_FILE_PROTOCOL  *This
+  )
+{
+  RAM_FS_FILE *File;
+
+  File = RAM_FS_FILE_FROM_PROTOCOL (This);
+
+  FreePool ((VOID *)File);
+
+  return EFI_SUCCESS;
+}
+
+// RamFsFileDelete
+STATIC
+EFI_STATUS
+EFIAPI
+RamFsFileDelete (
+  IN EFI_FILE_PROTOCOL  *This
+  )
+{
+  RamFsFileClose (This);
+
+  return EFI_WARN_DELETE_FAILURE;
+}
+
+// RamFsFileRead
+STATIC
+EFI_STATUS
+EFIAPI
+RamFsFileRead (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN OUT UINTN              *BufferSize,
+  OUT    VOID               *Buffer
+  )
+{
+  EFI_STATUS        Status;
+
+  RAM_FS_FILE       *File;
+  CONST RAM_FS_NODE *FsNode;
+  UINTN             ReadSize;
+
+  File   = RAM_FS_FILE_FROM_PROTOCOL (This);
+  FsNode = &File->Volume->Nodes[File->Node];
+  Status = EFI_SUCCESS;
+
+  if (FsNode->IsDirectory) {
+    // Position holds the next child to return.
+    if (File->Position == RAM_FS_NO_NODE) {
+      *BufferSize = 0;
+    } else {
+      Status = InternalFillFileInfo (
+                 File->Volume,
+                 (UINT32)File->Position,
+                 BufferSize,
+                 Buffer
+                 );
+
+      if (!EFI_ERROR (Status)) {
+        File->Position = File->Volume->Nodes[File->Position].NextSibling;
+      }
+    }
+  } else if (File->Position > FsNode->DataSize) {
+    Status = EFI_DEVICE_ERROR;
+  } else {
+    ReadSize = MIN (*BufferSize, (UINTN)(FsNode->DataSize - File->Position));
+
+    CopyMem (
+      Buffer,
+      (VOID *)((CONST UINT8 *)FsNode->Data + File->Position),
+      ReadSize
+      );
+
+    File->Position += ReadSize;
+    *BufferSize     = ReadSize;
+  }
+
+  return Status;
+}
+
+// RamFsFileWrite
+STATIC
+EFI_STATUS
+EFIAPI
+RamFsFileWrite (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN OUT UINTN              *BufferSize,
+  IN     VOID               *Buffer
+  )
+{
+  return EFI_WRITE_PROTECTED;
+}
+
+// RamFsFileGetPosition
+STATIC
+EFI_STATUS
+EFIAPI
+RamFsFileGetPosition (
+  IN  EFI_FILE_PROTOCOL  *This,
+  OUT UINT64             *Position
+  )
+{
+  EFI_STATUS  Status;
+
+  RAM_FS_FILE *File;
+
+  File   = RAM_FS_FILE_FROM_PROTOCOL (This);
+  Status = EFI_UNSUPPORTED;
+
+  if (!File->Volume->Nodes[File->Node].IsDirectory) {
+    *Position = File->Position;
+
+    Status = EFI_SUCCESS;
+  }
+
+  return Status;
+}
+
+// RamFsFileSetPosition
+STATIC
+EFI_STATUS
+EFIAPI
+RamFsFileSetPosition (
+  IN EFI_FILE_PROTOCOL  *This,
+  IN UINT64             Position
+  )
+{
+  EFI_STATUS        Status;
+
+  RAM_FS_FILE       *File;
+  CONST RAM_FS_NODE *FsNode;
+
+  File   = RAM_FS_FILE_FROM_PROTOCOL (This);
+  FsNode = &File->Volume->Nodes[File->Node];
+  Status = EFI_SUCCESS;
+
+  if (FsNode->IsDirectory) {
+    Status = EFI_UNSUPPORTED;
+
+    if (Position == 0) {
+      File->Position = FsNode->FirstChild;
+
+      Status = EFI_SUCCESS;
+    }
+  } else if (Position == MAX_UINT64) {
+    File->Position = FsNode->DataSize;
+  } else {
+    File->Position = Position;
+  }
+
+  return Status;
+}
+
+// RamFsFileGetInfo
+STATIC
+EFI_STATUS
+EFIAPI
+RamFsFileGetInfo (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN     EFI_GUID           *InformationType,
+  IN OUT UINTN              *BufferSize,
+  OUT    VOID               *Buffer
+  )
+{
+  EFI_STATUS           Status;
+
+  RAM_FS_FILE          *File;
+  EFI_FILE_SYSTEM_INFO *FileSystemInfo;
+  UINTN                Size;
+
+  ASSERT (This != NULL);
+  ASSERT (InformationType != NULL);
+  ASSERT (BufferSize != NULL);
+  ASSERT ((Buffer != NULL) || (*BufferSize == 0));
+
+  File   = RAM_FS_FILE_FROM_PROTOCOL (This);
+  Status = EFI_UNSUPPORTED;
+
+  if (CompareGuid (InformationType, &gEfiFileInfoGuid)) {
+    Status = InternalFillFileInfo (
+               File->Volume,
+               File->Node,
+               BufferSize,
+               Buffer
+               );
+  } else if (CompareGuid (InformationType, &gEfiFileSystemInfoGuid)) {
+    Size   = (SIZE_OF_EFI_FILE_SYSTEM_INFO + sizeof (RAM_FS_VOLUME_LABEL));
+    Status = EFI_BUFFER_TOO_SMALL;
+
+    if (*BufferSize >= Size) {
+      FileSystemInfo = (EFI_FILE_SYSTEM_INFO *)Buffer;
+
+      FileSystemInfo->Size       = Size;
+      FileSystemInfo->ReadOnly   = TRUE;
+      FileSystemInfo->VolumeSize = File->Volume->VolumeSize;
+      FileSystemInfo->FreeSpace  = 0;
+      FileSystemInfo->BlockSize  = RAM_FS_BLOCK_SIZE;
+
+      CopyMem (
+        (VOID *)FileSystemInfo->VolumeLabel,
+        (VOID *)RAM_FS_VOLUME_LABEL,
+        sizeof (RAM_FS_VOLUME_LABEL)
+        );
+
+      Status = EFI_SUCCESS;
+    }
+
+    *BufferSize = Size;
+  } else if (CompareGuid (
+               InformationType,
+               &gEfiFileSystemVolumeLabelInfoIdGuid
+               )) {
+    Size   = sizeof (RAM_FS_VOLUME_LABEL);
+    Status = EFI_BUFFER_TOO_SMALL;
+
+    if (*BufferSize >= Size) {
+      CopyMem (Buffer, (VOID *)RAM_FS_VOLUME_LABEL, Size);
+
+      Status = EFI_SUCCESS;
+    }
+
+    *BufferSize = Size;
+  }
+
+  return Status;
+}
+
+// RamFsFileSetInfo
+STATIC
+EFI_STATUS
+EFIAPI
+RamFsFileSetInfo (
+  IN EFI_FILE_PROTOCOL  *This,
+  IN EFI_GUID           *InformationType,
+  IN UINTN              BufferSize,
+  IN VOID               *Buffer
+  )
+{
+  return EFI_WRITE_PROTECTED;
+}
+
+// RamFsFileFlush
+STATIC
+EFI_STATUS
+EFIAPI
+RamFsFileFlush (
+  IN EFI_FILE_PROTOCOL  *This
+  )
+{
+  return EFI_SUCCESS;
+}
+
+// InternalCompleteToken
+/** Completes an asynchronous request, which has been served synchronously.
+**/
+STATIC
+EFI_STATUS
+InternalCompleteToken (
+  IN OUT EFI_FILE_IO_TOKEN  *Token,
+  IN     EFI_STATUS         Status
+  )
+{
+  if (Token->Event != NULL) {
+    Token->Status = Status;
+    Status        = EfiSignalEvent (Token->Event);
+  }
+
+  return Status;
+}
+
+// RamFsFileOpenEx
+STATIC
+EFI_STATUS
+EFIAPI
+RamFsFileOpenEx (
+  IN     EFI_FILE_PROTOCOL  *This,
+  OUT    EFI_FILE_PROTOCOL  **NewHandle,
+  IN     CHAR16             *FileName,
+  IN     UINT64             OpenMode,
+  IN     UINT64             Attributes,
+  IN OUT EFI_FILE_IO_TOKEN  *Token
+  )
+{
+  EFI_STATUS Status;
+
+  Status = RamFsFileOpen (This, NewHandle, FileName, OpenMode, Attributes);
+
+  return InternalCompleteToken (Token, Status);
+}
+
+// RamFsFileReadEx
+STATIC
+EFI_STATUS
+EFIAPI
+RamFsFileReadEx (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN OUT EFI_FILE_IO_TOKEN  *Token
+  )
+{
+  EFI_STATUS Status;
+
+  Status = RamFsFileRead (This, &Token->BufferSize, Token->Buffer);
+
+  return InternalCompleteToken (Token, Status);
+}
+
+// RamFsFileWriteEx
+STATIC
+EFI_STATUS
+EFIAPI
+RamFsFileWriteEx (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN OUT EFI_FILE_IO_TOKEN  *Token
+  )
+{
+  return EFI_WRITE_PROTECTED;
+}
+
+// RamFsFileFlushEx
+STATIC
+EFI_STATUS
+EFIAPI
+RamFsFileFlushEx (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN OUT EFI_FILE_IO_TOKEN  *Token
+  )
+{
+  return InternalCompleteToken (Token, EFI_SUCCESS);
+}
+
+// mRamFsFileTemplate
+STATIC CONST EFI_FILE_PROTOCOL mRamFsFileTemplate = {
+  EFI_FILE_PROTOCOL_REVISION2,
+  RamFsFileOpen,
+  RamFsFileClose,
+  RamFsFileDelete,
+  RamFsFileRead,
+  RamFsFileWrite,
+  RamFsFileGetPosition,
+  RamFsFileSetPosition,
+  RamFsFileGetInfo,
+  RamFsFileSetInfo,
+  RamFsFileFlush,
+  RamFsFileOpenEx,
+  RamFsFileReadEx,
+  RamFsFileWriteEx,
+  RamFsFileFlushEx
+};
+
+// RamFsOpenFile
+/** Creates a file handle for a node.
+
+  @param[in]  Volume  The volume holding Node.
+  @param[in]  Node    The node to open.
+  @param[out] File    The opened file.
+
+  @retval EFI_SUCCESS           The file has been opened.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+**/
+EFI_STATUS
+RamFsOpenFile (
+  IN  RAM_FS_VOLUME      *Volume,
+  IN  UINT32             Node,
+  OUT EFI_FILE_PROTOCOL  **File
+  )
+{
+  EFI_STATUS  Status;
+
+  RAM_FS_FILE *NewFile;
+
+  ASSERT (Volume != NULL);
+  ASSERT (Node < Volume->NumberOfNodes);
+  ASSERT (File != NULL);
+
+  NewFile = AllocatePool (sizeof (*NewFile));
+  Status  = EFI_OUT_OF_RESOURCES;
+
+  if (NewFile != NULL) {
+    NewFile->Signature = RAM_FS_FILE_SIGNATURE;
+    NewFile->Volume    = Volume;
+    NewFile->Node      = Node;
+    NewFile->Position  = (Volume->Nodes[Node].IsDirectory
+                           ? Volume->Nodes[Node].FirstChild
+                           : 0);
+
+    CopyMem (
+      (VOID *)&NewFile->Protocol,
+      (VOID *)&mRamFsFileTemplate,
+      sizeof (NewFile->Protocol)
+      );
+
+    *File  = &NewFile->Protocol;
+    Status = EFI_SUCCESS;
+  }
+
+  return Status;
+}
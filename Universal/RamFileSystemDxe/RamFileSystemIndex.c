@@ -0,0 +1,442 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#include <Uefi.h>
+
+#include <Guid/FileInfo.h>
+
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MiscFileLib.h>
+
+#include "RamFileSystemInternal.h"
+
+// RAM_FS_INITIAL_NODES
+#define RAM_FS_INITIAL_NODES  32
+
+// InternalHashChild
+/** Hashes a parent index and a child name case-insensitively with FNV-1a.
+**/
+STATIC
+UINT32
+InternalHashChild (
+  IN UINT32        Parent,
+  IN CONST CHAR16  *Name,
+  IN UINTN         NameLength
+  )
+{
+  UINT32 Hash;
+  UINTN  Index;
+  CHAR16 Char;
+
+  Hash = (0x811C9DC5U ^ Parent);
+
+  for (Index = 0; Index < NameLength; ++Index) {
+    Char = CharToUpper (Name[Index]);
+    Hash = ((Hash ^ (UINT8)Char) * 0x01000193U);
+    Hash = ((Hash ^ (UINT8)(Char >> 8)) * 0x01000193U);
+  }
+
+  return Hash;
+}
+
+// InternalIndexNode
+/** Inserts a node into the path index, which must not be full.
+**/
+STATIC
+VOID
+InternalIndexNode (
+  IN OUT RAM_FS_VOLUME  *Volume,
+  IN     UINT32         Node
+  )
+{
+  UINTN Index;
+
+  Index = (InternalHashChild (
+             Volume->Nodes[Node].Parent,
+             Volume->Nodes[Node].Name,
+             Volume->Nodes[Node].NameLength
+             ) & Volume->BucketMask);
+
+  while (Volume->Buckets[Index] != RAM_FS_NO_NODE) {
+    Index = ((Index + 1) & Volume->BucketMask);
+  }
+
+  Volume->Buckets[Index] = Node;
+}
+
+// InternalGrowIndex
+/** Doubles the path index and rehashes all nodes but the root.
+
+  @retval EFI_SUCCESS           The index has been grown.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+**/
+STATIC
+EFI_STATUS
+InternalGrowIndex (
+  IN OUT RAM_FS_VOLUME  *Volume
+  )
+{
+  EFI_STATUS Status;
+
+  UINT32     *Buckets;
+  UINTN      NumberOfBuckets;
+  UINT32     Node;
+
+  NumberOfBuckets = ((Volume->BucketMask + 1) * 2);
+  Buckets         = AllocatePool (NumberOfBuckets * sizeof (*Buckets));
+
+  Status = EFI_OUT_OF_RESOURCES;
+
+  if (Buckets != NULL) {
+    SetMem32 (
+      (VOID *)Buckets,
+      (NumberOfBuckets * sizeof (*Buckets)),
+      RAM_FS_NO_NODE
+      );
+
+    if (Volume->Buckets != NULL) {
+      FreePool ((VOID *)Volume->Buckets);
+    }
+
+    Volume->Buckets    = Buckets;
+    Volume->BucketMask = (NumberOfBuckets - 1);
+
+    for (Node = (RAM_FS_ROOT_NODE + 1); Node < Volume->NumberOfNodes; ++Node) {
+      InternalIndexNode (Volume, Node);
+    }
+
+    Status = EFI_SUCCESS;
+  }
+
+  return Status;
+}
+
+// RamFsLookupChild
+/** Looks up a child of a directory by name, ignoring the case.
+
+  @param[in] Volume      The volume to search.
+  @param[in] Parent      The directory to search.
+  @param[in] Name        The name of the child, need not be NUL-terminated.
+  @param[in] NameLength  The length, in characters, of Name.
+
+  @return  Returned is the child's node or RAM_FS_NO_NODE.
+**/
+UINT32
+RamFsLookupChild (
+  IN CONST RAM_FS_VOLUME  *Volume,
+  IN UINT32               Parent,
+  IN CONST CHAR16         *Name,
+  IN UINTN                NameLength
+  )
+{
+  UINTN             Index;
+  UINT32            Node;
+  CONST RAM_FS_NODE *Candidate;
+
+  ASSERT (Volume != NULL);
+  ASSERT (Name != NULL);
+
+  Index = (InternalHashChild (Parent, Name, NameLength) & Volume->BucketMask);
+
+  while (TRUE) {
+    Node = Volume->Buckets[Index];
+
+    if (Node == RAM_FS_NO_NODE) {
+      break;
+    }
+
+    Candidate = &Volume->Nodes[Node];
+
+    if ((Candidate->Parent == Parent)
+     && (Candidate->NameLength == NameLength)
+     && (MiscFileStrniCmp (Candidate->Name, Name, NameLength) == 0)) {
+      break;
+    }
+
+    Index = ((Index + 1) & Volume->BucketMask);
+  }
+
+  return Node;
+}
+
+// InternalAddNode
+/** Adds a node as the last child of a directory.
+
+  @param[in, out] Volume       The volume to add the node to.
+  @param[in]      Parent       The directory to add the node to.
+  @param[in]      Name         The name of the node.
+  @param[in]      NameLength   The length, in characters, of Name.
+  @param[in]      IsDirectory  Whether the node is a directory.
+  @param[out]     Node         The added node.
+
+  @retval EFI_SUCCESS           The node has been added.
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+**/
+STATIC
+EFI_STATUS
+InternalAddNode (
+  IN OUT RAM_FS_VOLUME  *Volume,
+  IN     UINT32         Parent,
+  IN     CONST CHAR16   *Name,
+  IN     UINTN          NameLength,
+  IN     BOOLEAN        IsDirectory,
+  OUT    UINT32         *Node
+  )
+{
+  EFI_STATUS  Status;
+
+  RAM_FS_NODE *Nodes;
+  RAM_FS_NODE *NewNode;
+  CHAR16      *NodeName;
+
+  Status = EFI_SUCCESS;
+
+  if ((Volume->NumberOfNodes * 2) >= Volume->BucketMask) {
+    Status = InternalGrowIndex (Volume);
+  }
+
+  if (!EFI_ERROR (Status)
+   && (Volume->NumberOfNodes == Volume->NodesCapacity)) {
+    Nodes = ReallocatePool (
+              (Volume->NodesCapacity * sizeof (*Nodes)),
+              (Volume->NodesCapacity * 2 * sizeof (*Nodes)),
+              (VOID *)Volume->Nodes
+              );
+
+    Status = EFI_OUT_OF_RESOURCES;
+
+    if (Nodes != NULL) {
+      Volume->Nodes          = Nodes;
+      Volume->NodesCapacity *= 2;
+
+      Status = EFI_SUCCESS;
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    NodeName = AllocatePool ((NameLength + 1) * sizeof (*NodeName));
+    Status   = EFI_OUT_OF_RESOURCES;
+
+    if (NodeName != NULL) {
+      CopyMem (
+        (VOID *)NodeName,
+        (VOID *)Name,
+        (NameLength * sizeof (*NodeName))
+        );
+
+      NodeName[NameLength] = L'\0';
+
+      *Node   = (UINT32)Volume->NumberOfNodes;
+      NewNode = &Volume->Nodes[*Node];
+
+      ZeroMem ((VOID *)NewNode, sizeof (*NewNode));
+
+      NewNode->Name        = NodeName;
+      NewNode->NameLength  = NameLength;
+      NewNode->Parent      = Parent;
+      NewNode->FirstChild  = RAM_FS_NO_NODE;
+      NewNode->LastChild   = RAM_FS_NO_NODE;
+      NewNode->NextSibling = RAM_FS_NO_NODE;
+      NewNode->IsDirectory = IsDirectory;
+
+      if (Volume->Nodes[Parent].LastChild == RAM_FS_NO_NODE) {
+        Volume->Nodes[Parent].FirstChild = *Node;
+      } else {
+        Volume->Nodes[Volume->Nodes[Parent].LastChild].NextSibling = *Node;
+      }
+
+      Volume->Nodes[Parent].LastChild = *Node;
+
+      ++Volume->NumberOfNodes;
+
+      InternalIndexNode (Volume, *Node);
+
+      Status = EFI_SUCCESS;
+    }
+  }
+
+  return Status;
+}
+
+// RamFsAddFile
+/** Adds a file to a volume, creating all missing parent directories.
+
+  The data is referenced, not copied.  If the file exists already, the first
+  one is kept and the caller retains ownership of Data.
+
+  @param[in, out] Volume    The volume to add the file to.
+  @param[in]      Path      The path of the file relative to the root.
+  @param[in]      Data      The file's data.
+  @param[in]      DataSize  The size, in bytes, of Data.
+
+  @retval EFI_SUCCESS            The file has been added.
+  @retval EFI_ALREADY_STARTED    The file exists already.
+  @retval EFI_INVALID_PARAMETER  Path is empty or a file is in its way.
+  @retval EFI_OUT_OF_RESOURCES   Memory allocation failed.
+**/
+EFI_STATUS
+RamFsAddFile (
+  IN OUT RAM_FS_VOLUME  *Volume,
+  IN     CONST CHAR16   *Path,
+  IN     CONST VOID     *Data,
+  IN     UINTN          DataSize
+  )
+{
+  EFI_STATUS Status;
+
+  UINT32     Parent;
+  UINT32     Node;
+  UINTN      Length;
+  BOOLEAN    IsLast;
+
+  ASSERT (Volume != NULL);
+  ASSERT (Path != NULL);
+  ASSERT ((Data != NULL) || (DataSize == 0));
+
+  Status = EFI_INVALID_PARAMETER;
+  Parent = RAM_FS_ROOT_NODE;
+
+  while (*Path != L'\0') {
+    for (Length = 0; Path[Length] != L'\0'; ++Length) {
+      if (Path[Length] == FILE_PATH_SEPARATOR) {
+        break;
+      }
+    }
+
+    if (Length == 0) {
+      ++Path;
+      continue;
+    }
+
+    IsLast = (BOOLEAN)(Path[Length] == L'\0');
+    Node   = RamFsLookupChild (Volume, Parent, Path, Length);
+
+    if (Node == RAM_FS_NO_NODE) {
+      Status = InternalAddNode (Volume, Parent, Path, Length, !IsLast, &Node);
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+
+      if (IsLast) {
+        Volume->Nodes[Node].Data     = Data;
+        Volume->Nodes[Node].DataSize = DataSize;
+        Volume->VolumeSize          += DataSize;
+      }
+    } else if (Volume->Nodes[Node].IsDirectory == IsLast) {
+      Status = EFI_INVALID_PARAMETER;
+      break;
+    } else if (IsLast) {
+      Status = EFI_ALREADY_STARTED;
+    } else {
+      Status = EFI_SUCCESS;
+    }
+
+    Parent = Node;
+    Path  += Length;
+  }
+
+  return Status;
+}
+
+// RamFsCreateVolume
+/** Creates an empty volume.
+
+  @return  Returned is the volume or NULL on allocation failure.
+**/
+RAM_FS_VOLUME *
+RamFsCreateVolume (
+  VOID
+  )
+{
+  RAM_FS_VOLUME *Volume;
+
+  Volume = AllocateZeroPool (sizeof (*Volume));
+
+  if (Volume != NULL) {
+    Volume->Signature     = RAM_FS_VOLUME_SIGNATURE;
+    Volume->NodesCapacity = RAM_FS_INITIAL_NODES;
+    Volume->Nodes         = AllocateZeroPool (
+                              RAM_FS_INITIAL_NODES * sizeof (*Volume->Nodes)
+                              );
+
+    Volume->BucketMask = ((RAM_FS_INITIAL_NODES / 2) - 1);
+
+    if ((Volume->Nodes == NULL) || EFI_ERROR (InternalGrowIndex (Volume))) {
+      if (Volume->Nodes != NULL) {
+        FreePool ((VOID *)Volume->Nodes);
+      }
+
+      FreePool ((VOID *)Volume);
+
+      Volume = NULL;
+    } else {
+      Volume->Nodes[RAM_FS_ROOT_NODE].Name        = L"";
+      Volume->Nodes[RAM_FS_ROOT_NODE].Parent      = RAM_FS_ROOT_NODE;
+      Volume->Nodes[RAM_FS_ROOT_NODE].FirstChild  = RAM_FS_NO_NODE;
+      Volume->Nodes[RAM_FS_ROOT_NODE].LastChild   = RAM_FS_NO_NODE;
+      Volume->Nodes[RAM_FS_ROOT_NODE].NextSibling = RAM_FS_NO_NODE;
+      Volume->Nodes[RAM_FS_ROOT_NODE].IsDirectory = TRUE;
+
+      Volume->NumberOfNodes = 1;
+    }
+  }
+
+  return Volume;
+}
+
+// RamFsDestroyVolume
+/** Frees a volume and all data it owns.
+
+  If the volume references a bundle, the bundle is closed, otherwise the data
+  of every file is freed.
+
+  @param[in] Volume  The volume to destroy.
+**/
+VOID
+RamFsDestroyVolume (
+  IN RAM_FS_VOLUME  *Volume
+  )
+{
+  UINTN       Index;
+  RAM_FS_NODE *Node;
+
+  ASSERT (Volume != NULL);
+
+  // The root's name is static.
+  for (Index = 1; Index < Volume->NumberOfNodes; ++Index) {
+    Node = &Volume->Nodes[Index];
+
+    FreePool ((VOID *)Node->Name);
+
+    if ((Volume->Bundle == NULL) && (Node->Data != NULL)) {
+      FreePool ((VOID *)Node->Data);
+    }
+  }
+
+  if (Volume->Bundle != NULL) {
+    MiscCloseFileBundle (Volume->Bundle);
+  }
+
+  FreePool ((VOID *)Volume->Buckets);
+  FreePool ((VOID *)Volume->Nodes);
+  FreePool ((VOID *)Volume);
+}
@@ -0,0 +1,113 @@
+/** @file
+  Copyright (C) 2017, CupertinoNet.  All rights reserved.<BR>
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+**/
+
+#ifndef RAM_FILE_SYSTEM_INTERNAL_H_
+#define RAM_FILE_SYSTEM_INTERNAL_H_
+
+// RAM_FS_NO_NODE
+#define RAM_FS_NO_NODE  MAX_UINT32
+
+// RAM_FS_ROOT_NODE
+#define RAM_FS_ROOT_NODE  0
+
+// RAM_FS_NODE
+typedef struct {
+  CONST CHAR16 *Name;        ///< NUL-terminated, empty for the root.
+  UINTN        NameLength;
+  UINT32       Parent;
+  UINT32       FirstChild;
+  UINT32       LastChild;
+  UINT32       NextSibling;
+  BOOLEAN      IsDirectory;
+  CONST VOID   *Data;
+  UINTN        DataSize;
+} RAM_FS_NODE;
+
+// RAM_FS_VOLUME_SIGNATURE
+#define RAM_FS_VOLUME_SIGNATURE  SIGNATURE_32 ('R', 'F', 'S', 'V')
+
+// RAM_FS_VOLUME
+typedef struct {
+  UINT32                          Signature;
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL FileSystem;
+  RAM_FS_NODE                     *Nodes;
+  UINTN                           NumberOfNodes;
+  UINTN                           NodesCapacity;
+  UINT32                          *Buckets;       ///< Node indices.
+  UINTN                           BucketMask;
+  UINT64                          VolumeSize;     ///< Sum of all file sizes.
+  MISC_FILE_BUNDLE                *Bundle;        ///< NULL if data is owned.
+} RAM_FS_VOLUME;
+
+// RAM_FS_VOLUME_FROM_FILE_SYSTEM
+#define RAM_FS_VOLUME_FROM_FILE_SYSTEM(This)  \
+  CR (This, RAM_FS_VOLUME, FileSystem, RAM_FS_VOLUME_SIGNATURE)
+
+// RAM_FS_FILE_SIGNATURE
+#define RAM_FS_FILE_SIGNATURE  SIGNATURE_32 ('R', 'F', 'S', 'F')
+
+// RAM_FS_FILE
+typedef struct {
+  UINT32            Signature;
+  EFI_FILE_PROTOCOL Protocol;
+  RAM_FS_VOLUME     *Volume;
+  UINT32            Node;
+  UINT64            Position;   ///< The file position or the next child.
+} RAM_FS_FILE;
+
+// RAM_FS_FILE_FROM_PROTOCOL
+#define RAM_FS_FILE_FROM_PROTOCOL(This)  \
+  CR (This, RAM_FS_FILE, Protocol, RAM_FS_FILE_SIGNATURE)
+
+// RamFsLookupChild
+UINT32
+RamFsLookupChild (
+  IN CONST RAM_FS_VOLUME  *Volume,
+  IN UINT32               Parent,
+  IN CONST CHAR16         *Name,
+  IN UINTN                NameLength
+  );
+
+// RamFsAddFile
+EFI_STATUS
+RamFsAddFile (
+  IN OUT RAM_FS_VOLUME  *Volume,
+  IN     CONST CHAR16   *Path,
+  IN     CONST VOID     *Data,
+  IN     UINTN          DataSize
+  );
+
+// RamFsCreateVolume
+RAM_FS_VOLUME *
+RamFsCreateVolume (
+  VOID
+  );
+
+// RamFsDestroyVolume
+VOID
+RamFsDestroyVolume (
+  IN RAM_FS_VOLUME  *Volume
+  );
+
+// RamFsOpenFile
+EFI_STATUS
+RamFsOpenFile (
+  IN  RAM_FS_VOLUME      *Volume,
+  IN  UINT32             Node,
+  OUT EFI_FILE_PROTOCOL  **File
+  );
+
+#endif // RAM_FILE_SYSTEM_INTERNAL_H_